@@ -0,0 +1,41 @@
+#include "bench_state_manager.h"
+
+void BenchFlightPhaseController::extract_state_data(const BenchState state, double& accel_x, double& accel_y,
+                                                    double& accel_z, double& altitude) const
+{
+  accel_x = state.accel_x;
+  accel_y = state.accel_y;
+  accel_z = state.accel_z;
+  altitude = state.altitude;
+}
+
+BenchStateManager::BenchStateManager() : ElijahStateFramework("Bench", BenchPersistentDataKey::LaunchKey,
+                                                              BenchFaultKey::MicroSD, 10)
+{
+  get_persistent_data_storage()->register_key(BenchPersistentDataKey::SeaLevelPressure, "Barometric pressure",
+                                              101325.0);
+  get_persistent_data_storage()->register_key(BenchPersistentDataKey::BenchCounter, "Benchmark counter", 0.0);
+  get_persistent_data_storage()->finish_registration();
+
+  register_fault(BenchFaultKey::BMP280, "BMP 280", CommunicationChannel::I2C_0);
+  register_fault(BenchFaultKey::MPU6050, "MPU 6050", CommunicationChannel::I2C_1);
+  register_fault(BenchFaultKey::MicroSD, "MicroSD", CommunicationChannel::SPI_0);
+
+  register_command("Run benchmarks", [this]
+  {
+    is_run_requested = true;
+  });
+
+  finish_construction();
+}
+
+void BenchStateManager::encode(void* encode_dest, const BenchState& state)
+{
+  // The encoder from START_STATE_ENCODER hides the base overload that advances the sequence
+  ElijahStateFramework::encode_state(encode_dest, state);
+}
+
+bool BenchStateManager::take_run_request()
+{
+  return is_run_requested.exchange(false);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+
+#include "elijah_state_framework.h"
+#include "standard_flight_phase_controller.h"
+
+// Same shape as the payload's state, so encoding and logging cost what they do in flight
+struct BenchState
+{
+  int32_t pressure;
+  double temperature;
+  double altitude;
+  double accel_x, accel_y, accel_z;
+  double gyro_x, gyro_y, gyro_z;
+  double bat_voltage, bat_percent;
+};
+
+enum class BenchPersistentDataKey : uint8_t
+{
+  LaunchKey = 1,
+  SeaLevelPressure = 2,
+  BenchCounter = 3
+};
+
+enum class BenchFaultKey : uint8_t
+{
+  BMP280 = 1,
+  MPU6050 = 2,
+  MicroSD = 3
+};
+
+class BenchFlightPhaseController final : public StandardFlightPhaseController<BenchState>
+{
+  void extract_state_data(BenchState state, double& accel_x, double& accel_y, double& accel_z,
+                          double& altitude) const override;
+};
+
+class BenchStateManager final : public elijah_state_framework::ElijahStateFramework<
+    BenchState, BenchPersistentDataKey, BenchFaultKey, StandardFlightPhase, BenchFlightPhaseController>
+{
+public:
+  BenchStateManager();
+
+  // encode_state() is only for the framework, this lets the benchmarks call it directly
+  void encode(void* encode_dest, const BenchState& state);
+
+  // Set by the "Run benchmarks" command, cleared once read
+  [[nodiscard]] bool take_run_request();
+
+protected:
+  START_STATE_ENCODER(BenchState)
+    ENCODE_STATE(pressure, DataType::Int32, "Pressure", "Pa")
+    ENCODE_STATE(temperature, DataType::Double, "Temperature", "degC")
+    ENCODE_STATE(altitude, DataType::Double, "Altitude", "m")
+    ENCODE_STATE(accel_x, DataType::Double, "Acceleration X", "m/s^2")
+    ENCODE_STATE(accel_y, DataType::Double, "Acceleration Y", "m/s^2")
+    ENCODE_STATE(accel_z, DataType::Double, "Acceleration Z", "m/s^2")
+    ENCODE_STATE(gyro_x, DataType::Double, "Gyro X", "deg/s")
+    ENCODE_STATE(gyro_y, DataType::Double, "Gyro Y", "deg/s")
+    ENCODE_STATE(gyro_z, DataType::Double, "Gyro Z", "deg/s")
+    ENCODE_STATE(bat_voltage, DataType::Double, "Voltage", "V")
+    ENCODE_STATE(bat_percent, DataType::Double, "Battery percentage", "%")
+  END_STATE_ENCODER()
+
+private:
+  std::atomic<bool> is_run_requested = false;
+};
@@ -0,0 +1,13 @@
+#include "benchmark.h"
+
+#include <cstdio>
+
+std::string BenchmarkResult::to_json() const
+{
+  char json[192];
+  snprintf(json, sizeof(json),
+           R"({"target":"%s","name":"%s","iterations":%llu,"total_us":%llu,"ns_per_op":%.1f})", BENCH_TARGET,
+           name.c_str(), static_cast<unsigned long long>(iterations), static_cast<unsigned long long>(total_us),
+           ns_per_op);
+  return json;
+}
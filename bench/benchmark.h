@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <pico/time.h>
+
+#if PICO_ON_DEVICE
+#define BENCH_TARGET "rp2040"
+#else
+#define BENCH_TARGET "host"
+#endif
+
+struct BenchmarkResult
+{
+  std::string name;
+  uint64_t iterations;
+  uint64_t total_us;
+  double ns_per_op;
+
+  // One JSON object per line, so runs can be diffed or loaded by anything without a parser for our format
+  [[nodiscard]] std::string to_json() const;
+};
+
+// Stops the compiler from throwing away a result the benchmark never uses
+template <typename T>
+void do_not_optimize(const T& value)
+{
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+/**
+ * Only op is timed. prepare runs (untimed) before each batch of batch_size ops, for anything that has to be reset so
+ * the ops measure the same thing every batch. One batch is run first to warm up the caches, and isn't counted.
+ */
+template <typename TPrepare, typename TOp>
+BenchmarkResult run_benchmark(const std::string& name, const uint64_t batches, const uint64_t batch_size,
+                              TPrepare&& prepare, TOp&& op)
+{
+  prepare();
+  for (uint64_t i = 0; i < batch_size; i++)
+  {
+    op(i);
+  }
+
+  uint64_t total_us = 0;
+  for (uint64_t batch = 0; batch < batches; batch++)
+  {
+    prepare();
+
+    const uint64_t start_us = time_us_64();
+    for (uint64_t i = 0; i < batch_size; i++)
+    {
+      op(batch * batch_size + i);
+    }
+    total_us += time_us_64() - start_us;
+  }
+
+  const uint64_t iterations = batches * batch_size;
+  return {
+    .name = name, .iterations = iterations, .total_us = total_us,
+    .ns_per_op = static_cast<double>(total_us) * 1000.0 / static_cast<double>(iterations)
+  };
+}
+
+template <typename TOp>
+BenchmarkResult run_benchmark(const std::string& name, const uint64_t iterations, TOp&& op)
+{
+  return run_benchmark(name, 1, iterations, []
+  {
+  }, op);
+}
@@ -0,0 +1,489 @@
+#include "benchmarks.h"
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <pico/mutex.h>
+
+#include "afsk_modulator.h"
+#include "afsk_transmitter.h"
+#include "ax25_frame.h"
+#include "bmp_280.h"
+#include "fault_manager.h"
+#include "mpu_6050.h"
+#include "ovonic_battery.h"
+#include "pin_outs.h"
+#include "seqlock.h"
+#include "shared_mutex.h"
+#include "state_framework_logger.h"
+#include "windowed_stats.h"
+
+#if PICO_ON_DEVICE
+#include <pico/multicore.h>
+#else
+#include <thread>
+#endif
+
+namespace
+{
+  // Sample trimming values and readings from the BMP 280 datasheet
+  constexpr BMP280::CalibrationData bmp_280_calibration = {
+    .dig_T1 = 27504, .dig_T2 = 26435, .dig_T3 = -1000, .dig_P1 = 36477, .dig_P2 = -10685, .dig_P3 = 3024,
+    .dig_P4 = 2855, .dig_P5 = 140, .dig_P6 = -7, .dig_P7 = 15500, .dig_P8 = -14600, .dig_P9 = 6000
+  };
+  constexpr int32_t bmp_280_pressure_adc = 415148;
+  constexpr int32_t bmp_280_temperature_adc = 519888;
+
+  constexpr size_t log_packet_size = 64;
+  constexpr size_t phase_history_sizes[] = {10, 50, 100, 500};
+
+  BenchState make_state(const uint64_t i)
+  {
+    // Enough variation that nothing can be hoisted out of the loop
+    const auto offset = static_cast<double>(i & 0xFF);
+    return {
+      .pressure = 101325 - static_cast<int32_t>(i & 0xFF), .temperature = 20 + offset / 100,
+      .altitude = offset, .accel_x = 0.1, .accel_y = -GRAVITY_CONSTANT, .accel_z = 0.2,
+      .gyro_x = 0.01, .gyro_y = 0.02, .gyro_z = 0.03, .bat_voltage = 7.8, .bat_percent = 78
+    };
+  }
+
+  // What shared_mutex_t was before it was writer-preferring, a reader count under one mutex and a writers' mutex the
+  // first reader in takes for all of them. Kept here so the two can be compared on the same board.
+  struct TwoMutexSharedMutex
+  {
+    unsigned int reader_count = 0;
+    mutex_t reader_mutex, writer_mutex;
+
+    TwoMutexSharedMutex()
+    {
+      mutex_init(&reader_mutex);
+      mutex_init(&writer_mutex);
+    }
+
+    void enter_shared()
+    {
+      mutex_enter_blocking(&reader_mutex);
+      if (++reader_count == 1)
+      {
+        mutex_enter_blocking(&writer_mutex);
+      }
+      mutex_exit(&reader_mutex);
+    }
+
+    void exit_shared()
+    {
+      mutex_enter_blocking(&reader_mutex);
+      if (--reader_count == 0)
+      {
+        mutex_exit(&writer_mutex);
+      }
+      mutex_exit(&reader_mutex);
+    }
+
+    void enter_exclusive()
+    {
+      mutex_enter_blocking(&writer_mutex);
+    }
+
+    void exit_exclusive()
+    {
+      mutex_exit(&writer_mutex);
+    }
+  };
+
+  struct WriterPreferringSharedMutex
+  {
+    shared_mutex_t s_mtx{};
+
+    WriterPreferringSharedMutex()
+    {
+      shared_mutex_init(&s_mtx);
+    }
+
+    void enter_shared()
+    {
+      shared_mutex_enter_blocking_shared(&s_mtx);
+    }
+
+    void exit_shared()
+    {
+      shared_mutex_exit_shared(&s_mtx);
+    }
+
+    void enter_exclusive()
+    {
+      shared_mutex_enter_blocking_exclusive(&s_mtx);
+    }
+
+    void exit_exclusive()
+    {
+      shared_mutex_exit_exclusive(&s_mtx);
+    }
+  };
+
+  // A hand-off bounces the lock between the cores (threads on the host). Each side takes it exclusively, and only
+  // counts it when it's their turn, so every turn is the lock going from one core to the other.
+  void* handoff_lock = nullptr;
+  volatile uint32_t handoff_turn = 0;
+  uint32_t handoff_rounds = 0;
+  std::atomic<bool> is_handoff_done = false;
+
+  template <typename TLock>
+  void take_turns(TLock* lock, const uint32_t parity)
+  {
+    uint32_t taken = 0;
+    while (taken < handoff_rounds)
+    {
+      lock->enter_exclusive();
+      if ((handoff_turn & 1) == parity)
+      {
+        handoff_turn = handoff_turn + 1;
+        taken++;
+      }
+      lock->exit_exclusive();
+#if !PICO_ON_DEVICE
+      // The threads might share a CPU on the host, don't spin out the other side's time slice
+      std::this_thread::yield();
+#endif
+    }
+  }
+
+  template <typename TLock>
+  void take_other_turns()
+  {
+    take_turns(static_cast<TLock*>(handoff_lock), 1);
+    is_handoff_done = true;
+  }
+
+  template <typename TLock>
+  BenchmarkResult run_handoff_benchmark(const std::string& name, TLock& lock, const uint32_t rounds)
+  {
+    handoff_lock = &lock;
+    handoff_turn = 0;
+    handoff_rounds = rounds;
+    is_handoff_done = false;
+
+#if PICO_ON_DEVICE
+    multicore_reset_core1();
+    multicore_launch_core1(take_other_turns<TLock>);
+#else
+    std::thread other_side(take_other_turns<TLock>);
+#endif
+
+    const uint64_t start_us = time_us_64();
+    take_turns(&lock, 0);
+    while (!is_handoff_done)
+    {
+      tight_loop_contents();
+    }
+    const uint64_t total_us = time_us_64() - start_us;
+
+#if PICO_ON_DEVICE
+    multicore_reset_core1();
+#else
+    other_side.join();
+#endif
+
+    const uint64_t iterations = 2 * static_cast<uint64_t>(rounds);
+    return {
+      .name = name, .iterations = iterations, .total_us = total_us,
+      .ns_per_op = static_cast<double>(total_us) * 1000.0 / static_cast<double>(iterations)
+    };
+  }
+
+  template <typename TLock>
+  void bench_lock(const std::string& name, const uint32_t scale,
+                  const std::function<void(const BenchmarkResult&)>& report)
+  {
+    TLock lock;
+    report(run_benchmark(name + "_shared", 2000 * scale, [&lock](uint64_t)
+    {
+      lock.enter_shared();
+      lock.exit_shared();
+    }));
+
+    report(run_benchmark(name + "_exclusive", 2000 * scale, [&lock](uint64_t)
+    {
+      lock.enter_exclusive();
+      lock.exit_exclusive();
+    }));
+
+    report(run_handoff_benchmark(name + "_handoff", lock, 200 * scale));
+  }
+
+  void bench_framework(BenchStateManager* state_manager, const uint32_t scale,
+                       const std::function<void(const BenchmarkResult&)>& report)
+  {
+    uint8_t encoded[256];
+    report(run_benchmark("encode_state", 2000 * scale, [&](const uint64_t i)
+    {
+      state_manager->encode(encoded, make_state(i));
+      do_not_optimize(encoded);
+    }));
+
+    // The log is flushed between batches, like the main loop does, so the write buffer never piles up
+    report(run_benchmark("state_changed", 10 * scale, 100, [state_manager]
+    {
+      state_manager->check_for_log_write();
+    }, [state_manager](const uint64_t i)
+    {
+      state_manager->state_changed(make_state(i));
+    }));
+
+    // Same again, with every 16 states going out as one StateBatch packet
+    state_manager->set_state_batch_size(16);
+    report(run_benchmark("state_changed_batched", 10 * scale, 100, [state_manager]
+    {
+      state_manager->check_for_log_write();
+    }, [state_manager](const uint64_t i)
+    {
+      state_manager->state_changed(make_state(i));
+    }));
+    state_manager->set_state_batch_size(1);
+
+    // And logged in column blocks
+    state_manager->set_log_layout(elijah_state_framework::LogLayout::Columns);
+    report(run_benchmark("state_changed_columns", 10 * scale, 100, [state_manager]
+    {
+      state_manager->check_for_log_write();
+    }, [state_manager](const uint64_t i)
+    {
+      state_manager->state_changed(make_state(i));
+    }));
+    state_manager->set_log_layout(elijah_state_framework::LogLayout::Rows);
+  }
+
+  void bench_logger(const uint32_t scale, const std::function<void(const BenchmarkResult&)>& report)
+  {
+    elijah_state_framework::StateFrameworkLogger logger(BENCH_LOG_FILE_NAME);
+
+    uint8_t packet[log_packet_size];
+    for (size_t i = 0; i < log_packet_size; i++)
+    {
+      packet[i] = static_cast<uint8_t>(i);
+    }
+
+    // Each batch fills the log buffer exactly once, so every op is a plain copy apart from the last
+    report(run_benchmark("logger_log_data", 20 * scale, LOG_BUFF_SIZE / log_packet_size, [&logger]
+    {
+      logger.flush_log();
+    }, [&logger, &packet](uint64_t)
+    {
+      logger.log_data(packet, log_packet_size);
+    }));
+
+    uint8_t block[LOG_BUFF_SIZE];
+    for (size_t i = 0; i < LOG_BUFF_SIZE; i++)
+    {
+      block[i] = static_cast<uint8_t>(i);
+    }
+
+    report(run_benchmark("logger_flush_write_buff", 20 * scale, 1, [&logger, &block]
+    {
+      logger.log_bulk(block, LOG_BUFF_SIZE);
+    }, [&logger](uint64_t)
+    {
+      logger.flush_write_buff();
+    }));
+  }
+
+  void bench_faults(const uint32_t scale, const std::function<void(const BenchmarkResult&)>& report)
+  {
+    FaultManager<BenchFaultKey> fault_manager(0x0000);
+    fault_manager.register_fault(BenchFaultKey::BMP280, "BMP 280", CommunicationChannel::I2C_0);
+    fault_manager.register_fault(BenchFaultKey::MPU6050, "MPU 6050", CommunicationChannel::I2C_1);
+    fault_manager.register_fault(BenchFaultKey::MicroSD, "MicroSD", CommunicationChannel::SPI_0);
+
+    uint8_t fault_bit;
+    bool did_fault_change;
+
+    // What every sensor update does, nearly every call leaves the fault as it was
+    report(run_benchmark("fault_set_unchanged", 10000 * scale, [&](uint64_t)
+    {
+      do_not_optimize(fault_manager.set_fault_status(BenchFaultKey::BMP280, false, fault_bit, did_fault_change));
+    }));
+
+    report(run_benchmark("fault_set_toggle", 10000 * scale, [&](const uint64_t i)
+    {
+      do_not_optimize(fault_manager.set_fault_status(BenchFaultKey::MPU6050, i & 1, fault_bit, did_fault_change));
+    }));
+  }
+
+  void bench_locks(const uint32_t scale, const std::function<void(const BenchmarkResult&)>& report)
+  {
+    bench_lock<TwoMutexSharedMutex>("two_mutex_lock", scale, report);
+    bench_lock<WriterPreferringSharedMutex>("shared_mutex", scale, report);
+
+    // The latest state, what the framework publishes through its seqlock on every update
+    seqlock_t seq_lck;
+    seqlock_init(&seq_lck);
+    BenchState published = make_state(0);
+    report(run_benchmark("seqlock_write_state", 2000 * scale, [&seq_lck, &published](const uint64_t i)
+    {
+      const BenchState state = make_state(i);
+      seqlock_write(&seq_lck, &published, &state, sizeof(BenchState));
+    }));
+
+    report(run_benchmark("seqlock_read_state", 2000 * scale, [&seq_lck, &published](uint64_t)
+    {
+      BenchState state;
+      seqlock_read(&seq_lck, &state, &published, sizeof(BenchState));
+      do_not_optimize(state);
+    }));
+  }
+
+  void bench_persistent_data(BenchStateManager* state_manager, const uint32_t scale,
+                             const std::function<void(const BenchmarkResult&)>& report)
+  {
+    elijah_state_framework::PersistentDataStorage<BenchPersistentDataKey>* storage = state_manager->
+      get_persistent_data_storage();
+
+    report(run_benchmark("persistent_get_double", 5000 * scale, [storage](uint64_t)
+    {
+      do_not_optimize(storage->get_double(BenchPersistentDataKey::SeaLevelPressure));
+    }));
+
+    report(run_benchmark("persistent_set_double", 5000 * scale, [storage](const uint64_t i)
+    {
+      storage->set_double(BenchPersistentDataKey::BenchCounter, static_cast<double>(i));
+    }));
+
+    report(run_benchmark("persistent_commit", BENCH_COMMIT_ITERATIONS, [storage](const uint64_t i)
+    {
+      storage->set_double(BenchPersistentDataKey::BenchCounter, static_cast<double>(i));
+      storage->commit_data();
+    }));
+  }
+
+  void bench_sensors(const uint32_t scale, const std::function<void(const BenchmarkResult&)>& report)
+  {
+    report(run_benchmark("bmp280_compensate", 2000 * scale, [](const uint64_t i)
+    {
+      int32_t pressure;
+      double temperature, altitude;
+      BMP280::compensate(bmp_280_pressure_adc + static_cast<int32_t>(i & 0xFF),
+                         bmp_280_temperature_adc + static_cast<int32_t>(i & 0xFF), bmp_280_calibration, 101325.0,
+                         pressure, temperature, altitude);
+      do_not_optimize(pressure);
+      do_not_optimize(temperature);
+      do_not_optimize(altitude);
+    }));
+
+    // Never touches the bus, only the calibration is used
+    MPU6050 mpu6050(i2c1, MPU_6050_ADDR, MPU6050::GyroFullScaleRange::Range500, MPU6050::AccelFullScaleRange::Range8g);
+    mpu6050.load_calibration_data(0.1, 0.2, 0.3, 0.01, 0.02, 0.03);
+
+    report(run_benchmark("mpu6050_compensate", 5000 * scale, [&mpu6050](const uint64_t i)
+    {
+      const auto raw = static_cast<int16_t>(i & 0x7FFF);
+      double xa, ya, za, xg, yg, zg;
+      mpu6050.compensate(raw, static_cast<int16_t>(-raw), raw, raw, static_cast<int16_t>(-raw), raw, xa, ya, za, xg,
+                         yg, zg);
+      do_not_optimize(xa);
+      do_not_optimize(ya);
+      do_not_optimize(za);
+      do_not_optimize(xg);
+      do_not_optimize(yg);
+      do_not_optimize(zg);
+    }));
+
+    OvonicBattery battery(BAT_VOLTAGE_PIN, BENCH_BATTERY_SAMPLE_COUNT);
+    report(run_benchmark("battery_get_voltage", 1000 * scale, [&battery](uint64_t)
+    {
+      do_not_optimize(battery.get_voltage());
+    }));
+
+    report(run_benchmark("battery_charge_percent", 2000 * scale, [&battery](const uint64_t i)
+    {
+      do_not_optimize(battery.calc_charge_percent(6.5 + static_cast<double>(i & 0xFF) / 128));
+    }));
+  }
+
+  void bench_aprs(const uint32_t scale, const std::function<void(const BenchmarkResult&)>& report)
+  {
+    // Alternating bytes, so the tone keeps changing
+    uint8_t symbols[64];
+    for (size_t i = 0; i < sizeof(symbols); i++)
+    {
+      symbols[i] = static_cast<uint8_t>(i * 37);
+    }
+
+    // One buffer refill, what the transmitter's interrupt does every 10ms while it's sending
+    AfskModulator modulator(AFSK_SAMPLE_RATE_HZ, AFSK_PWM_TOP);
+    uint16_t samples[AFSK_BUFFER_SAMPLES];
+    report(run_benchmark("afsk_fill_buffer", 200 * scale, [&modulator, &symbols, &samples](uint64_t)
+    {
+      if (modulator.is_done())
+      {
+        modulator.start(symbols, sizeof(symbols) * 8);
+      }
+      do_not_optimize(modulator.fill(samples, AFSK_BUFFER_SAMPLES));
+    }));
+
+    // A typical position report, every byte of it through the FCS, stuffing and NRZI
+    constexpr char info[] = "!4903.50N/07201.75W-Project Elijah payload, altitude 1234m";
+    constexpr ax25::Address digipeater = {"WIDE2", 1};
+    const ax25::UiFrame frame = {
+      .destination = {"APZELJ", 0}, .source = {"N0CALL", 11}, .digipeaters = &digipeater, .digipeater_count = 1,
+      .info = reinterpret_cast<const uint8_t*>(info), .info_len = sizeof(info) - 1
+    };
+    uint8_t frame_symbols[(AFSK_MAX_FRAME_SYMBOLS + 7) / 8];
+    report(run_benchmark("ax25_encode_frame", 200 * scale, [&frame, &frame_symbols](uint64_t)
+    {
+      do_not_optimize(ax25::encode_ui_frame(frame, frame_symbols, AFSK_MAX_FRAME_SYMBOLS));
+    }));
+  }
+
+  void bench_phase_update(const uint32_t scale, const std::function<void(const BenchmarkResult&)>& report)
+  {
+    for (const size_t history_size : phase_history_sizes)
+    {
+      // Descent used to go through the whole history every update, altitude keeps changing so it never lands
+      std::deque<BenchState> state_history;
+      for (size_t i = 0; i < history_size; i++)
+      {
+        BenchState state = make_state(i);
+        state.altitude = 500 - static_cast<double>(i) * 5;
+        state_history.push_back(state);
+      }
+
+      BenchFlightPhaseController phase_controller;
+      report(run_benchmark("phase_update_descent_" + std::to_string(history_size), 200 * scale,
+                           [&phase_controller, &state_history](uint64_t)
+                           {
+                             do_not_optimize(phase_controller.update_phase(StandardFlightPhase::DESCENT,
+                                                                           state_history));
+                           }));
+    }
+
+    // 3 s windows at 200 Hz, what the standard controller keeps for landing
+    constexpr uint64_t window_us = 3000000, sample_period_us = 5000;
+    elijah_state_framework::SlidingMinMax min_max(window_us);
+    report(run_benchmark("sliding_min_max_push", 2000 * scale, [&min_max](const uint64_t i)
+    {
+      min_max.push(i * sample_period_us, static_cast<double>(i * 7919 % 1000));
+      do_not_optimize(min_max.get_max() - min_max.get_min());
+    }));
+
+    elijah_state_framework::RunningStats running_stats(window_us);
+    report(run_benchmark("running_stats_push", 2000 * scale, [&running_stats](const uint64_t i)
+    {
+      running_stats.push(i * sample_period_us, static_cast<double>(i * 7919 % 1000));
+      do_not_optimize(running_stats.get_variance());
+    }));
+  }
+}
+
+void run_all_benchmarks(BenchStateManager* state_manager, const uint32_t scale,
+                        const std::function<void(const BenchmarkResult&)>& report)
+{
+  bench_framework(state_manager, scale, report);
+  bench_logger(scale, report);
+  bench_faults(scale, report);
+  bench_locks(scale, report);
+  bench_persistent_data(state_manager, scale, report);
+  bench_sensors(scale, report);
+  bench_aprs(scale, report);
+  bench_phase_update(scale, report);
+}
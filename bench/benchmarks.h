@@ -0,0 +1,16 @@
+#pragma once
+
+#include <functional>
+
+#include "bench_state_manager.h"
+#include "benchmark.h"
+
+#define BENCH_LOG_FILE_NAME "bench-log"
+#define BENCH_BATTERY_SAMPLE_COUNT 32
+
+// Every commit erases and programs a flash sector, so the device keeps this low no matter the scale
+#define BENCH_COMMIT_ITERATIONS 4
+
+// Iteration counts are sized for the RP2040 (a few hundred ms per benchmark) and multiplied by scale
+void run_all_benchmarks(BenchStateManager* state_manager, uint32_t scale,
+                        const std::function<void(const BenchmarkResult&)>& report);
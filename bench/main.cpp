@@ -0,0 +1,247 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <hardware/adc.h>
+#include <pico/stdio.h>
+#include <pico/stdio_usb.h>
+
+#include "bench_state_manager.h"
+#include "benchmarks.h"
+#include "pin_outs.h"
+
+#if PICO_ON_DEVICE
+#include <pico/flash.h>
+
+int main()
+{
+  flash_safe_execute_core_init();
+  stdio_init_all();
+
+  adc_init();
+  adc_gpio_init(BAT_VOLTAGE_PIN);
+
+  elijah_state_framework::StateFrameworkLogger::init_driver_on_core();
+  auto* state_manager = new BenchStateManager();
+
+  // Results go out as serial-only log messages so they don't get in the way of the framework's own packets
+  const auto report = [](const BenchmarkResult& result)
+  {
+    elijah_state_framework::log_serial_message(result.to_json());
+  };
+
+  bool was_connected = false;
+  while (true)
+  {
+    state_manager->check_for_commands();
+
+    // Run once whenever something connects, and again on "Run benchmarks"
+    const bool is_connected = stdio_usb_connected();
+    if ((is_connected && !was_connected) || state_manager->take_run_request())
+    {
+      run_all_benchmarks(state_manager, 1, report);
+      elijah_state_framework::log_serial_message("Benchmarks done");
+    }
+    was_connected = is_connected;
+
+    sleep_ms(50);
+  }
+}
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <ff.h>
+
+#define BENCH_HOST_SCALE 100
+
+namespace
+{
+  void print_usage(const char* program_name)
+  {
+    fprintf(stderr, "Usage: %s [--scale <n>] [--out <file>] [--compare <file>] [--log-dir <dir>] [--usb <file>]\n"
+            "  --scale    Multiplier on the RP2040 iteration counts (default: %d)\n"
+            "  --out      File the results are also written to, one JSON object per line\n"
+            "  --compare  Results from an earlier run (host or device) to print the change against\n"
+            "  --log-dir  Directory the logs are written to (default: current directory)\n"
+            "  --usb      File the framework's USB output is written to, so it's part of the cost (default: none)\n",
+            program_name, BENCH_HOST_SCALE);
+  }
+
+  // Reads name and ns_per_op out of each line with a result in it, anything in front of the object (like the
+  // "SERIAL: " state-framework-com adds to device output) is skipped
+  bool load_baseline(const char* path, std::map<std::string, double>& baseline)
+  {
+    FILE* file = fopen(path, "r");
+    if (!file)
+    {
+      return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), file))
+    {
+      const char* name_start = strstr(line, R"("name":")");
+      const char* ns_start = strstr(line, R"("ns_per_op":)");
+      if (!name_start || !ns_start)
+      {
+        continue;
+      }
+
+      name_start += strlen(R"("name":")");
+      const char* name_end = strchr(name_start, '"');
+      if (!name_end)
+      {
+        continue;
+      }
+
+      baseline[std::string(name_start, name_end)] = strtod(ns_start + strlen(R"("ns_per_op":)"), nullptr);
+    }
+
+    fclose(file);
+    return true;
+  }
+}
+
+int main(const int argc, char** argv)
+{
+  uint32_t scale = BENCH_HOST_SCALE;
+  const char* out_path = nullptr;
+  const char* compare_path = nullptr;
+  const char* log_dir = ".";
+  const char* usb_path = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (i + 1 >= argc)
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    bool is_valid = true;
+    if (strcmp(argv[i], "--scale") == 0)
+    {
+      scale = strtoul(argv[++i], nullptr, 10);
+      is_valid = scale > 0;
+    }
+    else if (strcmp(argv[i], "--out") == 0)
+    {
+      out_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--compare") == 0)
+    {
+      compare_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--log-dir") == 0)
+    {
+      log_dir = argv[++i];
+    }
+    else if (strcmp(argv[i], "--usb") == 0)
+    {
+      usb_path = argv[++i];
+    }
+    else
+    {
+      is_valid = false;
+    }
+
+    if (!is_valid)
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::map<std::string, double> baseline;
+  if (compare_path && !load_baseline(compare_path, baseline))
+  {
+    fprintf(stderr, "Failed to open %s\n", compare_path);
+    return EXIT_FAILURE;
+  }
+
+  FILE* out_file = nullptr;
+  if (out_path)
+  {
+    out_file = fopen(out_path, "w");
+    if (!out_file)
+    {
+      fprintf(stderr, "Failed to open %s\n", out_path);
+      return EXIT_FAILURE;
+    }
+  }
+
+  int usb_fd = -1;
+  if (usb_path)
+  {
+    usb_fd = open(usb_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (usb_fd < 0)
+    {
+      fprintf(stderr, "Failed to open %s\n", usb_path);
+      return EXIT_FAILURE;
+    }
+    host_stdio_set_fds(-1, usb_fd);
+  }
+
+  host_fatfs_set_root(log_dir);
+  host_adc_set_value(2, 0x9A0);
+
+  auto* state_manager = new BenchStateManager();
+  const std::string launch_name = state_manager->get_persistent_data_storage()->get_string(
+    BenchPersistentDataKey::LaunchKey);
+
+  if (compare_path)
+  {
+    printf("%-28s %15s %15s %9s\n", "Benchmark", "Baseline", "Current", "Change");
+  }
+
+  run_all_benchmarks(state_manager, scale, [&](const BenchmarkResult& result)
+  {
+    const std::string json = result.to_json();
+    if (out_file)
+    {
+      fprintf(out_file, "%s\n", json.c_str());
+    }
+
+    if (!compare_path)
+    {
+      printf("%s\n", json.c_str());
+      return;
+    }
+
+    if (const auto it = baseline.find(result.name); it != baseline.end() && it->second > 0)
+    {
+      printf("%-28s %12.1f ns %12.1f ns %+8.1f%%\n", result.name.c_str(), it->second, result.ns_per_op,
+             (result.ns_per_op / it->second - 1) * 100);
+    }
+    else
+    {
+      printf("%-28s %15s %12.1f ns\n", result.name.c_str(), "-", result.ns_per_op);
+    }
+  });
+
+  delete state_manager;
+
+  // Nothing in the logs is worth keeping, they only exist so flushing does real writes
+  for (const std::string& log_name : {std::string(BENCH_LOG_FILE_NAME), launch_name})
+  {
+    for (uint32_t segment = 0; f_unlink(
+           elijah_state_framework::StateFrameworkLogger::get_segment_file_name(log_name, segment).c_str()) == FR_OK;
+         segment++)
+    {
+    }
+  }
+
+  if (out_file)
+  {
+    fclose(out_file);
+  }
+  if (usb_fd >= 0)
+  {
+    host_stdio_set_fds(-1, -1);
+    close(usb_fd);
+  }
+
+  return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+
+// Same wiring as the payload, only what the benchmarks touch
+
+#define SPI0_SCK_PIN 18 // Pin 24
+#define SPI0_TX_PIN 19 // Pin 25
+#define SPI0_RX_PIN 16 // Pin 21
+#define SPI0_CSN_PIN 17 // Pin 22
+
+#define BAT_VOLTAGE_PIN 28 // Pin 34
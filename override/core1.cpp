@@ -28,27 +28,32 @@ void core1::core1_main()
   queue_add_blocking(&core1_ready_queue, &core_ready);
   queue_remove_blocking(&core0_ready_queue, &core_ready);
 
-  bool is_first_detection = false;
-  absolute_time_t land_time = 0;
+  absolute_time_t ptt_disable_time = nil_time;
+  bool is_ptt_disabled = false;
   while (true)
   {
-    if (override_state_manager->get_current_flight_phase() == StandardFlightPhase::LANDED)
+    const auto snapshot = override_state_manager->get_latest_snapshot();
+    if (snapshot.phase != StandardFlightPhase::LANDED)
     {
-      if (!is_first_detection)
-      {
-        land_time = get_absolute_time();
-        is_first_detection = true;
-      }
-      else
-      {
-        if (delayed_by_ms(land_time, 5 * 60 * 1000) < get_absolute_time())
-        {
-          gpio_put(PTT_DISABLE, true);
-          override_state_manager->log_message("DISABLING PTT");
-        }
-      }
+      // Nothing to do until the landing, so sleep until it's predicted instead of checking the phase every 50ms
+      sleep_ms(elijah_state_framework::get_landing_wait_ms(snapshot.prediction, CORE1_MIN_WAIT_MS,
+                                                           CORE1_MAX_WAIT_MS));
+      continue;
     }
 
-    sleep_ms(50);
+    if (is_nil_time(ptt_disable_time))
+    {
+      ptt_disable_time = make_timeout_time_ms(PTT_DISABLE_DELAY_MS);
+    }
+
+    if (!is_ptt_disabled && time_reached(ptt_disable_time))
+    {
+      gpio_put(PTT_DISABLE, true);
+      override_state_manager->log_message("DISABLING PTT");
+      is_ptt_disabled = true;
+    }
+
+    // Core 1 has to stay in this loop to keep answering flash lockouts
+    sleep_until(is_ptt_disabled ? make_timeout_time_ms(CORE1_MAX_WAIT_MS) : ptt_disable_time);
   }
 }
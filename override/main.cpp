@@ -4,6 +4,7 @@
 
 #include "core1.h"
 #include "override_state_manager.h"
+#include "pin_outs.h"
 #include "sensors.h"
 
 int main()
@@ -6,6 +6,9 @@
 #include "override_flight_phase_controller.h"
 #include "sensors.h"
 
+// 5 seconds of states at the 20 Hz main loop, kept so launch detection doesn't cost the start of the burn
+#define PRE_TRIGGER_SAMPLES 100
+
 enum class StandardFlightPhase : uint8_t;
 
 struct OverrideState
@@ -45,7 +48,7 @@ class OverrideStateManager final : public elijah_state_framework::ElijahStateFra
 {
 public:
   OverrideStateManager() : ElijahStateFramework("Override", OverridePersistentStateKey::LaunchKey,
-                                                OverrideFaultKey::MicroSD, 10)
+                                                OverrideFaultKey::MicroSD, 10, PRE_TRIGGER_SAMPLES)
   {
     get_persistent_data_storage()->register_key(OverridePersistentStateKey::SeaLevelPressure, "Barometric pressure",
                                                 101083.7);
@@ -1,5 +1,6 @@
 #include "pin_outs.h"
 
+#include "analog_capture.h"
 #include "i2c_util.h"
 #include <hardware/adc.h>
 
@@ -30,4 +31,6 @@ void pin_init()
 
   adc_init();
   adc_gpio_init(BAT_VOLTAGE_PIN);
+  // The battery reads its voltage out of the capture instead of waiting on a conversion every loop
+  analog_capture::start(1u << (BAT_VOLTAGE_PIN - 26));
 }
@@ -1,20 +1,26 @@
 #pragma once
 
-#include <memory>
 #include <string>
-#include <hardware/pwm.h>
 #include <sys/_stdint.h>
 
-#define APRS_FRAME_FLAG 0x7E
+#include "ax25_frame.h"
+
+// Experimental software's destination, APZxxx
+#define APRS_DESTINATION "APZELJ"
+// Path the digipeaters pass it along
+#define APRS_DIGIPEATER "WIDE2"
+#define APRS_DIGIPEATER_SSID 1
+// Who the payload transmits as, has to be changed to a licensed callsign before flying. -11 is balloons, aircraft and
+// rockets
+#define APRS_CALLSIGN "N0CALL"
+#define APRS_CALLSIGN_SSID 11
 
 namespace aprs
 {
-  inline uint pwm_slice_num;
-  inline pwm_chan pwm_channel;
-  inline double pwm_freq;
-
-  std::unique_ptr<uint8_t> encode_aprs_string_message(const std::string& callsign, const std::string& message, size_t& message_len);
-
-  void init_aprs_system(uint32_t clock_speed_khz, uint8_t pwm_gpio, pwm_chan channel);
-  void transmit_bytes(const uint8_t* data, size_t len, size_t flag_count);
+  // Audio goes out of pwm_gpio, call it from core 0 (see afsk_transmitter.h)
+  bool init_aprs_system(uint8_t pwm_gpio);
+  // Queues info (already in one of the APRS formats) as a UI frame from source to APRS_DESTINATION, through
+  // APRS_DIGIPEATER, and returns straight away. Nothing is allocated, the frame's encoded on the stack. False if the
+  // callsign or info isn't valid for AX.25, or the transmitter's queue is full.
+  bool transmit_message(const ax25::Address& source, const std::string& info);
 }
@@ -1,8 +1,10 @@
 #include "core1.h"
 
+#include <format>
 #include <pico/flash.h>
 #include <pico/multicore.h>
 
+#include "aprs.h"
 #include "payload_state_manager.h"
 #include "state_framework_logger.h"
 
@@ -27,13 +29,24 @@ void core1::core1_main()
   queue_add_blocking(&core1_ready_queue, &core_ready);
   queue_remove_blocking(&core0_ready_queue, &core_ready);
 
+  constexpr ax25::Address aprs_source = {APRS_CALLSIGN, APRS_CALLSIGN_SSID};
+  absolute_time_t next_beacon_time = nil_time;
+
   while (true)
   {
-    if (payload_state_manager->get_current_flight_phase() == StandardFlightPhase::LANDED)
+    const auto snapshot = payload_state_manager->get_latest_snapshot();
+    if (snapshot.phase == StandardFlightPhase::LANDED && time_reached(next_beacon_time))
     {
-      // TODO: APRS
+      // A status report, so it's short enough for any receiver to show. Tried again next wake up if the queue's full.
+      const std::string status = std::format(">Landed, apogee {:.0f}m, battery {:.2f}V",
+                                             snapshot.prediction.apogee_altitude, snapshot.state.bat_voltage);
+      if (aprs::transmit_message(aprs_source, status))
+      {
+        next_beacon_time = make_timeout_time_ms(CORE1_APRS_INTERVAL_MS);
+      }
     }
 
-    sleep_ms(50);
+    // Nothing happens before the landing, so sleep until it's predicted instead of checking the phase every 50ms
+    sleep_ms(elijah_state_framework::get_landing_wait_ms(snapshot.prediction, CORE1_MIN_WAIT_MS, CORE1_MAX_WAIT_MS));
   }
 }
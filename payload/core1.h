@@ -2,6 +2,12 @@
 
 #include <pico/util/queue.h>
 
+// Core 1 wakes up at least this often, and sooner when the landing's predicted sooner
+#define CORE1_MAX_WAIT_MS 1000
+#define CORE1_MIN_WAIT_MS 50
+// How often the landed payload beacons its status over APRS
+#define CORE1_APRS_INTERVAL_MS 60000
+
 namespace core1 {
     inline queue_t core0_ready_queue, core1_ready_queue;
 
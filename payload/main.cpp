@@ -14,8 +14,6 @@
 #include "elijah_state_framework.h"
 #include "sensors/onboard_clock/onboard_clock.h"
 
-#define APRS_FLAG 0x7E
-
 int main()
 {
   flash_safe_execute_core_init();
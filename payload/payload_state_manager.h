@@ -7,6 +7,9 @@
 #include "sensors.h"
 #include "sensors/ds_1307/ds_1307.h"
 
+// 5 seconds of states at the 20 Hz main loop, kept so launch detection doesn't cost the start of the burn
+#define PRE_TRIGGER_SAMPLES 100
+
 struct PayloadState
 {
   tm time_inst;
@@ -46,7 +49,8 @@ class PayloadStateManager final : public elijah_state_framework::ElijahStateFram
     PayloadState, PayloadPersistentDataKey, PayloadFaultKey, StandardFlightPhase, PayloadFlightPhaseController>
 {
 public:
-  PayloadStateManager(): ElijahStateFramework("Payload", PayloadPersistentDataKey::LaunchKey, PayloadFaultKey::MicroSD, 10)
+  PayloadStateManager(): ElijahStateFramework("Payload", PayloadPersistentDataKey::LaunchKey, PayloadFaultKey::MicroSD, 10,
+                                               PRE_TRIGGER_SAMPLES)
   {
     get_persistent_data_storage()->register_key(PayloadPersistentDataKey::SeaLevelPressure, "Barometric pressure",
                                                 101325.0);
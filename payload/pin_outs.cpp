@@ -1,5 +1,6 @@
 #include "pin_outs.h"
 
+#include "analog_capture.h"
 #include "i2c_util.h"
 #include <hardware/adc.h>
 #include <hardware/pwm.h>
@@ -33,8 +34,9 @@ void pin_init()
   // Battery ADC
   adc_init();
   adc_gpio_init(BAT_VOLTAGE_PIN);
+  // The battery reads its voltage out of the capture instead of waiting on a conversion every loop
+  analog_capture::start(1u << (BAT_VOLTAGE_PIN - 26));
 
-  gpio_init(RADIO_PTT_PIN);
-  gpio_set_dir(RADIO_PTT_PIN, GPIO_OUT);
-  //aprs::init_aprs_system(SYS_CLK_KHZ, RADIO_PTT_PIN, PWM_CHAN_B);
+  // Sets the pin up for PWM itself. If it fails, core 1's transmit_message() calls just return false
+  aprs::init_aprs_system(RADIO_PTT_PIN);
 }
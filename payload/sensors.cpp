@@ -2,6 +2,7 @@
 
 #include "ovonic_battery.h"
 #include "payload_state_manager.h"
+#include "pin_outs.h"
 
 
 void sensors_init()
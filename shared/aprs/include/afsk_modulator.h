@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bell 202, what APRS is sent with
+#define AFSK_BAUD 1200
+#define AFSK_MARK_HZ 1200
+#define AFSK_SPACE_HZ 2200
+
+// One sine cycle is 1 << AFSK_SINE_TABLE_BITS samples
+#define AFSK_SINE_TABLE_BITS 8
+
+/**
+ * Turns a symbol stream into audio samples at a fixed sample rate. A 32 bit phase accumulator steps through a sine table
+ * at the mark or space frequency, and never resets between symbols (or frames), so the tone changes without a jump in
+ * phase. Symbol timing comes from a second accumulator, so a rate that isn't a multiple of AFSK_BAUD still averages out
+ * to exactly 1200 baud. Nothing is computed in floating point once it's constructed.
+ */
+class AfskModulator
+{
+public:
+  // Samples go from 0 to max_level, centred on max_level / 2
+  AfskModulator(uint32_t sample_rate_hz, uint16_t max_level);
+
+  // One bit per symbol, the first in the lowest bit of the first byte. 1 sends the mark tone, 0 the space tone (this is
+  // after NRZI, ax25::encode_ui_frame() writes them). symbols has to stay as it is until is_done().
+  void start(const uint8_t* symbols, size_t symbol_count);
+
+  // Writes the next count samples, and returns how many of them were from symbols. After the last symbol the rest are
+  // the centre level, silence.
+  size_t fill(uint16_t* samples, size_t count);
+
+  [[nodiscard]] bool is_done() const;
+  [[nodiscard]] uint16_t get_centre_level() const;
+
+private:
+  uint16_t sine_table[1 << AFSK_SINE_TABLE_BITS];
+  uint16_t centre_level;
+
+  // How far each sample moves the tone's phase, and the symbol clock, in 1 / 2^32 of a cycle
+  uint32_t mark_step, space_step, baud_step;
+  uint32_t phase = 0, symbol_phase = 0;
+
+  const uint8_t* symbols = nullptr;
+  size_t symbol_count = 0;
+  size_t symbol_idx = 0;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Audio samples a second, 22 a symbol
+#define AFSK_SAMPLE_RATE_HZ 26400
+// PWM counts per period, a sample is 0 to this. At 200MHz that's a 780kHz carrier, far above anything the radio hears.
+#define AFSK_PWM_TOP 255
+// Samples in each half of the double buffer the DMA plays from, about 10ms
+#define AFSK_BUFFER_SAMPLES 256
+// Frames that can be waiting to go out, and the longest one in symbols, enough for a full APRS packet with two
+// digipeaters
+#define AFSK_QUEUE_FRAMES 4
+#define AFSK_MAX_FRAME_SYMBOLS 3072
+
+/**
+ * Plays AfskModulator's samples out of a PWM pin, paced by a DMA timer at AFSK_SAMPLE_RATE_HZ. Two DMA channels take
+ * turns on two buffers, each chained to the other so the audio never stops between them, and the completion interrupt
+ * (DMA_IRQ_1, shared with the SD card writer) fills the buffer that just finished. queue() only copies the frame in, so
+ * transmitting doesn't hold up whichever core asked for it.
+ *
+ * The interrupt runs on the core that called init(), so that should be the core writing the SD card, core 0, with
+ * queue() called from either. The pin needs an RC low-pass into the radio's mic input.
+ *
+ * There's no PWM on the host, nothing is transmitted there.
+ */
+namespace afsk_transmitter
+{
+  // False if there's no DMA channel or timer free
+  bool init(uint8_t pwm_gpio);
+
+  // symbols is as AfskModulator::start() takes it, and is copied. False if the queue is full or the frame's too long.
+  bool queue(const uint8_t* symbols, size_t symbol_count);
+
+  [[nodiscard]] bool is_transmitting();
+}
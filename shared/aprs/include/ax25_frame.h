@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define AX25_FLAG 0x7E
+#define AX25_CONTROL_UI 0x03
+#define AX25_PID_NO_LAYER_3 0xF0
+
+#define AX25_MAX_CALLSIGN_LEN 6
+#define AX25_MAX_DIGIPEATERS 8
+// APRS keeps the information field to 256 bytes
+#define AX25_MAX_INFO_LEN 256
+
+// Flags sent before the frame, long enough for the radio to key up and the receiver to lock on (about 200ms), and after
+#define AX25_PREAMBLE_FLAGS 30
+#define AX25_TAIL_FLAGS 3
+
+// Symbols a frame can take, bit stuffing adds at most one bit after every five
+#define AX25_MAX_FRAME_SYMBOLS(DIGIPEATER_COUNT, INFO_LEN, PREAMBLE_FLAGS, TAIL_FLAGS) \
+  (((PREAMBLE_FLAGS) + (TAIL_FLAGS)) * 8 + ((2 + (DIGIPEATER_COUNT)) * 7 + 2 + (INFO_LEN) + 2) * 8 * 6 / 5 + 1)
+
+/**
+ * AX.25 UI frames, what APRS packets are, straight to the symbols AfskModulator plays. Every byte goes through once:
+ * the FCS is worked out as it's sent, then the bits are stuffed and NRZI encoded on their way into the caller's
+ * buffer, so nothing is allocated and the frame itself is never stored anywhere.
+ */
+namespace ax25
+{
+  struct Address
+  {
+    // Up to AX25_MAX_CALLSIGN_LEN letters and digits, without the SSID
+    const char* callsign;
+    // 0-15
+    uint8_t ssid;
+  };
+
+  struct UiFrame
+  {
+    Address destination;
+    Address source;
+    const Address* digipeaters;
+    size_t digipeater_count;
+    const uint8_t* info;
+    size_t info_len;
+  };
+
+  // CRC-16/X.25 (reflected 0x1021, starting at and XORed with 0xFFFF), the FCS goes out low byte first
+  [[nodiscard]] uint16_t fcs(const uint8_t* data, size_t len);
+
+  // Symbols as AfskModulator::start() takes them, starting on the mark tone. Returns how many, 0 if an address is
+  // invalid, the info field is too long or the frame doesn't fit in symbol_capacity.
+  size_t encode_ui_frame(const UiFrame& frame, uint8_t* symbols, size_t symbol_capacity,
+                         size_t preamble_flags = AX25_PREAMBLE_FLAGS, size_t tail_flags = AX25_TAIL_FLAGS);
+}
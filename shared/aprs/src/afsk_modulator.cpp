@@ -0,0 +1,73 @@
+#include "afsk_modulator.h"
+
+#include <cmath>
+
+namespace
+{
+  constexpr int PHASE_SHIFT = 32 - AFSK_SINE_TABLE_BITS;
+
+  uint32_t get_step(const uint32_t freq_hz, const uint32_t sample_rate_hz)
+  {
+    return static_cast<uint32_t>((static_cast<uint64_t>(freq_hz) << 32) / sample_rate_hz);
+  }
+}
+
+AfskModulator::AfskModulator(const uint32_t sample_rate_hz, const uint16_t max_level) :
+  centre_level(max_level / 2), mark_step(get_step(AFSK_MARK_HZ, sample_rate_hz)),
+  space_step(get_step(AFSK_SPACE_HZ, sample_rate_hz)), baud_step(get_step(AFSK_BAUD, sample_rate_hz))
+{
+  constexpr size_t table_size = 1 << AFSK_SINE_TABLE_BITS;
+  const float amplitude = static_cast<float>(max_level) / 2;
+  for (size_t i = 0; i < table_size; i++)
+  {
+    const float angle = 2 * static_cast<float>(M_PI) * static_cast<float>(i) / table_size;
+    sine_table[i] = static_cast<uint16_t>(lroundf(amplitude + amplitude * sinf(angle)));
+  }
+}
+
+void AfskModulator::start(const uint8_t* symbols, const size_t symbol_count)
+{
+  this->symbols = symbols;
+  this->symbol_count = symbol_count;
+  symbol_idx = 0;
+  symbol_phase = 0;
+}
+
+size_t AfskModulator::fill(uint16_t* samples, const size_t count)
+{
+  size_t filled = 0;
+  while (filled < count && symbol_idx < symbol_count)
+  {
+    const uint32_t step = symbols[symbol_idx >> 3] >> (symbol_idx & 7) & 1 ? mark_step : space_step;
+
+    // Every sample until the symbol clock wraps is the same tone
+    do
+    {
+      phase += step;
+      samples[filled++] = sine_table[phase >> PHASE_SHIFT];
+      symbol_phase += baud_step;
+    }
+    while (symbol_phase >= baud_step && filled < count);
+
+    if (symbol_phase < baud_step)
+    {
+      symbol_idx++;
+    }
+  }
+
+  for (size_t i = filled; i < count; i++)
+  {
+    samples[i] = centre_level;
+  }
+  return filled;
+}
+
+bool AfskModulator::is_done() const
+{
+  return symbol_idx >= symbol_count;
+}
+
+uint16_t AfskModulator::get_centre_level() const
+{
+  return centre_level;
+}
@@ -0,0 +1,242 @@
+#include "afsk_transmitter.h"
+
+#if PICO_ON_DEVICE
+#include <cstring>
+#include <hardware/clocks.h>
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <hardware/pwm.h>
+#include <hardware/sync.h>
+#include <pico/util/queue.h>
+
+#include "afsk_modulator.h"
+
+namespace
+{
+  struct Frame
+  {
+    uint8_t symbols[(AFSK_MAX_FRAME_SYMBOLS + 7) / 8];
+    size_t symbol_count;
+  };
+
+  Frame frames[AFSK_QUEUE_FRAMES];
+  // Indices into frames, the ones free to queue into and the ones waiting to go out
+  queue_t free_frames, ready_frames;
+  int playing_frame = -1;
+
+  AfskModulator* modulator = nullptr;
+  uint16_t buffers[2][AFSK_BUFFER_SAMPLES];
+  int channels[2] = {-1, -1};
+  dma_channel_config configs[2];
+  uint slice_num = 0;
+
+  // Between queue() on one core and the interrupt on the other
+  spin_lock_t* lock = nullptr;
+  volatile bool is_running = false;
+  // The buffer playing now is the last one
+  bool is_stopping = false;
+
+  // Moves on to the next frame once the one playing is done, false if there isn't one
+  bool next_frame()
+  {
+    if (playing_frame >= 0)
+    {
+      if (!modulator->is_done())
+      {
+        return true;
+      }
+
+      auto frame_idx = static_cast<uint8_t>(playing_frame);
+      queue_try_add(&free_frames, &frame_idx);
+      playing_frame = -1;
+    }
+
+    uint8_t frame_idx;
+    if (!queue_try_remove(&ready_frames, &frame_idx))
+    {
+      return false;
+    }
+
+    playing_frame = frame_idx;
+    modulator->start(frames[frame_idx].symbols, frames[frame_idx].symbol_count);
+    return true;
+  }
+
+  // False if there was nothing left to put in it, it's all silence then. Frames queued back to back run straight on
+  // into each other in the same buffer.
+  bool fill_buffer(const int buffer_idx)
+  {
+    uint16_t* samples = buffers[buffer_idx];
+    size_t filled = 0;
+    while (filled < AFSK_BUFFER_SAMPLES && next_frame())
+    {
+      filled += modulator->fill(samples + filled, AFSK_BUFFER_SAMPLES - filled);
+    }
+
+    for (size_t i = filled; i < AFSK_BUFFER_SAMPLES; i++)
+    {
+      samples[i] = modulator->get_centre_level();
+    }
+    return filled > 0;
+  }
+
+  void arm_channel(const int buffer_idx)
+  {
+    dma_channel_set_read_addr(channels[buffer_idx], buffers[buffer_idx], false);
+    dma_channel_set_trans_count(channels[buffer_idx], AFSK_BUFFER_SAMPLES, false);
+  }
+
+  // With the lock held
+  void start_playback()
+  {
+    if (!fill_buffer(0))
+    {
+      return;
+    }
+    fill_buffer(1);
+
+    for (int i = 0; i < 2; i++)
+    {
+      channel_config_set_chain_to(&configs[i], channels[1 - i]);
+      dma_channel_set_config(channels[i], &configs[i], false);
+      arm_channel(i);
+    }
+
+    is_stopping = false;
+    is_running = true;
+    dma_channel_start(channels[0]);
+  }
+
+  void __isr dma_irq_handler()
+  {
+    for (int i = 0; i < 2; i++)
+    {
+      if (channels[i] < 0 || !dma_channel_get_irq1_status(channels[i]))
+      {
+        continue;
+      }
+      dma_channel_acknowledge_irq1(channels[i]);
+
+      const uint32_t save = spin_lock_blocking(lock);
+      if (is_stopping)
+      {
+        // The last buffer finished, anything queued since it was filled starts over from scratch
+        is_running = false;
+        start_playback();
+      }
+      else if (fill_buffer(i))
+      {
+        // The other channel is playing now, and starts this one again when it's done
+        arm_channel(i);
+      }
+      else
+      {
+        // Nothing's left after the buffer that's playing, so it doesn't start this one again
+        const int other = 1 - i;
+        channel_config_set_chain_to(&configs[other], channels[other]);
+        dma_channel_set_config(channels[other], &configs[other], false);
+        is_stopping = true;
+      }
+      spin_unlock(lock, save);
+    }
+  }
+}
+
+bool afsk_transmitter::init(const uint8_t pwm_gpio)
+{
+  if (modulator)
+  {
+    return true;
+  }
+
+  const int dma_timer = dma_claim_unused_timer(false);
+  channels[0] = dma_claim_unused_channel(false);
+  channels[1] = dma_claim_unused_channel(false);
+  const uint32_t timer_denominator = (clock_get_hz(clk_sys) + AFSK_SAMPLE_RATE_HZ / 2) / AFSK_SAMPLE_RATE_HZ;
+  if (dma_timer < 0 || channels[0] < 0 || channels[1] < 0 || timer_denominator > UINT16_MAX)
+  {
+    return false;
+  }
+
+  // The timer ticks at the system clock times 1 / denominator, the modulator works with the rate that comes out to
+  dma_timer_set_fraction(dma_timer, 1, timer_denominator);
+  modulator = new AfskModulator(clock_get_hz(clk_sys) / timer_denominator, AFSK_PWM_TOP);
+
+  gpio_set_function(pwm_gpio, GPIO_FUNC_PWM);
+  slice_num = pwm_gpio_to_slice_num(pwm_gpio);
+  pwm_config pwm_cfg = pwm_get_default_config();
+  pwm_config_set_wrap(&pwm_cfg, AFSK_PWM_TOP);
+  pwm_init(slice_num, &pwm_cfg, false);
+  pwm_set_both_levels(slice_num, modulator->get_centre_level(), modulator->get_centre_level());
+  pwm_set_enabled(slice_num, true);
+
+  for (int i = 0; i < 2; i++)
+  {
+    configs[i] = dma_channel_get_default_config(channels[i]);
+    channel_config_set_transfer_data_size(&configs[i], DMA_SIZE_16);
+    channel_config_set_read_increment(&configs[i], true);
+    channel_config_set_write_increment(&configs[i], false);
+    channel_config_set_dreq(&configs[i], dma_get_timer_dreq(dma_timer));
+    // A 16 bit write to CC goes to both halves, both channels of the slice get the sample and only the pin's is used
+    dma_channel_configure(channels[i], &configs[i], &pwm_hw->slice[slice_num].cc, buffers[i], AFSK_BUFFER_SAMPLES,
+                          false);
+  }
+
+  queue_init(&free_frames, sizeof(uint8_t), AFSK_QUEUE_FRAMES);
+  queue_init(&ready_frames, sizeof(uint8_t), AFSK_QUEUE_FRAMES);
+  for (uint8_t i = 0; i < AFSK_QUEUE_FRAMES; i++)
+  {
+    queue_try_add(&free_frames, &i);
+  }
+  lock = spin_lock_init(spin_lock_claim_unused(true));
+
+  irq_add_shared_handler(DMA_IRQ_1, dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_1, true);
+  dma_channel_set_irq1_enabled(channels[0], true);
+  dma_channel_set_irq1_enabled(channels[1], true);
+  return true;
+}
+
+bool afsk_transmitter::queue(const uint8_t* symbols, const size_t symbol_count)
+{
+  uint8_t frame_idx;
+  if (!modulator || symbol_count == 0 || symbol_count > AFSK_MAX_FRAME_SYMBOLS ||
+    !queue_try_remove(&free_frames, &frame_idx))
+  {
+    return false;
+  }
+
+  memcpy(frames[frame_idx].symbols, symbols, (symbol_count + 7) / 8);
+  frames[frame_idx].symbol_count = symbol_count;
+  queue_add_blocking(&ready_frames, &frame_idx);
+
+  const uint32_t save = spin_lock_blocking(lock);
+  if (!is_running)
+  {
+    start_playback();
+  }
+  spin_unlock(lock, save);
+  return true;
+}
+
+bool afsk_transmitter::is_transmitting()
+{
+  return is_running;
+}
+#else
+bool afsk_transmitter::init(uint8_t)
+{
+  return false;
+}
+
+bool afsk_transmitter::queue(const uint8_t*, size_t)
+{
+  return false;
+}
+
+bool afsk_transmitter::is_transmitting()
+{
+  return false;
+}
+#endif
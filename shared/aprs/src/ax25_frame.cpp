@@ -0,0 +1,200 @@
+#include "ax25_frame.h"
+
+#include <array>
+
+namespace
+{
+  constexpr std::array<uint16_t, 256> fcs_table = []
+  {
+    std::array<uint16_t, 256> table{};
+    for (uint32_t i = 0; i < table.size(); i++)
+    {
+      auto crc = static_cast<uint16_t>(i);
+      for (int bit = 0; bit < 8; bit++)
+      {
+        crc = crc & 1 ? crc >> 1 ^ 0x8408 : crc >> 1;
+      }
+      table[i] = crc;
+    }
+    return table;
+  }();
+
+  uint16_t update_fcs(const uint16_t crc, const uint8_t byte)
+  {
+    return crc >> 8 ^ fcs_table[(crc ^ byte) & 0xFF];
+  }
+
+  // Each byte goes out lowest bit first. A 0 is sent by switching tone and a 1 by staying on it (NRZI), and after five
+  // 1s in a row inside the frame a 0 is slipped in, so only flags ever have six.
+  class SymbolWriter
+  {
+  public:
+    SymbolWriter(uint8_t* symbols, const size_t capacity) : symbols(symbols), capacity(capacity)
+    {
+    }
+
+    void put_flag()
+    {
+      for (int i = 0; i < 8; i++)
+      {
+        put_bit(AX25_FLAG >> i & 1);
+      }
+      ones_count = 0;
+    }
+
+    // Counts towards the FCS too
+    void put_byte(const uint8_t byte)
+    {
+      crc = update_fcs(crc, byte);
+      put_stuffed_byte(byte);
+    }
+
+    void put_fcs()
+    {
+      const uint16_t fcs = ~crc;
+      put_stuffed_byte(fcs & 0xFF);
+      put_stuffed_byte(fcs >> 8);
+    }
+
+    [[nodiscard]] size_t get_count() const
+    {
+      return is_full ? 0 : count;
+    }
+
+  private:
+    void put_stuffed_byte(const uint8_t byte)
+    {
+      for (int i = 0; i < 8; i++)
+      {
+        const bool bit = byte >> i & 1;
+        put_bit(bit);
+        if (!bit)
+        {
+          ones_count = 0;
+        }
+        else if (++ones_count == 5)
+        {
+          put_bit(false);
+          ones_count = 0;
+        }
+      }
+    }
+
+    void put_bit(const bool bit)
+    {
+      if (count >= capacity)
+      {
+        is_full = true;
+        return;
+      }
+
+      if (!bit)
+      {
+        tone = !tone;
+      }
+
+      const uint8_t mask = 1 << (count & 7);
+      symbols[count >> 3] = tone ? symbols[count >> 3] | mask : symbols[count >> 3] & ~mask;
+      count++;
+    }
+
+    uint8_t* symbols;
+    size_t capacity;
+    size_t count = 0;
+    bool is_full = false;
+
+    // Starts on mark
+    bool tone = true;
+    int ones_count = 0;
+    uint16_t crc = 0xFFFF;
+  };
+
+  bool is_valid(const ax25::Address& address)
+  {
+    if (!address.callsign || address.ssid > 15)
+    {
+      return false;
+    }
+
+    size_t len = 0;
+    for (; address.callsign[len] != '\0'; len++)
+    {
+      const char c = address.callsign[len];
+      if (len == AX25_MAX_CALLSIGN_LEN || (!(c >= 'A' && c <= 'Z') && !(c >= '0' && c <= '9')))
+      {
+        return false;
+      }
+    }
+    return len > 0;
+  }
+
+  // The callsign padded with spaces, everything shifted up a bit, then the SSID. The lowest bit of the last address
+  // marks the end of the address field, and the top bit of the SSID byte is the command/response bit for the
+  // destination and source, and the has-been-repeated bit for a digipeater.
+  void put_address(SymbolWriter& writer, const ax25::Address& address, const bool is_high_bit, const bool is_last)
+  {
+    bool is_padding = false;
+    for (size_t i = 0; i < AX25_MAX_CALLSIGN_LEN; i++)
+    {
+      is_padding = is_padding || address.callsign[i] == '\0';
+      writer.put_byte((is_padding ? ' ' : address.callsign[i]) << 1);
+    }
+    writer.put_byte(is_high_bit << 7 | 0x60 | address.ssid << 1 | is_last);
+  }
+}
+
+uint16_t ax25::fcs(const uint8_t* data, const size_t len)
+{
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++)
+  {
+    crc = update_fcs(crc, data[i]);
+  }
+  return ~crc;
+}
+
+size_t ax25::encode_ui_frame(const UiFrame& frame, uint8_t* symbols, const size_t symbol_capacity,
+                             const size_t preamble_flags, const size_t tail_flags)
+{
+  if (!is_valid(frame.destination) || !is_valid(frame.source) || frame.digipeater_count > AX25_MAX_DIGIPEATERS ||
+    frame.info_len > AX25_MAX_INFO_LEN || (frame.info_len > 0 && !frame.info))
+  {
+    return 0;
+  }
+  for (size_t i = 0; i < frame.digipeater_count; i++)
+  {
+    if (!is_valid(frame.digipeaters[i]))
+    {
+      return 0;
+    }
+  }
+
+  SymbolWriter writer(symbols, symbol_capacity);
+  // At least one flag has to open and close the frame
+  for (size_t i = 0; i < preamble_flags || i == 0; i++)
+  {
+    writer.put_flag();
+  }
+
+  // A command frame, as APRS sends them
+  put_address(writer, frame.destination, true, false);
+  put_address(writer, frame.source, false, frame.digipeater_count == 0);
+  for (size_t i = 0; i < frame.digipeater_count; i++)
+  {
+    put_address(writer, frame.digipeaters[i], false, i == frame.digipeater_count - 1);
+  }
+
+  writer.put_byte(AX25_CONTROL_UI);
+  writer.put_byte(AX25_PID_NO_LAYER_3);
+  for (size_t i = 0; i < frame.info_len; i++)
+  {
+    writer.put_byte(frame.info[i]);
+  }
+  writer.put_fcs();
+
+  for (size_t i = 0; i < tail_flags || i == 0; i++)
+  {
+    writer.put_flag();
+  }
+  return writer.get_count();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <pico/types.h>
+
+// Conversions a second across every captured input, the ADC can do up to 500k
+#define ANALOG_CAPTURE_RATE_HZ 10000
+// The ring holds the last 1 << ANALOG_CAPTURE_RING_BITS conversions
+#define ANALOG_CAPTURE_RING_BITS 10
+// Conversions averaged into one reading by default
+#define ANALOG_CAPTURE_OVERSAMPLE 16
+
+// ADC input of the RP2040's temperature sensor, inputs 0-3 are GPIO 26-29
+#define ANALOG_CAPTURE_TEMP_INPUT 4
+
+/**
+ * Keeps the ADC converting on its own, round robin over every input it was started with, and DMAs the results into a
+ * ring. Reading an input averages its newest conversions out of the ring, nothing waits on the ADC and no conversion
+ * costs any CPU time. While it's running the ADC can't be used for anything else (no adc_read()).
+ *
+ * On the host there's no DMA, a read just does the conversion right then.
+ */
+namespace analog_capture
+{
+  // input_mask has a bit per ADC input (1 << ANALOG_CAPTURE_TEMP_INPUT for the temperature sensor), the GPIOs have to
+  // be set up with adc_gpio_init() already. False if there's no DMA channel free.
+  bool start(uint8_t input_mask, uint32_t rate_hz = ANALOG_CAPTURE_RATE_HZ);
+  void stop();
+
+  [[nodiscard]] bool is_capturing(uint8_t input);
+
+  // Average of the input's newest sample_count conversions (fewer if the ring doesn't have that many yet), as a raw 12
+  // bit result. 0 if it isn't being captured or hasn't been converted yet.
+  uint16_t read_average(uint8_t input, uint sample_count = ANALOG_CAPTURE_OVERSAMPLE);
+}
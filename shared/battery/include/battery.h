@@ -1,10 +1,11 @@
 #pragma once
 
 #include <cstdint>
-#include <deque>
-#include <map>
+#include <memory>
 #include <pico/types.h>
 
+#include "battery_curve.h"
+
 struct PayloadState;
 
 class Battery
@@ -13,17 +14,25 @@ public:
   virtual ~Battery() = default;
   Battery(uint8_t pin, uint sample_count, double bat_scale);
 
+  // Reads a new sample, then averages it with the last sample_count - 1. While analog_capture has the battery's input,
+  // the sample comes from there instead of a conversion of its own.
   double get_voltage();
-  [[nodiscard]] virtual double calc_charge_percent(double voltage) const = 0;
+  // For a sample read somewhere else, averaged in just like get_voltage()'s
+  void add_sample(uint16_t adc_result);
+  [[nodiscard]] double get_average_voltage() const;
 
-protected:
-  static double voltage_map_interp(double voltage, const std::map<double, double>& voltage_map);
+  [[nodiscard]] virtual double calc_charge_percent(double voltage) const = 0;
 
 private:
   uint8_t adc_input;
 
   uint sample_count;
-  double bat_scale;
-
-  std::deque<uint16_t> adc_read_results;
+  // From the sum of the samples to volts at the battery
+  double voltage_scale;
+
+  // Ring of the last sample_count samples, their sum is kept up to date instead of added up every read
+  std::unique_ptr<uint16_t[]> samples;
+  uint next_sample = 0;
+  uint stored_samples = 0;
+  uint32_t sample_sum = 0;
 };
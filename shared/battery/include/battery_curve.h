@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+
+// One point of a battery's discharge curve, charge is 0-1
+struct VoltageCurvePoint
+{
+  double voltage;
+  double charge;
+};
+
+// Checks a curve when it's compiled, so a typo in one can't make it onto a flight
+#define VALIDATE_BATTERY_CURVE(CURVE) \
+  static_assert(battery_curve::is_sorted_by_voltage(CURVE), #CURVE " has to be sorted by voltage, with every voltage in it once"); \
+  static_assert(battery_curve::is_charge_rising(CURVE), #CURVE "'s charge can't go down as its voltage goes up"); \
+  static_assert(battery_curve::is_full_range(CURVE), #CURVE " has to go from 0 charge to 1");
+
+namespace battery_curve
+{
+  template <size_t N>
+  constexpr bool is_sorted_by_voltage(const VoltageCurvePoint (&curve)[N])
+  {
+    for (size_t i = 1; i < N; i++)
+    {
+      if (!(curve[i - 1].voltage < curve[i].voltage))
+      {
+        return false;
+      }
+    }
+    return N >= 2;
+  }
+
+  template <size_t N>
+  constexpr bool is_charge_rising(const VoltageCurvePoint (&curve)[N])
+  {
+    for (size_t i = 1; i < N; i++)
+    {
+      if (curve[i].charge < curve[i - 1].charge)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <size_t N>
+  constexpr bool is_full_range(const VoltageCurvePoint (&curve)[N])
+  {
+    return N > 0 && curve[0].charge == 0 && curve[N - 1].charge == 1;
+  }
+
+  // Charge at voltage, straight lines between the points. Only for a curve that passes VALIDATE_BATTERY_CURVE.
+  constexpr double interpolate(const std::span<const VoltageCurvePoint> curve, double voltage)
+  {
+    // Off either end is the end, which is 0 or 1
+    voltage = std::clamp(voltage, curve.front().voltage, curve.back().voltage);
+
+    // Binary search for the segment the voltage is on, always the same number of steps with a conditional move each
+    // instead of a branch
+    const VoltageCurvePoint* lower = curve.data();
+    for (size_t len = curve.size() - 1; len > 1;)
+    {
+      const size_t half = len / 2;
+      lower = lower[half].voltage <= voltage ? lower + half : lower;
+      len -= half;
+    }
+
+    const VoltageCurvePoint* upper = lower + 1;
+    return lower->charge + (voltage - lower->voltage) / (upper->voltage - lower->voltage) *
+      (upper->charge - lower->charge);
+  }
+}
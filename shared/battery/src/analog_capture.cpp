@@ -0,0 +1,188 @@
+#include "analog_capture.h"
+
+#include <hardware/adc.h>
+
+namespace
+{
+  uint8_t captured_mask = 0;
+}
+
+#if PICO_ON_DEVICE
+#include <hardware/dma.h>
+
+namespace
+{
+  constexpr uint32_t RING_SIZE = 1u << ANALOG_CAPTURE_RING_BITS;
+  // Conversions at the old end of the ring that could be written over while they're being read
+  constexpr uint32_t RING_MARGIN = 16;
+  constexpr uint32_t TRANSFER_COUNT = UINT32_MAX;
+  constexpr float ADC_CLOCK_HZ = 48000000.f;
+  // Cycles a conversion takes, a smaller divider than this is just full speed
+  constexpr float MIN_CLKDIV = 96;
+
+  // The DMA ring wraps at an address boundary the size of the ring
+  alignas(RING_SIZE * sizeof(uint16_t)) uint16_t ring[RING_SIZE];
+  int dma_channel = -1;
+
+  // Which input each conversion of a round is from, in the order the ADC goes through them
+  uint8_t round_inputs[NUM_ADC_CHANNELS];
+  uint32_t round_size = 0;
+
+  void start_conversions()
+  {
+    adc_run(false);
+    dma_channel_abort(dma_channel);
+    adc_fifo_drain();
+
+    // Round robin goes up from the selected input, so starting at the lowest keeps to round_inputs
+    adc_select_input(round_inputs[0]);
+    adc_set_round_robin(captured_mask);
+
+    dma_channel_config config = dma_channel_get_default_config(dma_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_ring(&config, true, ANALOG_CAPTURE_RING_BITS + 1);
+    channel_config_set_dreq(&config, DREQ_ADC);
+    dma_channel_configure(dma_channel, &config, ring, &adc_hw->fifo, TRANSFER_COUNT, true);
+
+    adc_run(true);
+  }
+}
+
+bool analog_capture::start(const uint8_t input_mask, const uint32_t rate_hz)
+{
+  stop();
+
+  round_size = 0;
+  for (uint8_t input = 0; input < NUM_ADC_CHANNELS; input++)
+  {
+    if (input_mask & 1u << input)
+    {
+      round_inputs[round_size++] = input;
+    }
+  }
+
+  if (round_size == 0)
+  {
+    return false;
+  }
+
+  dma_channel = dma_claim_unused_channel(false);
+  if (dma_channel < 0)
+  {
+    return false;
+  }
+
+  captured_mask = input_mask & ((1u << NUM_ADC_CHANNELS) - 1);
+  adc_set_temp_sensor_enabled(captured_mask & 1u << ANALOG_CAPTURE_TEMP_INPUT);
+
+  const float clkdiv = ADC_CLOCK_HZ / static_cast<float>(rate_hz > 0 ? rate_hz : 1) - 1;
+  adc_set_clkdiv(clkdiv < MIN_CLKDIV ? 0 : clkdiv);
+
+  // Every conversion goes through the FIFO to the DMA, error bits and all are left out
+  adc_fifo_setup(true, true, 1, false, false);
+  start_conversions();
+  return true;
+}
+
+void analog_capture::stop()
+{
+  if (dma_channel < 0)
+  {
+    return;
+  }
+
+  adc_run(false);
+  dma_channel_abort(dma_channel);
+  dma_channel_unclaim(dma_channel);
+  dma_channel = -1;
+
+  adc_set_round_robin(0);
+  adc_fifo_setup(false, false, 0, false, false);
+  adc_fifo_drain();
+  adc_set_temp_sensor_enabled(false);
+  captured_mask = 0;
+}
+
+uint16_t analog_capture::read_average(const uint8_t input, const uint sample_count)
+{
+  if (!is_capturing(input) || sample_count == 0)
+  {
+    return 0;
+  }
+
+  // It only stops after UINT32_MAX conversions, days at the default rate
+  if (!dma_channel_is_busy(dma_channel))
+  {
+    start_conversions();
+  }
+
+  const uint32_t converted = TRANSFER_COUNT - dma_channel_hw_addr(dma_channel)->transfer_count;
+  if (converted == 0)
+  {
+    return 0;
+  }
+
+  uint32_t round_pos = 0;
+  while (round_inputs[round_pos] != input)
+  {
+    round_pos++;
+  }
+
+  // Newest conversion of this input, then back a round at a time
+  uint32_t conversion = (converted - 1) / round_size * round_size + round_pos;
+  if (conversion >= converted)
+  {
+    if (conversion < round_size)
+    {
+      return 0;
+    }
+    conversion -= round_size;
+  }
+
+  const uint32_t oldest = converted > RING_SIZE - RING_MARGIN ? converted - (RING_SIZE - RING_MARGIN) : 0;
+  uint32_t sum = 0, count = 0;
+  while (count < sample_count && conversion >= oldest)
+  {
+    sum += ring[conversion % RING_SIZE];
+    count++;
+
+    if (conversion < round_size)
+    {
+      break;
+    }
+    conversion -= round_size;
+  }
+
+  return count > 0 ? static_cast<uint16_t>((sum + count / 2) / count) : 0;
+}
+#else
+bool analog_capture::start(const uint8_t input_mask, uint32_t)
+{
+  captured_mask = input_mask & ((1u << NUM_ADC_CHANNELS) - 1);
+  return captured_mask != 0;
+}
+
+void analog_capture::stop()
+{
+  captured_mask = 0;
+}
+
+uint16_t analog_capture::read_average(const uint8_t input, uint)
+{
+  if (!is_capturing(input))
+  {
+    return 0;
+  }
+
+  // Nothing converts in the background on the host, the shim's value is all there is to average
+  adc_select_input(input);
+  return adc_read();
+}
+#endif
+
+bool analog_capture::is_capturing(const uint8_t input)
+{
+  return input < NUM_ADC_CHANNELS && captured_mask & 1u << input;
+}
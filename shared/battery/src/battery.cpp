@@ -1,15 +1,18 @@
 #include "battery.h"
 
-#include <cmath>
-#include <format>
-#include <vector>
-#include <bits/stl_algo.h>
+#include <algorithm>
+#include <cassert>
 #include <hardware/adc.h>
 
-#include "usb_comm.h"
+#include "analog_capture.h"
 
-Battery::Battery(uint8_t pin, uint sample_count, double bat_scale) : sample_count(sample_count), bat_scale(bat_scale)
+Battery::Battery(uint8_t pin, uint sample_count, double bat_scale) : sample_count(std::max<uint>(sample_count, 1)),
+                                                                      samples(new uint16_t[this->sample_count])
 {
+  // Divide by 16 is kind of like dropping the last 4 bits off the end (12 bit adc, also cf = vref / 1 << (12-4))
+  constexpr double conversion_factor = 3.3f / (1 << 8);
+  voltage_scale = conversion_factor / 16 * bat_scale; // we only read 32% of voltage
+
   if (pin == 26)
   {
     adc_input = 0;
@@ -30,56 +33,45 @@ Battery::Battery(uint8_t pin, uint sample_count, double bat_scale) : sample_coun
 
 double Battery::get_voltage()
 {
-  if (adc_get_selected_input() != adc_input)
-  {
-    adc_select_input(adc_input);
-  }
-
-  if (adc_read_results.size() == sample_count)
+  // The capture service already has conversions waiting, each sample is an average of several of them
+  if (analog_capture::is_capturing(adc_input))
   {
-    adc_read_results.pop_front();
+    add_sample(analog_capture::read_average(adc_input));
+    return get_average_voltage();
   }
 
-  const uint16_t result = adc_read();
-  adc_read_results.push_back(result);
-
-  uint32_t result_sum = 0;
-  for (const uint16_t result_sample : adc_read_results)
+  if (adc_get_selected_input() != adc_input)
   {
-    result_sum += result_sample;
+    adc_select_input(adc_input);
   }
-  const double average_result = static_cast<double>(result_sum) / adc_read_results.size();
 
-  // Divide by 16 is kind of like dropping the last 4 bits off the end (12 bit adc, also cf = vref / 1 << (12-4))
-  constexpr double conversion_factor = 3.3f / (1 << 8);
-  const double voltage_result = average_result / 16 * conversion_factor;
-
-  return voltage_result * bat_scale; // we only read 32% of voltage
+  add_sample(adc_read());
+  return get_average_voltage();
 }
 
-double Battery::voltage_map_interp(const double voltage, const std::map<double, double>& voltage_map)
+void Battery::add_sample(const uint16_t adc_result)
 {
-  if (voltage <= voltage_map.begin()->first)
+  // The oldest sample is swapped out of the sum for the new one
+  if (stored_samples == sample_count)
   {
-    return 0;
+    sample_sum -= samples[next_sample];
   }
-
-  if (voltage >= voltage_map.rbegin()->first)
+  else
   {
-    return 1;
+    stored_samples++;
   }
 
-  const auto upper = voltage_map.lower_bound(voltage);
-  if (upper->first == voltage || upper == voltage_map.begin())
+  samples[next_sample] = adc_result;
+  sample_sum += adc_result;
+  next_sample = next_sample + 1 == sample_count ? 0 : next_sample + 1;
+}
+
+double Battery::get_average_voltage() const
+{
+  if (stored_samples == 0)
   {
-    return upper->second;
+    return 0;
   }
 
-  const auto lower = std::prev(upper);
-
-  const double v1 = lower->first, p1 = lower->second;
-  const double v2 = upper->first, p2 = upper->second;
-
-  const double percent = p1 + ((voltage - v1) / (v2 - v1)) * (p2 - p1);
-  return percent;
+  return static_cast<double>(sample_sum) * voltage_scale / stored_samples;
 }
@@ -1,11 +1,16 @@
 #include "ovonic_battery.h"
 
-#include <cmath>
-#include <algorithm>
-#include <map>
-
-#include "usb_comm.h"
-
+namespace
+{
+  // From the recorded discharge, sorted by voltage. Where a voltage was recorded more than once it gets the average of
+  // its charges, except 6.7 which is the bottom of the curve. 8.4 and 6.8 were recorded as 0.1 and 0.9, where 1 and
+  // 0.09 fit between their neighbors.
+  constexpr VoltageCurvePoint voltage_curve[] = {
+    {6.7, 0.0}, {6.8, 0.09}, {6.9, 0.14}, {7.0, 0.22}, {7.1, 0.325}, {7.2, 0.435}, {7.3, 0.52}, {7.4, 0.595},
+    {7.5, 0.68}, {7.7, 0.73}, {7.8, 0.78}, {7.9, 0.84}, {8.0, 0.89}, {8.1, 0.95}, {8.4, 1}
+  };
+  VALIDATE_BATTERY_CURVE(voltage_curve)
+}
 
 OvonicBattery::OvonicBattery(const uint8_t pin, const uint sample_count) : Battery(pin, sample_count, 3.125)
 {
@@ -13,11 +18,5 @@ OvonicBattery::OvonicBattery(const uint8_t pin, const uint sample_count) : Batte
 
 double OvonicBattery::calc_charge_percent(const double voltage) const
 {
-  static const std::map<double, double> voltage_map = {
-    {8.4, 0.1}, {8.1, 0.95}, {8.0, 0.89}, {7.9, 0.84}, {7.8, 0.78}, {7.7, 0.73}, {7.5, 0.68}, {7.4, 0.62}, {7.4, 0.57},
-    {7.3, 0.52}, {7.2, 0.46}, {7.2, 0.41}, {7.1, 0.35}, {7.1, 0.30}, {7.0, 0.25}, {7.0, 0.19}, {6.9, 0.14}, {6.8, 0.9},
-    {6.7, 0.3}, {6.7, 0.0}
-  };
-
-  return voltage_map_interp(voltage, voltage_map);
+  return battery_curve::interpolate(voltage_curve, voltage);
 }
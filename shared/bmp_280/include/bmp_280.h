@@ -5,6 +5,7 @@
 
 #define BMP_280_CHIP_ID 0x58
 #define BMP_280_RESET_VALUE 0xB6
+#define BMP_280_ADC_RESET_VALUE 0x80000
 
 class BMP280
 {
@@ -80,6 +81,10 @@ public:
   bool read_calibration_data();
   bool read_press_temp_alt(int32_t& pressure, double& temperature, double& altitude, double sea_level_pressure) const;
 
+  // Double precision compensation from the datasheet, separate from the bus so it can be benchmarked on its own
+  static void compensate(int32_t pressure_adc, int32_t temperature_adc, const CalibrationData& calibration,
+                         double sea_level_pressure, int32_t& pressure, double& temperature, double& altitude);
+
 private:
   // 2-byte registers
   static constexpr uint8_t REG_DIG_T1 = 0x88;
@@ -42,8 +42,8 @@ bool BMP280::check_status(bool& is_measuring, bool& is_updating) const
     return false;
   }
 
-  is_measuring = read_status & 0b1000 == 0;
-  is_updating = read_status & 0b1 == 0;
+  is_measuring = (read_status & 0b1000) != 0;
+  is_updating = (read_status & 0b1) != 0;
   return true;
 }
 
@@ -110,35 +110,46 @@ bool BMP280::read_press_temp_alt(int32_t& pressure, double& temperature, double&
     return false;
   }
 
-  // Do not touch or try to simplify... otherwise you'll have weird overflow things
-  // ReSharper disable All
   const int32_t pressure_adc = raw_data[0] << 12 | raw_data[1] << 4 | raw_data[2] >> 4;
   const int32_t temperature_adc = raw_data[3] << 12 | raw_data[4] << 4 | raw_data[5] >> 4;
-  double var1 = (((double)temperature_adc) / 16384.0 - ((double)calibration_data.dig_T1) / 1024.0) * ((double)
-    calibration_data.dig_T2);
-  double var2 = ((((double)temperature_adc) / 131072.0 - ((double)calibration_data.dig_T1) / 8192.0) * (((double)
-    temperature_adc) / 131072.0 - ((double)calibration_data.dig_T1) / 8192.0)) * ((double)calibration_data.dig_T3);
+  if (pressure_adc == BMP_280_ADC_RESET_VALUE || temperature_adc == BMP_280_ADC_RESET_VALUE)
+  {
+    // Nothing has been converted since the settings changed (or power on), or the measurement is skipped
+    return false;
+  }
+
+  compensate(pressure_adc, temperature_adc, calibration_data, sea_level_pressure, pressure, temperature, altitude);
+  return true;
+}
+
+void BMP280::compensate(const int32_t pressure_adc, const int32_t temperature_adc, const CalibrationData& calibration,
+                        const double sea_level_pressure, int32_t& pressure, double& temperature, double& altitude)
+{
+  // Do not touch or try to simplify... otherwise you'll have weird overflow things
+  // ReSharper disable All
+  double var1 = (((double)temperature_adc) / 16384.0 - ((double)calibration.dig_T1) / 1024.0) * ((double)
+    calibration.dig_T2);
+  double var2 = ((((double)temperature_adc) / 131072.0 - ((double)calibration.dig_T1) / 8192.0) * (((double)
+    temperature_adc) / 131072.0 - ((double)calibration.dig_T1) / 8192.0)) * ((double)calibration.dig_T3);
   const auto t_fine = static_cast<int32_t>(var1 + var2);
   temperature = (var1 + var2) / 5120.0;
 
   var1 = ((double)t_fine / 2.0) - 64000.0;
-  var2 = var1 * var1 * ((double)calibration_data.dig_P6) / 32768.0;
-  var2 = var2 + var1 * ((double)calibration_data.dig_P5) * 2.0;
-  var2 = (var2 / 4.0) + (((double)calibration_data.dig_P4) * 65536.0);
-  var1 = (((double)calibration_data.dig_P3) * var1 * var1 / 524288.0 + ((double)calibration_data.dig_P2) * var1) /
+  var2 = var1 * var1 * ((double)calibration.dig_P6) / 32768.0;
+  var2 = var2 + var1 * ((double)calibration.dig_P5) * 2.0;
+  var2 = (var2 / 4.0) + (((double)calibration.dig_P4) * 65536.0);
+  var1 = (((double)calibration.dig_P3) * var1 * var1 / 524288.0 + ((double)calibration.dig_P2) * var1) /
     524288.0;
-  var1 = (1.0 + var1 / 32768.0) * ((double)calibration_data.dig_P1);
+  var1 = (1.0 + var1 / 32768.0) * ((double)calibration.dig_P1);
   double p = 1048576.0 - (double)pressure_adc;
   p = (p - (var2 / 4096.0)) * 6250.0 / var1;
-  var1 = ((double)calibration_data.dig_P9) * p * p / 2147483648.0;
-  var2 = p * ((double)calibration_data.dig_P8) / 32768.0;
-  p = p + (var1 + var2 + ((double)calibration_data.dig_P7)) / 16.0;
+  var1 = ((double)calibration.dig_P9) * p * p / 2147483648.0;
+  var2 = p * ((double)calibration.dig_P8) / 32768.0;
+  p = p + (var1 + var2 + ((double)calibration.dig_P7)) / 16.0;
 
   pressure = static_cast<int32_t>(std::round(p));
   altitude = 44330.0 * (1 - std::pow(p / sea_level_pressure, 1 / 5.255));
   // ReSharper restore All
-
-  return true;
 }
 
 bool BMP280::read_byte(const uint8_t reg_addr, uint8_t& value) const
@@ -193,28 +204,31 @@ bool BMP280::read_bytes(const uint8_t reg_addr, uint8_t* data, const size_t len)
   return true;
 }
 
-bool BMP280::write_bytes_to_device(uint8_t start_reg_addr, const uint8_t* data, const size_t len) const
+bool BMP280::write_bytes_to_device(const uint8_t start_reg_addr, const uint8_t* data, const size_t len) const
 {
-  if (is_i2c_interface)
-  {
-    i2c_write_blocking_until(i2c_inst, i2c_addr, &start_reg_addr, 1, false,
-                             delayed_by_ms(get_absolute_time(), 5));
-    const size_t bytes_written = i2c_write_blocking_until(i2c_inst, i2c_addr, data, len, false,
-                                                          delayed_by_ms(get_absolute_time(), 5 * len));
-    return bytes_written == len;
-  }
-
-  // SPI
+  // Both interfaces write register/data pairs, there's no auto-increment when writing
   const size_t write_len = len * 2;
   uint8_t write_data[write_len];
 
   for (size_t idx = 0, i = 0; i < len; idx += 2, i++)
   {
     write_data[idx] = static_cast<uint8_t>(start_reg_addr + static_cast<uint8_t>(i));
-    write_data[idx] &= 0x7F;
     write_data[idx + 1] = data[i];
   }
 
+  if (is_i2c_interface)
+  {
+    const int bytes_written = i2c_write_blocking_until(i2c_inst, i2c_addr, write_data, write_len, false,
+                                                       delayed_by_ms(get_absolute_time(), 5 * len));
+    return bytes_written == static_cast<int>(write_len);
+  }
+
+  // SPI
+  for (size_t idx = 0; idx < write_len; idx += 2)
+  {
+    write_data[idx] &= 0x7F;
+  }
+
   gpio_put(csn_pin, false);
   busy_wait_us(1);
 
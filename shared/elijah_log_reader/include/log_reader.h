@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "communication_channel.h"
+#include "data_type.h"
+#include "log_level.h"
+
+namespace elijah_state_framework::log_reader
+{
+  struct LoggedVariable
+  {
+    uint8_t variable_id;
+    std::string display_name;
+    std::string display_unit;
+    size_t data_offset;
+    DataType data_type;
+  };
+
+  struct LoggedPersistentEntry
+  {
+    uint8_t key_id;
+    DataType data_type;
+
+    // Byte offset for fixed size entries, index for strings
+    size_t offset;
+    std::string display_name;
+  };
+
+  struct LoggedFault
+  {
+    uint8_t fault_bit;
+    bool is_com_channel;
+    CommunicationChannel communication_channel;
+    std::string fault_name;
+  };
+
+  struct LogMetadata
+  {
+    std::string application_name;
+
+    std::vector<LoggedVariable> variables;
+    size_t state_size = 0;
+
+    std::vector<LoggedPersistentEntry> persistent_entries;
+    std::vector<std::string> persistent_values;
+
+    std::vector<LoggedFault> faults;
+    uint32_t initial_faults = 0;
+
+    uint8_t initial_phase = 0;
+    std::string initial_phase_name;
+
+    [[nodiscard]] const LoggedVariable* find_variable(const std::string& display_name) const;
+  };
+
+  struct LogMessagePacket
+  {
+    LogLevel log_level;
+    std::string message;
+  };
+
+  struct StateUpdatePacket
+  {
+    uint64_t seq;
+    uint64_t us_since_boot;
+
+    // Encoded state, read values out with the variables in the metadata. Points into the log itself, so it's only valid
+    // until the reader opens or loads another one. A state from a StateBatch or ColumnBlock packet is rebuilt by the
+    // reader instead, and is only valid until the batch after the one it's from is read.
+    std::span<const uint8_t> data;
+  };
+
+  struct PersistentStateUpdatePacket
+  {
+    // In the same order as the metadata's persistent entries
+    std::vector<std::string> values;
+  };
+
+  struct MetadataPacket
+  {
+    LogMetadata metadata;
+  };
+
+  struct DeviceRestartPacket
+  {
+  };
+
+  struct FaultsChangedPacket
+  {
+    uint8_t fault_bit;
+    uint32_t faults;
+    std::string message;
+  };
+
+  struct PhaseChangedPacket
+  {
+    uint8_t phase;
+    std::string phase_name;
+  };
+
+  struct LogIndexEntry
+  {
+    uint64_t seq;
+    uint64_t us_since_boot;
+
+    // Start of a packet, pass to LogReader::seek() to decode from here
+    size_t offset;
+    uint32_t faults;
+    uint8_t phase;
+
+    // Counted from where the sequence starts over, so a boot that didn't log any states isn't counted
+    uint32_t boot;
+  };
+
+  struct LogIndexPacket
+  {
+    size_t previous_index_offset;
+    std::vector<LogIndexEntry> entries;
+  };
+
+  using LogPacket = std::variant<LogMessagePacket, StateUpdatePacket, PersistentStateUpdatePacket, MetadataPacket,
+                                 DeviceRestartPacket, FaultsChangedPacket, PhaseChangedPacket, LogIndexPacket>;
+
+  // Reads packets back out of a log written by StateFrameworkLogger, packets aren't length prefixed so the metadata
+  // has to be read before any state or persistent data can be
+  class LogReader
+  {
+  public:
+    LogReader() = default;
+    ~LogReader();
+
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    // Maps the file rather than reading it in, so nothing is copied until a packet is read
+    bool open(const std::string& file_path);
+    void load(std::vector<uint8_t> log_data);
+
+    // False once the end of the log is reached, or the log can't be read any further (see get_error())
+    bool read_packet(LogPacket& packet);
+
+    // Every index entry in the log, in file order. False if the log doesn't have an index (older logs, or one that
+    // lost power before the first index was flushed), decode from the start instead.
+    bool read_index(std::vector<LogIndexEntry>& entries) const;
+
+    // Continues decoding from offset, which has to be the start of a packet (an index entry's offset). Reads the
+    // metadata first if it hasn't been yet.
+    bool seek(size_t offset);
+
+    // Only these variables are read out of column blocks, their other columns are skipped and left 0 in the states.
+    // _sequence and _us_since_boot are always read. Empty, the default, reads all of them. A state logged as a row
+    // always has every variable.
+    void select_variables(std::vector<std::string> display_names);
+    // Column blocks without a state in this range (by their _us_since_boot column's min and max) are skipped instead
+    // of read. Whatever is read can still be outside of it, the states in a block that is read and rows aren't checked.
+    void set_time_range(uint64_t from_us, uint64_t to_us);
+
+    [[nodiscard]] bool has_metadata() const;
+    [[nodiscard]] const LogMetadata& get_metadata() const;
+
+    [[nodiscard]] size_t get_position() const;
+    [[nodiscard]] size_t get_size() const;
+    [[nodiscard]] const std::string& get_error() const;
+
+    // Power can go out part way through a flush, so a log ending in the middle of a packet (or a commit record that
+    // doesn't check out) isn't corrupt, the tail is just lost. Everything before get_truncated_position() was read.
+    [[nodiscard]] bool is_truncated() const;
+    [[nodiscard]] size_t get_truncated_position() const;
+
+  private:
+    // Either the mapped file or owned_data
+    const uint8_t* data = nullptr;
+    std::vector<uint8_t> owned_data;
+    void* mapped_data = nullptr;
+    size_t mapped_size = 0;
+
+    size_t size = 0;
+    size_t pos = 0;
+    size_t end = 0;
+    size_t packet_start = 0;
+    bool did_truncate = false;
+
+    // Seeds the commit records' CRCs, 0 for logs from before them
+    uint32_t segment_key = 0;
+
+    // States of the last StateBatch packet, handed out one per read_packet(). The position stays at the start of the
+    // batch until the last one. The batch before is kept around too, see StateUpdatePacket::data.
+    std::vector<uint8_t> batch_states[2];
+    size_t batch_buffer = 0;
+    size_t batch_count = 0;
+    size_t batch_next = 0;
+    size_t batch_end = 0;
+    // Set by a packet that didn't give anything to read, like a skipped column block, read_packet() moves on
+    bool did_skip = false;
+
+    std::vector<std::string> selected_names;
+    uint64_t from_us = 0;
+    uint64_t to_us = UINT64_MAX;
+    // Variables read out of column blocks by id, nullptr for the ones that are skipped
+    std::vector<const LoggedVariable*> column_variables;
+
+    bool did_read_metadata = false;
+    LogMetadata metadata;
+
+    // Every state starts with these two (see START_STATE_ENCODER), found once per metadata instead of every state
+    const LoggedVariable* seq_variable = nullptr;
+    const LoggedVariable* us_since_boot_variable = nullptr;
+
+    std::string error;
+
+    void start_reading(const uint8_t* log_data, size_t log_size);
+    void unmap();
+
+    // Just past the commit record at record_pos if it's complete before limit and its CRC checks out, otherwise 0
+    [[nodiscard]] size_t get_record_end(size_t record_pos, size_t limit) const;
+
+    bool fail(const std::string& message);
+    bool truncated(const std::string& message);
+
+    bool read_bytes(void* dest, size_t len);
+    bool read_string(std::string& dest);
+    bool read_offset(size_t& dest, uint8_t offset_size);
+
+    template <typename T>
+    bool read_value(T& dest)
+    {
+      return read_bytes(&dest, sizeof(T));
+    }
+
+    bool read_next_packet(LogPacket& packet);
+    bool read_state_batch(LogPacket& packet);
+    bool read_column_block(LogPacket& packet);
+    void select_columns();
+    bool start_batch(size_t count, LogPacket& packet);
+    void next_batched_state(LogPacket& packet);
+    bool read_index_entries(std::vector<LogIndexEntry>& dest);
+    bool read_metadata(LogMetadata& dest);
+    bool read_persistent_values(const LogMetadata& layout, std::vector<std::string>& dest);
+  };
+
+  [[nodiscard]] double get_numeric_value(const LoggedVariable& variable, const uint8_t* state_data);
+  [[nodiscard]] tm get_time_value(const LoggedVariable& variable, const uint8_t* state_data);
+  [[nodiscard]] std::string format_value(const LoggedVariable& variable, const uint8_t* state_data);
+}
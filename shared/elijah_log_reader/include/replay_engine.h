@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+#include <pico/time.h>
+
+#include "log_reader.h"
+
+// How long the states before a phase change have to have been logged without a gap for its timing to be compared,
+// the standard controller's trend and pad windows
+#define REPLAY_FULL_RATE_LEAD_US 1000000
+
+namespace elijah_state_framework::log_reader
+{
+  struct ReplayPhaseChange
+  {
+    uint64_t seq;
+    uint64_t us_since_boot;
+    uint8_t phase;
+    // Every state for REPLAY_FULL_RATE_LEAD_US up to it was logged, so the controller saw what it did in flight.
+    // Otherwise it ran on decimated states, and when it fired says more about the gaps than about detection.
+    bool is_full_rate;
+  };
+
+  struct ReplayFaultChange
+  {
+    uint64_t seq;
+    uint64_t us_since_boot;
+    uint32_t faults;
+  };
+
+  struct ReplayResult
+  {
+    size_t state_count = 0;
+    double elapsed_s = 0;
+    double states_per_second = 0;
+
+    // What the framework decided during the replay, next to what the device decided during the recording
+    std::vector<ReplayPhaseChange> replayed_phase_changes;
+    std::vector<ReplayPhaseChange> logged_phase_changes;
+    std::vector<ReplayFaultChange> replayed_fault_changes;
+
+    // Places where states are missing between two that were logged (decimated, or lost), and how many are missing
+    size_t gap_count = 0;
+    uint64_t missing_state_count = 0;
+    uint64_t longest_gap_us = 0;
+
+    // States whose sequence or time didn't move forward from the one before, within a boot. They aren't replayed.
+    size_t out_of_order_count = 0;
+    uint64_t first_out_of_order_seq = 0;
+    uint64_t first_out_of_order_after_seq = 0;
+
+    std::string error;
+  };
+
+  // Turns logged states back into the framework's state type, load_metadata() is called whenever a log's metadata is
+  // read so lookups by variable name can be done once
+  template <typename TDecoder, typename TStateData>
+  concept StateDecoder = requires(TDecoder decoder, const LogMetadata& metadata, const StateUpdatePacket& packet,
+                                  TStateData& state)
+  {
+    { decoder.load_metadata(metadata) } -> std::same_as<bool>;
+    decoder.decode(packet, state);
+  };
+
+  // Feeds every state in a log through a framework's state_changed(). The host clock is moved to each state's logged
+  // time, so the framework sees the same timing it did in flight, however fast the replay runs. States that go back in
+  // sequence or time are skipped and counted, the framework (and its clock) only ever sees them in order.
+  template <typename TFramework, typename TStateData, StateDecoder<TStateData> TDecoder>
+  class ReplayEngine
+  {
+  public:
+    ReplayEngine(TFramework* framework, TDecoder* decoder);
+
+    ReplayResult replay(LogReader& reader);
+
+  private:
+    TFramework* framework;
+    TDecoder* decoder;
+  };
+}
+
+template <typename TFramework, typename TStateData, elijah_state_framework::log_reader::StateDecoder<TStateData> TDecoder>
+elijah_state_framework::log_reader::ReplayEngine<TFramework, TStateData, TDecoder>::ReplayEngine(
+  TFramework* framework, TDecoder* decoder) : framework(framework), decoder(decoder)
+{
+}
+
+template <typename TFramework, typename TStateData, elijah_state_framework::log_reader::StateDecoder<TStateData> TDecoder>
+elijah_state_framework::log_reader::ReplayResult elijah_state_framework::log_reader::ReplayEngine<
+  TFramework, TStateData, TDecoder>::replay(LogReader& reader)
+{
+  ReplayResult result;
+  host_time_set_manual(true);
+
+  bool can_decode = false;
+  auto last_snapshot = framework->get_latest_snapshot();
+  uint64_t last_seq = 0, last_us_since_boot = 0;
+  // Nothing to compare the first state of a boot with
+  bool has_last_state = false;
+  // When the states started coming in without gaps
+  uint64_t full_rate_start_us = 0;
+  bool is_full_rate = false;
+  TStateData state{};
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  LogPacket packet;
+  while (reader.read_packet(packet))
+  {
+    if (const auto* metadata_packet = std::get_if<MetadataPacket>(&packet))
+    {
+      can_decode = decoder->load_metadata(metadata_packet->metadata);
+      if (!can_decode)
+      {
+        result.error = "Log metadata is missing variables the decoder needs";
+        break;
+      }
+    }
+    else if (std::holds_alternative<DeviceRestartPacket>(packet))
+    {
+      // The sequence and clock start over
+      has_last_state = false;
+    }
+    else if (const auto* phase_changed = std::get_if<PhaseChangedPacket>(&packet))
+    {
+      // Phase changes are logged right after the state that caused them
+      result.logged_phase_changes.push_back({last_seq, last_us_since_boot, phase_changed->phase, is_full_rate});
+    }
+    else if (const auto* state_update = std::get_if<StateUpdatePacket>(&packet))
+    {
+      if (!can_decode)
+      {
+        continue;
+      }
+
+      if (has_last_state && (state_update->seq <= last_seq || state_update->us_since_boot <= last_us_since_boot))
+      {
+        if (result.out_of_order_count++ == 0)
+        {
+          result.first_out_of_order_seq = state_update->seq;
+          result.first_out_of_order_after_seq = last_seq;
+        }
+        continue;
+      }
+
+      if (has_last_state && state_update->seq == last_seq + 1)
+      {
+        is_full_rate = state_update->us_since_boot - full_rate_start_us >= REPLAY_FULL_RATE_LEAD_US;
+      }
+      else
+      {
+        if (has_last_state)
+        {
+          result.gap_count++;
+          result.missing_state_count += state_update->seq - last_seq - 1;
+          result.longest_gap_us = std::max(result.longest_gap_us, state_update->us_since_boot - last_us_since_boot);
+        }
+        full_rate_start_us = state_update->us_since_boot;
+        is_full_rate = false;
+      }
+
+      has_last_state = true;
+      last_seq = state_update->seq;
+      last_us_since_boot = state_update->us_since_boot;
+
+      host_time_set_us(state_update->us_since_boot);
+      decoder->decode(*state_update, state);
+      framework->state_changed(state);
+      result.state_count++;
+
+      const auto snapshot = framework->get_latest_snapshot();
+      if (snapshot.phase != last_snapshot.phase)
+      {
+        result.replayed_phase_changes.push_back({
+          state_update->seq, state_update->us_since_boot, static_cast<uint8_t>(snapshot.phase), is_full_rate
+        });
+      }
+      if (snapshot.faults != last_snapshot.faults)
+      {
+        result.replayed_fault_changes.push_back({state_update->seq, state_update->us_since_boot, snapshot.faults});
+      }
+      last_snapshot = snapshot;
+    }
+  }
+
+  result.elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  result.states_per_second = result.elapsed_s > 0 ? static_cast<double>(result.state_count) / result.elapsed_s : 0;
+
+  if (result.error.empty())
+  {
+    result.error = reader.get_error();
+  }
+
+  return result;
+}
@@ -0,0 +1,1009 @@
+#include "log_reader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <ranges>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "log_commit.h"
+#include "log_index.h"
+#include "metadata_segment.h"
+#include "output_packet.h"
+#include "state_batcher.h"
+#include "usb_comm.h"
+
+using namespace elijah_state_framework;
+
+const log_reader::LoggedVariable* log_reader::LogMetadata::find_variable(const std::string& display_name) const
+{
+  for (const LoggedVariable& variable : variables)
+  {
+    if (variable.display_name == display_name)
+    {
+      return &variable;
+    }
+  }
+  return nullptr;
+}
+
+log_reader::LogReader::~LogReader()
+{
+  unmap();
+}
+
+bool log_reader::LogReader::open(const std::string& file_path)
+{
+  unmap();
+  owned_data.clear();
+  error.clear();
+
+  const int fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    start_reading(nullptr, 0);
+    error = "Could not open " + file_path;
+    return false;
+  }
+
+  struct stat file_stat{};
+  if (fstat(fd, &file_stat) != 0)
+  {
+    close(fd);
+    start_reading(nullptr, 0);
+    error = "Could not stat " + file_path;
+    return false;
+  }
+
+  const auto file_size = static_cast<size_t>(file_stat.st_size);
+  if (file_size > 0)
+  {
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+      close(fd);
+      start_reading(nullptr, 0);
+      error = "Could not map " + file_path;
+      return false;
+    }
+
+    // Packets are only ever read front to back
+    madvise(mapping, file_size, MADV_SEQUENTIAL);
+    mapped_data = mapping;
+    mapped_size = file_size;
+  }
+  close(fd);
+
+  start_reading(static_cast<const uint8_t*>(mapped_data), mapped_size);
+  return error.empty();
+}
+
+void log_reader::LogReader::load(std::vector<uint8_t> log_data)
+{
+  unmap();
+  owned_data = std::move(log_data);
+  start_reading(owned_data.data(), owned_data.size());
+}
+
+void log_reader::LogReader::start_reading(const uint8_t* log_data, const size_t log_size)
+{
+  data = log_data;
+  size = log_size;
+  did_read_metadata = false;
+  metadata = LogMetadata();
+  seq_variable = us_since_boot_variable = nullptr;
+  did_truncate = false;
+  batch_count = batch_next = 0;
+  error.clear();
+
+  uint64_t header;
+  if (log_size < sizeof(header))
+  {
+    pos = end = packet_start = 0;
+    segment_key = 0;
+    fail("Log is too short to have a header");
+    return;
+  }
+
+  // Anything after the logged position was never confirmed as written
+  memcpy(&header, data, sizeof(header));
+  const uint64_t next_log_pos = internal::get_segment_header_pos(header);
+  segment_key = internal::get_segment_header_key(header);
+  pos = packet_start = sizeof(header);
+  end = next_log_pos >= sizeof(header) && next_log_pos <= log_size ? next_log_pos : log_size;
+
+  // Unless it's followed by complete records, the header is only updated every so often
+  if (segment_key != 0)
+  {
+    size_t record_end;
+    while ((record_end = get_record_end(end, log_size)) > 0)
+    {
+      end = record_end;
+    }
+  }
+}
+
+void log_reader::LogReader::unmap()
+{
+  if (mapped_data)
+  {
+    munmap(mapped_data, mapped_size);
+    mapped_data = nullptr;
+    mapped_size = 0;
+  }
+}
+
+bool log_reader::LogReader::read_packet(LogPacket& packet)
+{
+  // Skipping can go on for a lot of packets in a row, so it's a loop instead of read_next_packet() calling itself
+  bool did_read;
+  do
+  {
+    did_skip = false;
+    did_read = read_next_packet(packet);
+  }
+  while (did_read && did_skip);
+
+  return did_read;
+}
+
+bool log_reader::LogReader::read_next_packet(LogPacket& packet)
+{
+  if (error.empty() && batch_next < batch_count)
+  {
+    next_batched_state(packet);
+    return true;
+  }
+
+  if (!error.empty() || pos >= end)
+  {
+    return false;
+  }
+
+  packet_start = pos;
+  uint8_t packet_id;
+  read_value(packet_id);
+
+  // Records only frame the packets, each one is checked on the way into it
+  while (packet_id == static_cast<uint8_t>(internal::OutputPacket::CommitRecord))
+  {
+    if (get_record_end(packet_start, end) == 0)
+    {
+      return truncated("Commit record at " + std::to_string(packet_start) + " is incomplete or corrupt");
+    }
+
+    pos = packet_start + internal::LOG_COMMIT_HEADER_SIZE;
+    if (pos >= end)
+    {
+      return false;
+    }
+
+    packet_start = pos;
+    read_value(packet_id);
+  }
+
+  switch (static_cast<internal::OutputPacket>(packet_id))
+  {
+  case internal::OutputPacket::LogMessage:
+    {
+      uint8_t log_level;
+      uint16_t message_len;
+      LogMessagePacket log_message;
+      if (!read_value(log_level) || !read_value(message_len))
+      {
+        return false;
+      }
+
+      log_message.log_level = static_cast<LogLevel>(log_level);
+      log_message.message.resize(message_len);
+      if (!read_bytes(log_message.message.data(), message_len))
+      {
+        return false;
+      }
+
+      packet = std::move(log_message);
+      return true;
+    }
+  case internal::OutputPacket::StateUpdate:
+    {
+      if (!did_read_metadata)
+      {
+        return fail("State update before metadata");
+      }
+
+      if (end - pos < metadata.state_size)
+      {
+        return truncated("Log ends in the middle of a packet");
+      }
+
+      StateUpdatePacket state_update;
+      state_update.data = std::span(data + pos, metadata.state_size);
+      pos += metadata.state_size;
+
+      state_update.seq = 0;
+      state_update.us_since_boot = 0;
+      if (seq_variable)
+      {
+        memcpy(&state_update.seq, state_update.data.data() + seq_variable->data_offset, sizeof(uint64_t));
+      }
+      if (us_since_boot_variable)
+      {
+        memcpy(&state_update.us_since_boot, state_update.data.data() + us_since_boot_variable->data_offset,
+               sizeof(uint64_t));
+      }
+
+      packet = std::move(state_update);
+      return true;
+    }
+  case internal::OutputPacket::PersistentStateUpdate:
+    {
+      if (!did_read_metadata)
+      {
+        return fail("Persistent state update before metadata");
+      }
+
+      PersistentStateUpdatePacket persistent_update;
+      if (!read_persistent_values(metadata, persistent_update.values))
+      {
+        return false;
+      }
+
+      metadata.persistent_values = persistent_update.values;
+      packet = std::move(persistent_update);
+      return true;
+    }
+  case internal::OutputPacket::Metadata:
+    {
+      MetadataPacket metadata_packet;
+      if (!read_metadata(metadata_packet.metadata))
+      {
+        return false;
+      }
+
+      metadata = metadata_packet.metadata;
+      did_read_metadata = true;
+      seq_variable = metadata.find_variable("_sequence");
+      us_since_boot_variable = metadata.find_variable("_us_since_boot");
+      select_columns();
+      packet = std::move(metadata_packet);
+      return true;
+    }
+  case internal::OutputPacket::DeviceRestartMarker:
+    packet = DeviceRestartPacket();
+    return true;
+  case internal::OutputPacket::FaultsChanged:
+    {
+      FaultsChangedPacket faults_changed;
+      if (!read_value(faults_changed.fault_bit) || !read_value(faults_changed.faults) ||
+        !read_string(faults_changed.message))
+      {
+        return false;
+      }
+
+      packet = std::move(faults_changed);
+      return true;
+    }
+  case internal::OutputPacket::PhaseChanged:
+    {
+      PhaseChangedPacket phase_changed;
+      if (!read_value(phase_changed.phase) || !read_string(phase_changed.phase_name))
+      {
+        return false;
+      }
+
+      packet = std::move(phase_changed);
+      return true;
+    }
+  case internal::OutputPacket::LogIndex:
+    {
+      LogIndexPacket log_index;
+      uint64_t previous_index_offset;
+      if (!read_value(previous_index_offset) || !read_index_entries(log_index.entries))
+      {
+        return false;
+      }
+
+      log_index.previous_index_offset = previous_index_offset;
+      packet = std::move(log_index);
+      return true;
+    }
+  case internal::OutputPacket::StateBatch:
+    return read_state_batch(packet);
+  case internal::OutputPacket::ColumnBlock:
+    return read_column_block(packet);
+  case internal::OutputPacket::CommitRecord:
+    break;
+  }
+
+  return fail("Unknown packet id " + std::to_string(packet_id) + " at " + std::to_string(pos - 1));
+}
+
+bool log_reader::LogReader::read_state_batch(LogPacket& packet)
+{
+  if (!did_read_metadata)
+  {
+    return fail("State batch before metadata");
+  }
+
+  if (metadata.state_size < internal::STATE_HEADER_SIZE)
+  {
+    return fail("State batch without _sequence and _us_since_boot");
+  }
+
+  uint8_t count;
+  uint64_t seq, us_since_boot;
+  if (!read_value(count) || !read_value(seq) || !read_value(us_since_boot))
+  {
+    return false;
+  }
+
+  const size_t batched_size = metadata.state_size - internal::STATE_HEADER_SIZE;
+  if ((end - pos) / (internal::STATE_BATCH_DELTA_SIZE + batched_size) < count)
+  {
+    return truncated("Log ends in the middle of a packet");
+  }
+
+  // Each state gets its _sequence and _us_since_boot back, so it looks just like one from a StateUpdate
+  batch_buffer ^= 1;
+  std::vector<uint8_t>& states = batch_states[batch_buffer];
+  states.resize(count * metadata.state_size);
+  for (size_t i = 0; i < count; i++)
+  {
+    uint16_t seq_delta;
+    uint32_t us_delta;
+    read_value(seq_delta);
+    read_value(us_delta);
+    seq += seq_delta;
+    us_since_boot += us_delta;
+
+    uint8_t* state = states.data() + i * metadata.state_size;
+    memcpy(state, &seq, sizeof(seq));
+    memcpy(state + sizeof(seq), &us_since_boot, sizeof(us_since_boot));
+    read_bytes(state + internal::STATE_HEADER_SIZE, batched_size);
+  }
+
+  return start_batch(count, packet);
+}
+
+bool log_reader::LogReader::read_column_block(LogPacket& packet)
+{
+  if (!did_read_metadata)
+  {
+    return fail("Column block before metadata");
+  }
+
+  if (!seq_variable || !us_since_boot_variable)
+  {
+    return fail("Column block without _sequence and _us_since_boot");
+  }
+
+  uint8_t count, column_count;
+  if (!read_value(count) || !read_value(column_count))
+  {
+    return false;
+  }
+
+  // Anything that isn't read is left 0, instead of whatever the last block using this buffer had
+  batch_buffer ^= 1;
+  std::vector<uint8_t>& states = batch_states[batch_buffer];
+  states.assign(count * metadata.state_size, 0);
+
+  bool is_in_range = true;
+  for (size_t i = 0; i < column_count; i++)
+  {
+    uint8_t variable_id;
+    uint32_t column_len;
+    if (!read_value(variable_id) || !read_value(column_len))
+    {
+      return false;
+    }
+
+    if (end - pos < column_len)
+    {
+      return truncated("Log ends in the middle of a packet");
+    }
+
+    const LoggedVariable* variable = column_variables[variable_id];
+    if (!is_in_range || !variable)
+    {
+      pos += column_len;
+      continue;
+    }
+
+    const size_t value_size = data_type_helpers::get_size_for_data_type(variable->data_type);
+    if (column_len != (count + 2) * value_size)
+    {
+      return fail("Column of " + variable->display_name + " at " + std::to_string(pos) + " is the wrong size");
+    }
+
+    // Its min and max say if any of the block is wanted, without looking at the rest of it
+    if (variable == us_since_boot_variable)
+    {
+      uint64_t min_us, max_us;
+      memcpy(&min_us, data + pos, sizeof(min_us));
+      memcpy(&max_us, data + pos + sizeof(min_us), sizeof(max_us));
+      if (max_us < from_us || min_us > to_us)
+      {
+        is_in_range = false;
+        pos += column_len;
+        continue;
+      }
+    }
+
+    const uint8_t* values = data + pos + 2 * value_size;
+    for (size_t j = 0; j < count; j++)
+    {
+      memcpy(states.data() + j * metadata.state_size + variable->data_offset, values + j * value_size, value_size);
+    }
+    pos += column_len;
+  }
+
+  return start_batch(is_in_range ? count : 0, packet);
+}
+
+void log_reader::LogReader::select_columns()
+{
+  column_variables.assign(UINT8_MAX + 1, nullptr);
+  for (const LoggedVariable& variable : metadata.variables)
+  {
+    const size_t value_size = data_type_helpers::get_size_for_data_type(variable.data_type);
+    const bool is_selected = selected_names.empty() || &variable == seq_variable ||
+      &variable == us_since_boot_variable || std::ranges::find(selected_names, variable.display_name) !=
+      selected_names.end();
+    if (is_selected && value_size > 0 && variable.data_offset + value_size <= metadata.state_size)
+    {
+      column_variables[variable.variable_id] = &variable;
+    }
+  }
+}
+
+bool log_reader::LogReader::start_batch(const size_t count, LogPacket& packet)
+{
+  if (count == 0)
+  {
+    did_skip = true;
+    return true;
+  }
+
+  batch_end = pos;
+  pos = packet_start;
+  batch_count = count;
+  batch_next = 0;
+  next_batched_state(packet);
+  return true;
+}
+
+void log_reader::LogReader::next_batched_state(LogPacket& packet)
+{
+  StateUpdatePacket state_update;
+  state_update.data = std::span(batch_states[batch_buffer].data() + batch_next * metadata.state_size,
+                                metadata.state_size);
+  memcpy(&state_update.seq, state_update.data.data(), sizeof(uint64_t));
+  memcpy(&state_update.us_since_boot, state_update.data.data() + sizeof(uint64_t), sizeof(uint64_t));
+
+  if (++batch_next == batch_count)
+  {
+    pos = batch_end;
+  }
+  packet = std::move(state_update);
+}
+
+bool log_reader::LogReader::read_index(std::vector<LogIndexEntry>& entries) const
+{
+  entries.clear();
+
+  uint64_t trailer[2];
+  if (!data || end + sizeof(trailer) > size)
+  {
+    return false;
+  }
+
+  memcpy(trailer, data + end, sizeof(trailer));
+  if (trailer[1] != internal::LOG_INDEX_TRAILER_TAG)
+  {
+    return false;
+  }
+
+  // Index packets are chained newest to oldest, read them with a reader of our own so this one's position is left
+  // alone
+  LogReader index_reader;
+  index_reader.start_reading(data, size);
+  index_reader.end = end;
+
+  std::vector<std::vector<LogIndexEntry>> packets;
+  uint64_t index_offset = trailer[0];
+  while (index_offset > 0)
+  {
+    const uint64_t packet_offset = index_offset;
+    if (packet_offset >= end || data[packet_offset] != static_cast<uint8_t>(internal::OutputPacket::LogIndex))
+    {
+      return false;
+    }
+
+    LogPacket packet;
+    index_reader.pos = packet_offset;
+    if (!index_reader.read_packet(packet))
+    {
+      return false;
+    }
+
+    auto& log_index = std::get<LogIndexPacket>(packet);
+    index_offset = log_index.previous_index_offset;
+    packets.push_back(std::move(log_index.entries));
+
+    // Each one points further back, anything else is corrupt and could loop forever
+    if (index_offset >= packet_offset)
+    {
+      return false;
+    }
+  }
+
+  uint32_t boot = 0;
+  for (auto& packet_entries : std::ranges::reverse_view(packets))
+  {
+    for (LogIndexEntry& entry : packet_entries)
+    {
+      if (!entries.empty() && entry.seq < entries.back().seq)
+      {
+        boot++;
+      }
+
+      entry.boot = boot;
+      entries.push_back(entry);
+    }
+  }
+
+  return true;
+}
+
+bool log_reader::LogReader::seek(const size_t offset)
+{
+  LogPacket packet;
+  while (!did_read_metadata && read_packet(packet))
+  {
+  }
+
+  if (!did_read_metadata || !error.empty())
+  {
+    return fail("Can't seek without metadata");
+  }
+
+  if (offset < sizeof(uint64_t) || offset > end)
+  {
+    return fail("Seek to " + std::to_string(offset) + " is outside of the log");
+  }
+
+  pos = packet_start = offset;
+  batch_count = batch_next = 0;
+  return true;
+}
+
+void log_reader::LogReader::select_variables(std::vector<std::string> display_names)
+{
+  selected_names = std::move(display_names);
+  if (did_read_metadata)
+  {
+    select_columns();
+  }
+}
+
+void log_reader::LogReader::set_time_range(const uint64_t from_us, const uint64_t to_us)
+{
+  this->from_us = from_us;
+  this->to_us = to_us;
+}
+
+bool log_reader::LogReader::has_metadata() const
+{
+  return did_read_metadata;
+}
+
+const log_reader::LogMetadata& log_reader::LogReader::get_metadata() const
+{
+  return metadata;
+}
+
+size_t log_reader::LogReader::get_position() const
+{
+  return pos;
+}
+
+size_t log_reader::LogReader::get_size() const
+{
+  return end;
+}
+
+const std::string& log_reader::LogReader::get_error() const
+{
+  return error;
+}
+
+bool log_reader::LogReader::is_truncated() const
+{
+  return did_truncate;
+}
+
+size_t log_reader::LogReader::get_truncated_position() const
+{
+  return did_truncate ? packet_start : end;
+}
+
+size_t log_reader::LogReader::get_record_end(const size_t record_pos, const size_t limit) const
+{
+  if (record_pos >= limit || limit - record_pos < internal::LOG_COMMIT_HEADER_SIZE ||
+    data[record_pos] != static_cast<uint8_t>(internal::OutputPacket::CommitRecord))
+  {
+    return 0;
+  }
+
+  uint32_t record_len, record_crc;
+  memcpy(&record_len, data + record_pos + 1, sizeof(record_len));
+  memcpy(&record_crc, data + record_pos + 1 + sizeof(record_len), sizeof(record_crc));
+
+  const size_t record_data_start = record_pos + internal::LOG_COMMIT_HEADER_SIZE;
+  if (record_len > limit - record_data_start || internal::crc32(segment_key, data + record_data_start, record_len) != record_crc)
+  {
+    return 0;
+  }
+  return record_data_start + record_len;
+}
+
+bool log_reader::LogReader::fail(const std::string& message)
+{
+  if (error.empty())
+  {
+    error = message;
+  }
+  return false;
+}
+
+bool log_reader::LogReader::truncated(const std::string& message)
+{
+  if (error.empty())
+  {
+    did_truncate = true;
+  }
+  pos = end;
+  return fail(message);
+}
+
+bool log_reader::LogReader::read_bytes(void* dest, const size_t len)
+{
+  if (end - pos < len)
+  {
+    return truncated("Log ends in the middle of a packet");
+  }
+
+  memcpy(dest, data + pos, len);
+  pos += len;
+  return true;
+}
+
+bool log_reader::LogReader::read_string(std::string& dest)
+{
+  const auto str_end = static_cast<const uint8_t*>(memchr(data + pos, 0, end - pos));
+  if (!str_end)
+  {
+    return truncated("Log ends in the middle of a string");
+  }
+
+  dest.assign(reinterpret_cast<const char*>(data + pos), reinterpret_cast<const char*>(str_end));
+  pos += dest.size() + 1;
+  return true;
+}
+
+bool log_reader::LogReader::read_offset(size_t& dest, const uint8_t offset_size)
+{
+  // Offsets are written as the device's size_t, which is not necessarily ours
+  uint64_t offset = 0;
+  if (offset_size > sizeof(offset) || !read_bytes(&offset, offset_size))
+  {
+    return fail("Invalid offset size " + std::to_string(offset_size));
+  }
+
+  dest = offset;
+  return true;
+}
+
+bool log_reader::LogReader::read_index_entries(std::vector<LogIndexEntry>& dest)
+{
+  uint16_t entry_count;
+  if (!read_value(entry_count))
+  {
+    return false;
+  }
+
+  dest.resize(entry_count);
+  for (LogIndexEntry& entry : dest)
+  {
+    uint64_t offset;
+    if (!read_value(entry.seq) || !read_value(entry.us_since_boot) || !read_value(offset) || !read_value(entry.faults)
+      || !read_value(entry.phase))
+    {
+      return false;
+    }
+
+    entry.offset = offset;
+    entry.boot = 0;
+  }
+  return true;
+}
+
+bool log_reader::LogReader::read_metadata(LogMetadata& dest)
+{
+  while (true)
+  {
+    uint8_t segment_id;
+    if (!read_value(segment_id))
+    {
+      return false;
+    }
+
+    switch (static_cast<internal::MetadataSegment>(segment_id))
+    {
+    case internal::MetadataSegment::ApplicationName:
+      if (!read_string(dest.application_name))
+      {
+        return false;
+      }
+      break;
+    case internal::MetadataSegment::Commands:
+      {
+        uint8_t command_count;
+        if (!read_value(command_count))
+        {
+          return false;
+        }
+
+        for (uint8_t i = 0; i < command_count; i++)
+        {
+          uint8_t command_header[2];
+          std::string command_name;
+          if (!read_bytes(command_header, sizeof(command_header)) || !read_string(command_name))
+          {
+            return false;
+          }
+        }
+        break;
+      }
+    case internal::MetadataSegment::VariableDefinitions:
+      {
+        uint8_t var_count, offset_size;
+        if (!read_value(var_count) || !read_value(offset_size))
+        {
+          return false;
+        }
+
+        dest.variables.clear();
+        dest.state_size = 0;
+        for (uint8_t i = 0; i < var_count; i++)
+        {
+          LoggedVariable variable;
+          uint8_t data_type;
+          if (!read_value(variable.variable_id) || !read_offset(variable.data_offset, offset_size) ||
+            !read_value(data_type) || !read_string(variable.display_name) || !read_string(variable.display_unit))
+          {
+            return false;
+          }
+
+          variable.data_type = static_cast<DataType>(data_type);
+          dest.state_size = std::max(dest.state_size,
+                                     variable.data_offset + data_type_helpers::get_size_for_data_type(
+                                       variable.data_type));
+          dest.variables.push_back(std::move(variable));
+        }
+        break;
+      }
+    case internal::MetadataSegment::PersistentStorageEntries:
+      {
+        uint8_t entry_count, offset_size;
+        if (!read_value(entry_count) || !read_value(offset_size))
+        {
+          return false;
+        }
+
+        dest.persistent_entries.clear();
+        for (uint8_t i = 0; i < entry_count; i++)
+        {
+          LoggedPersistentEntry entry;
+          uint8_t data_type;
+          if (!read_value(entry.key_id) || !read_value(data_type) || !read_offset(entry.offset, offset_size) ||
+            !read_string(entry.display_name))
+          {
+            return false;
+          }
+
+          entry.data_type = static_cast<DataType>(data_type);
+          dest.persistent_entries.push_back(std::move(entry));
+        }
+
+        // The current values follow the entries directly
+        if (!read_persistent_values(dest, dest.persistent_values))
+        {
+          return false;
+        }
+        break;
+      }
+    case internal::MetadataSegment::FaultInformation:
+      {
+        uint8_t fault_count;
+        if (!read_value(fault_count) || !read_value(dest.initial_faults))
+        {
+          return false;
+        }
+
+        dest.faults.clear();
+        for (uint8_t i = 0; i < fault_count; i++)
+        {
+          LoggedFault fault;
+          uint8_t fault_header[2];
+          if (!read_bytes(fault_header, sizeof(fault_header)) || !read_string(fault.fault_name))
+          {
+            return false;
+          }
+
+          fault.fault_bit = fault_header[0] & 0x7F;
+          fault.is_com_channel = (fault_header[0] & 0x80) > 0;
+          fault.communication_channel = static_cast<CommunicationChannel>(fault_header[1]);
+          dest.faults.push_back(std::move(fault));
+        }
+        break;
+      }
+    case internal::MetadataSegment::InitialPhase:
+      if (!read_value(dest.initial_phase) || !read_string(dest.initial_phase_name))
+      {
+        return false;
+      }
+      break;
+    case internal::MetadataSegment::MetadataEnd:
+      return true;
+    default:
+      return fail("Unknown metadata segment " + std::to_string(segment_id) + " at " + std::to_string(pos - 1));
+    }
+  }
+}
+
+bool log_reader::LogReader::read_persistent_values(const LogMetadata& layout, std::vector<std::string>& dest)
+{
+  uint32_t tag;
+  if (!read_value(tag))
+  {
+    return false;
+  }
+
+  // Fixed size entries are packed by byte offset, followed by null terminated strings in index order
+  size_t static_size = 0;
+  std::vector<const LoggedPersistentEntry*> string_entries;
+  for (const LoggedPersistentEntry& entry : layout.persistent_entries)
+  {
+    if (entry.data_type == DataType::String)
+    {
+      string_entries.push_back(&entry);
+    }
+    else
+    {
+      static_size = std::max(static_size, entry.offset + data_type_helpers::get_size_for_data_type(entry.data_type));
+    }
+  }
+  std::ranges::sort(string_entries, {}, &LoggedPersistentEntry::offset);
+
+  std::vector<uint8_t> static_data(static_size);
+  if (!read_bytes(static_data.data(), static_size))
+  {
+    return false;
+  }
+
+  std::vector<std::string> string_values(string_entries.size());
+  for (std::string& string_value : string_values)
+  {
+    if (!read_string(string_value))
+    {
+      return false;
+    }
+  }
+
+  dest.clear();
+  for (const LoggedPersistentEntry& entry : layout.persistent_entries)
+  {
+    if (entry.data_type == DataType::String)
+    {
+      const auto string_idx = std::ranges::find(string_entries, &entry) - string_entries.begin();
+      dest.push_back(string_values[string_idx]);
+    }
+    else
+    {
+      const LoggedVariable as_variable{0, entry.display_name, "", entry.offset, entry.data_type};
+      dest.push_back(format_value(as_variable, static_data.data()));
+    }
+  }
+
+  return true;
+}
+
+double log_reader::get_numeric_value(const LoggedVariable& variable, const uint8_t* state_data)
+{
+  const uint8_t* value_ptr = state_data + variable.data_offset;
+
+#define LOG_READER_READ_AS(TYPE_NAME) \
+  { \
+    TYPE_NAME value; \
+    memcpy(&value, value_ptr, sizeof(TYPE_NAME)); \
+    return static_cast<double>(value); \
+  }
+
+  switch (variable.data_type)
+  {
+  case DataType::Int8: LOG_READER_READ_AS(int8_t)
+  case DataType::Uint8: LOG_READER_READ_AS(uint8_t)
+  case DataType::Int16: LOG_READER_READ_AS(int16_t)
+  case DataType::UInt16: LOG_READER_READ_AS(uint16_t)
+  case DataType::Int32: LOG_READER_READ_AS(int32_t)
+  case DataType::UInt32: LOG_READER_READ_AS(uint32_t)
+  case DataType::Int64: LOG_READER_READ_AS(int64_t)
+  case DataType::UInt64: LOG_READER_READ_AS(uint64_t)
+  case DataType::Float: LOG_READER_READ_AS(float)
+  case DataType::Double: LOG_READER_READ_AS(double)
+  case DataType::String:
+  case DataType::Time:
+    break;
+  }
+
+#undef LOG_READER_READ_AS
+
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+tm log_reader::get_time_value(const LoggedVariable& variable, const uint8_t* state_data)
+{
+  return internal::decode_time(state_data + variable.data_offset);
+}
+
+std::string log_reader::format_value(const LoggedVariable& variable, const uint8_t* state_data)
+{
+  const uint8_t* value_ptr = state_data + variable.data_offset;
+  char formatted[64];
+
+  switch (variable.data_type)
+  {
+  case DataType::Int8:
+  case DataType::Int16:
+  case DataType::Int32:
+    return std::to_string(static_cast<int32_t>(get_numeric_value(variable, state_data)));
+  case DataType::Uint8:
+  case DataType::UInt16:
+  case DataType::UInt32:
+    return std::to_string(static_cast<uint32_t>(get_numeric_value(variable, state_data)));
+  case DataType::Int64:
+    {
+      int64_t value;
+      memcpy(&value, value_ptr, sizeof(value));
+      return std::to_string(value);
+    }
+  case DataType::UInt64:
+    {
+      uint64_t value;
+      memcpy(&value, value_ptr, sizeof(value));
+      return std::to_string(value);
+    }
+  case DataType::Float:
+  case DataType::Double:
+    // Enough digits to round trip a double
+    snprintf(formatted, sizeof(formatted), "%.17g", get_numeric_value(variable, state_data));
+    return formatted;
+  case DataType::Time:
+    {
+      const tm time_inst = get_time_value(variable, state_data);
+      snprintf(formatted, sizeof(formatted), "%04d-%02d-%02dT%02d:%02d:%02d", time_inst.tm_year + 1900,
+               time_inst.tm_mon + 1, time_inst.tm_mday, time_inst.tm_hour, time_inst.tm_min, time_inst.tm_sec);
+      return formatted;
+    }
+  case DataType::String:
+    break;
+  }
+
+  return "";
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "data_type.h"
+#include "state_batcher.h"
+#include "variable_definition.h"
+
+// States per column block, and how long the first of them waits for the rest. Longer blocks give a reader more to
+// skip at once, but states aren't in the log (and can't survive a power loss) until their block is.
+#define COLUMN_BLOCK_STATES 64
+#define COLUMN_BLOCK_MAX_AGE_MS 1000
+
+namespace elijah_state_framework
+{
+  // How states are laid out in the log, USB always gets them a state at a time
+  enum class LogLayout : uint8_t
+  {
+    // Every variable of a state together, in StateUpdate or StateBatch packets
+    Rows,
+    // Blocks of states transposed into a column per variable, see ColumnBlockEncoder
+    Columns
+  };
+}
+
+namespace elijah_state_framework::internal
+{
+  /**
+   * Column block packet layout (after the OutputPacket::ColumnBlock id):
+   *
+   *   uint8   state count
+   *   uint8   column count
+   *   for each column, in variable id order (so _sequence, then _us_since_boot, then the rest):
+   *     uint8   variable id
+   *     uint32  length of the rest of the column, to skip it without knowing its type
+   *     ...     smallest value, then largest (a time's are its first and last)
+   *     ...     the value from every state, in order
+   *
+   * Every value is encoded just as it is in a state, so a column is count * the variable's data type size.
+   */
+  constexpr size_t COLUMN_BLOCK_HEADER_SIZE = 3 * sizeof(uint8_t);
+  constexpr size_t COLUMN_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t);
+
+  // Turns a batch of states into a ColumnBlock packet
+  class ColumnBlockEncoder
+  {
+  public:
+    explicit ColumnBlockEncoder(const std::map<uint8_t, VariableDefinition>& variables);
+
+    // The packet is only valid until the next encode()
+    void encode(const StateBatcher& batch);
+
+    [[nodiscard]] const uint8_t* get_packet() const;
+    [[nodiscard]] size_t get_packet_size() const;
+
+  private:
+    struct Column
+    {
+      uint8_t variable_id;
+      size_t offset;
+      DataType data_type;
+    };
+
+    std::vector<Column> columns;
+    std::vector<uint8_t> packet;
+  };
+}
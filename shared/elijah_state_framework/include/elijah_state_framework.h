@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 #include <deque>
 #include <functional>
@@ -8,10 +9,12 @@
 #include <string>
 #include <format>
 #include <variant>
+#include <vector>
 #include <pico/critical_section.h>
 #include <pico/rand.h>
 #include <pico/stdio_usb.h>
 
+#include "column_block.h"
 #include "data_type.h"
 #include "fault_manager.h"
 #include "flight_phase_controller.h"
@@ -19,9 +22,13 @@
 #include "metadata_segment.h"
 #include "output_packet.h"
 #include "persistent_data_storage.h"
+#include "pre_trigger_buffer.h"
+#include "recording_policy.h"
 #include "registered_command.h"
 #include "usb_comm.h"
+#include "state_batcher.h"
 #include "state_framework_logger.h"
+#include "state_snapshot.h"
 #include "variable_definition.h"
 
 constexpr uint64_t FRAMEWORK_TAG = 0xBC7AA65201C73901;
@@ -48,7 +55,6 @@ constexpr uint64_t FRAMEWORK_TAG = 0xBC7AA65201C73901;
   } \
   data_len += curr_data_size_len;
 #define ENCODE_STATE(MEMBER_NAME, DATA_TYPE, DISP_NAME, DISP_UNIT) \
-  assert(!done_with_static); \
   static_assert(DataType::String != (DATA_TYPE) && !std::is_same<decltype(state.MEMBER_NAME), std::string>::value, "Property (" #MEMBER_NAME ") must be not be of type string"); \
   static_assert(DataType::Time != (DATA_TYPE) && !std::is_same<decltype(state.MEMBER_NAME), tm>::value, "Property (" #MEMBER_NAME ") must not be a time type, use ENCODE_TIME_STATE(" #MEMBER_NAME ", " #DISP_NAME ") instead"); \
   curr_data_size_len = data_type_helpers::get_size_for_data_type(DATA_TYPE); \
@@ -59,7 +65,6 @@ constexpr uint64_t FRAMEWORK_TAG = 0xBC7AA65201C73901;
   } \
   data_len += curr_data_size_len;
 #define ENCODE_TIME_STATE(MEMBER_NAME, DISP_NAME) \
-  assert(!done_with_static); \
   static_assert(std::is_same<decltype(state.MEMBER_NAME), tm>::value, "Using ENCODE_TIME_STATE requires encoding a time variable"); \
   curr_data_size_len = data_type_helpers::get_size_for_data_type(DataType::Time); \
   if (register_data) { \
@@ -110,7 +115,8 @@ namespace elijah_state_framework
   {
   public:
     ElijahStateFramework(std::string application_name, EPersistentStorageKey launch_key, EFaultKey micro_sd_fault_key,
-                         size_t state_history_size);
+                         size_t state_history_size, size_t pre_trigger_buffer_size = 0,
+                         uint64_t log_segment_size = LOG_SEGMENT_SIZE);
     virtual ~ElijahStateFramework();
 
     PersistentDataStorage<EPersistentStorageKey>* get_persistent_data_storage() const;
@@ -119,15 +125,27 @@ namespace elijah_state_framework
 
     void check_for_log_write();
 
+    // How much logged data a power loss can take with it, see LogDurability. Applies to loggers for new launches too.
+    void set_log_durability(LogDurability durability, uint32_t commit_interval_ms = LOG_COMMIT_INTERVAL_MS);
+
     void log_message(const std::string& message,
                      LogLevel log_level = LogLevel::Default) const;
     void check_for_commands();
 
     void state_changed(const TStateData& new_state);
+    // Sends states in StateBatch packets of up to this many (at most 255), to USB and the log each, instead of a
+    // StateUpdate packet per state. 1, the default, turns batching off. A batch goes out when it's full, after
+    // STATE_BATCH_MAX_AGE_MS, and before any phase or fault change, so those still line up with the states. With
+    // LogLayout::Columns the log gets column blocks instead.
+    void set_state_batch_size(size_t states_per_batch);
+    // Columns logs blocks of COLUMN_BLOCK_STATES states as a column per variable, with each column's min and max, so a
+    // reader can skip the variables and times it doesn't want. Phase and fault changes end a block early, like a batch.
+    void set_log_layout(LogLayout layout);
     void lock_state_history();
     void release_state_history();
     [[nodiscard]] const std::deque<TStateData>& get_state_history() const;
-    [[nodiscard]] EFlightPhase get_current_flight_phase();
+    [[nodiscard]] StateSnapshot<TStateData, EFlightPhase> get_latest_snapshot() const;
+    [[nodiscard]] EFlightPhase get_current_flight_phase() const;
 
     void set_fault(EFaultKey fault_key, bool fault_state);
     void set_fault(EFaultKey fault_key, bool fault_state, const std::string& message);
@@ -152,6 +170,9 @@ namespace elijah_state_framework
     virtual void encode_state(void* encode_dest, const TStateData& encode_data, uint64_t seq,
                               bool register_data) = 0;
 
+    // Checked by START_STATE_ENCODER in the derived class
+    bool is_size_calculated = false;
+
   private:
     template <class... Ts>
     struct overloaded : Ts...
@@ -172,8 +193,9 @@ namespace elijah_state_framework
     std::map<uint8_t, RegisteredCommand> registered_commands;
     std::map<uint8_t, VariableDefinition> variable_definitions;
 
-    bool is_size_calculated = false;
     size_t encoded_state_size = 0;
+    // Where the flight phase controller's estimate starts in an encoded state, after the application's variables
+    size_t flight_estimate_offset = 0;
 
     shared_mutex_t state_history_smtx;
     size_t state_history_size;
@@ -183,6 +205,9 @@ namespace elijah_state_framework
       = new PersistentDataStorage<EPersistentStorageKey>();
 
     StateFrameworkLogger* logger = nullptr;
+    uint64_t log_segment_size;
+    LogDurability log_durability = LogDurability::Interval;
+    uint32_t log_commit_interval_ms = LOG_COMMIT_INTERVAL_MS;
     shared_mutex_t logger_smtx;
     EFaultKey micro_sd_fault_key;
     bool did_write_metadata = false;
@@ -190,31 +215,75 @@ namespace elijah_state_framework
     FaultManager<EFaultKey>* fault_manager = new FaultManager<EFaultKey>(0x0000);
 
     TFlightPhaseController* flight_phase_controller;
+    internal::RecordingPolicy<TStateData, EFlightPhase>* recording_policy;
+
+    // The last states, all of them, so the ones the recording policy skips can still be logged on a phase change
+    size_t pre_trigger_buffer_size;
+    internal::PreTriggerBuffer* pre_trigger_buffer = nullptr;
+    // Only touched by the core calling state_changed(), everyone else should go through the snapshot
     EFlightPhase current_phase;
-    mutex_t current_phase_mtx;
+
+    internal::SnapshotPublisher<StateSnapshot<TStateData, EFlightPhase>>* latest_snapshot;
+
+    size_t state_batch_size = 1;
+    mutex_t state_batch_mtx;
+    internal::StateBatcher* usb_batch = nullptr;
+    internal::StateBatcher* log_batch = nullptr;
+    LogLayout log_layout = LogLayout::Rows;
+    // Only with LogLayout::Columns, log_batch is transposed by it
+    internal::ColumnBlockEncoder* column_encoder = nullptr;
+    // What the states in the log batch were logged under, for their index entries
+    EFlightPhase log_batch_phase;
+    uint32_t log_batch_faults = 0;
 
     void register_command(const std::string& command, CommandInputType command_input, command_callback_t callback);
 
     void send_framework_metadata(bool write_to_file);
     void send_persistent_state(const void* data, size_t data_len);
+
+    // Callers hold state_batch_mtx, and usb_cs or logger_smtx (shared) for the one they send
+    void send_usb_batch();
+    void log_state_batch();
+    void create_state_batchers();
+
+    // The controller's estimate and prediction go out with every state as variables of their own, so telemetry and the
+    // log have them
+    void register_flight_estimate_variables();
+    void encode_flight_estimate(uint8_t* encoded_state, const VerticalEstimate& vertical,
+                                const FlightPrediction& prediction) const;
+
+    // Into the log batch if there is one, straight to the log otherwise. Same locks as log_state_batch().
+    void record_state(const uint8_t* packet, uint32_t faults, EFlightPhase phase, uint64_t now_us);
+    // One state packet on its own, with its index entry
+    void log_state_packet(const uint8_t* packet, uint32_t faults, EFlightPhase phase);
+    // Pops the oldest state out of the pre-trigger ring, and records it if the policy picked it
+    void evict_pre_trigger_state(uint64_t now_us);
+    // Before anything is logged that has to come after every state so far (faults, a new launch)
+    void drain_pre_trigger_buffer();
   };
 }
 
 FRAMEWORK_TEMPLATE_DECL
 elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::ElijahStateFramework(
   std::string application_name, EPersistentStorageKey launch_key, EFaultKey micro_sd_fault_key,
-  const size_t state_history_size) :
-  application_name(std::move(application_name)), launch_key(launch_key), micro_sd_fault_key(micro_sd_fault_key),
-  state_history_size(state_history_size)
+  const size_t state_history_size, const size_t pre_trigger_buffer_size, const uint64_t log_segment_size) :
+  application_name(std::move(application_name)), launch_key(launch_key), state_history_size(state_history_size),
+  log_segment_size(log_segment_size), micro_sd_fault_key(micro_sd_fault_key),
+  pre_trigger_buffer_size(pre_trigger_buffer_size)
 {
   internal::init_usb_comm();
   critical_section_init(&internal::usb_cs);
   shared_mutex_init(&logger_smtx);
   shared_mutex_init(&state_history_smtx);
+  mutex_init(&state_batch_mtx);
 
   flight_phase_controller = new TFlightPhaseController();
+  recording_policy = new internal::RecordingPolicy<TStateData, EFlightPhase>(flight_phase_controller);
   current_phase = flight_phase_controller->initial_flight_phase();
-  mutex_init(&current_phase_mtx);
+  latest_snapshot = new internal::SnapshotPublisher<StateSnapshot<TStateData, EFlightPhase>>({
+    .state = {}, .phase = current_phase, .vertical = {},
+    .prediction = flight_phase_controller->get_flight_prediction(), .faults = fault_manager->get_all_faults(), .seq = 0
+  });
 
   persistent_data_storage->on_commit([this](const void* data, const size_t data_len)
   {
@@ -229,14 +298,20 @@ elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::ElijahSt
   // ReSharper disable once CppPassValueParameterByConstReference
   register_command("New launch", true, [this](std::string launch_name)
   {
+    mutex_enter_blocking(&state_batch_mtx);
     shared_mutex_enter_blocking_exclusive(&logger_smtx);
 
+    // States held back or batched for the last launch go in its log
+    drain_pre_trigger_buffer();
+    log_state_batch();
     logger->flush_log();
     delete logger;
     did_write_metadata = false;
 
-    logger = new StateFrameworkLogger(launch_name); // NOLINT(*-unnecessary-value-param)
+    // NOLINTNEXTLINE(*-unnecessary-value-param)
+    logger = new StateFrameworkLogger(launch_name, this->log_segment_size, log_durability, log_commit_interval_ms);
     shared_mutex_exit_exclusive(&logger_smtx);
+    mutex_exit(&state_batch_mtx);
   });
 
   register_command("Reset persistent storage", [this]
@@ -254,13 +329,28 @@ elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::~ElijahS
 {
   delete persistent_data_storage;
 
+  mutex_enter_blocking(&state_batch_mtx);
   shared_mutex_enter_blocking_exclusive(&logger_smtx);
+  if (logger)
+  {
+    drain_pre_trigger_buffer();
+    log_state_batch();
+    logger->flush_log();
+  }
   delete logger;
   logger = nullptr;
   shared_mutex_exit_exclusive(&logger_smtx);
+  mutex_exit(&state_batch_mtx);
+
+  delete usb_batch;
+  delete log_batch;
+  delete column_encoder;
 
   delete fault_manager;
+  delete recording_policy;
+  delete pre_trigger_buffer;
   delete flight_phase_controller;
+  delete latest_snapshot;
 }
 
 FRAMEWORK_TEMPLATE_DECL
@@ -398,9 +488,7 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::sta
   uint8_t* phase_change_packet = nullptr;
   if (new_phase != current_phase)
   {
-    mutex_enter_blocking(&current_phase_mtx);
     current_phase = new_phase;
-    mutex_exit(&current_phase_mtx);
     phase_changed = true;
 
     const std::string phase_name = flight_phase_controller->get_phase_name(current_phase);
@@ -412,26 +500,159 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::sta
     memcpy(phase_change_packet + 2, phase_name.c_str(), phase_name.size() + 1);
   }
 
+  // Only known once the controller has seen this state, so it's filled in after the rest
+  const VerticalEstimate vertical = flight_phase_controller->get_vertical_estimate();
+  const FlightPrediction prediction = flight_phase_controller->get_flight_prediction();
+  encode_flight_estimate(encoded_output_packet + 1, vertical, prediction);
+
+  // encode_state() has already advanced the sequence past this state
+  const uint32_t faults = fault_manager->get_all_faults();
+  latest_snapshot->publish({
+    .state = new_state, .phase = current_phase, .vertical = vertical, .prediction = prediction, .faults = faults,
+    .seq = state_seq - 1
+  });
+
+  // Every state starts with _sequence and _us_since_boot (see START_STATE_ENCODER)
+  uint64_t us_since_boot;
+  memcpy(&us_since_boot, encoded_output_packet + 1 + sizeof(uint64_t), sizeof(us_since_boot));
+
+  mutex_enter_blocking(&state_batch_mtx);
   if (stdio_usb_connected())
   {
     critical_section_enter_blocking(&internal::usb_cs);
-    internal::write_to_serial(encoded_output_packet, total_encoded_packet_size, !phase_changed);
+    if (usb_batch)
+    {
+      if (!usb_batch->add(encoded_output_packet + 1))
+      {
+        send_usb_batch();
+        usb_batch->add(encoded_output_packet + 1);
+      }
+
+      // The phase change has to come after the state that caused it
+      if (phase_changed || usb_batch->is_due(us_since_boot))
+      {
+        send_usb_batch();
+      }
+    }
+    else
+    {
+      internal::write_to_serial(encoded_output_packet, total_encoded_packet_size, !phase_changed);
+    }
+
     if (phase_changed)
     {
       internal::write_to_serial(phase_change_packet, phase_change_packet_size);
     }
     critical_section_exit(&internal::usb_cs);
   }
+  else if (usb_batch)
+  {
+    // Nothing to send them to
+    usb_batch->clear();
+  }
+
+  // USB always gets every state, only the log is decimated
+  const bool should_record = recording_policy->should_record(current_phase, phase_changed,
+                                                             to_us_since_boot(get_absolute_time()));
+  // The ring is only for phases the log is decimated in, full rate states go straight to the log so they're never just
+  // in RAM
+  const bool is_decimated = flight_phase_controller->get_log_interval_us(current_phase) != 0;
+  if (pre_trigger_buffer && !phase_changed && is_decimated)
+  {
+    // Every state goes through the ring so the log stays in order. The ones the policy picked are logged as they come
+    // out the other end, the rest only make it in if a phase change flushes them first.
+    if (pre_trigger_buffer->is_full())
+    {
+      shared_mutex_enter_blocking_shared(&logger_smtx);
+      evict_pre_trigger_state(us_since_boot);
+      shared_mutex_exit_shared(&logger_smtx);
+    }
+    pre_trigger_buffer->push(encoded_output_packet, faults, static_cast<uint8_t>(current_phase), should_record);
+  }
+  else if (should_record || phase_changed)
+  {
+    shared_mutex_enter_blocking_shared(&logger_smtx);
+    if (logger)
+    {
+      if (phase_changed)
+      {
+        // Everything batched is from before the transition, and everything in the ring after that
+        log_state_batch();
+        while (pre_trigger_buffer && pre_trigger_buffer->size() > 0)
+        {
+          const internal::PreTriggerEntry entry = pre_trigger_buffer->front();
+          log_state_packet(entry.packet, entry.faults, static_cast<EFlightPhase>(entry.phase));
+          pre_trigger_buffer->pop();
+        }
+
+        // The state that changed the phase counts as part of the new one, so its entry goes before it. It's logged on
+        // its own, so the entry doesn't take any states from before the transition with it.
+        log_state_packet(encoded_output_packet, faults, current_phase);
+        logger->log_data(phase_change_packet, phase_change_packet_size);
+        logger->commit_if_due(true);
+      }
+      else
+      {
+        // Anything still held back came first
+        drain_pre_trigger_buffer();
+        record_state(encoded_output_packet, faults, current_phase, us_since_boot);
+      }
+    }
+    shared_mutex_exit_shared(&logger_smtx);
+  }
+  mutex_exit(&state_batch_mtx);
+
+  delete [] phase_change_packet;
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::set_state_batch_size(
+  const size_t states_per_batch)
+{
+  mutex_enter_blocking(&state_batch_mtx);
+  state_batch_size = std::clamp<size_t>(states_per_batch, 1, UINT8_MAX);
 
+  // Whatever was batched goes out in the old batches first
+  if (usb_batch && usb_batch->size() > 0 && stdio_usb_connected())
+  {
+    critical_section_enter_blocking(&internal::usb_cs);
+    send_usb_batch();
+    critical_section_exit(&internal::usb_cs);
+  }
   shared_mutex_enter_blocking_shared(&logger_smtx);
-  if (logger)
+  if (logger && log_batch)
   {
-    logger->log_data(encoded_output_packet, total_encoded_packet_size);
-    logger->log_data(phase_change_packet, phase_change_packet_size);
+    log_state_batch();
   }
   shared_mutex_exit_shared(&logger_smtx);
 
-  delete [] phase_change_packet;
+  // Before finish_construction() the state size isn't known yet, the batchers are made there
+  if (is_size_calculated)
+  {
+    create_state_batchers();
+  }
+  mutex_exit(&state_batch_mtx);
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::set_log_layout(const LogLayout layout)
+{
+  mutex_enter_blocking(&state_batch_mtx);
+  log_layout = layout;
+
+  // Whatever was batched is logged the old way first
+  shared_mutex_enter_blocking_shared(&logger_smtx);
+  if (logger && log_batch)
+  {
+    log_state_batch();
+  }
+  shared_mutex_exit_shared(&logger_smtx);
+
+  if (is_size_calculated)
+  {
+    create_state_batchers();
+  }
+  mutex_exit(&state_batch_mtx);
 }
 
 FRAMEWORK_TEMPLATE_DECL
@@ -454,12 +675,16 @@ get_state_history() const
 }
 
 FRAMEWORK_TEMPLATE_DECL
-EFlightPhase elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::get_current_flight_phase()
+elijah_state_framework::StateSnapshot<TStateData, EFlightPhase> elijah_state_framework::ElijahStateFramework<
+  FRAMEWORK_TEMPLATE_TYPES>::get_latest_snapshot() const
+{
+  return latest_snapshot->read();
+}
+
+FRAMEWORK_TEMPLATE_DECL
+EFlightPhase elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::get_current_flight_phase() const
 {
-  mutex_enter_blocking(&current_phase_mtx);
-  EFlightPhase p = current_phase;
-  mutex_exit(&current_phase_mtx);
-  return p;
+  return latest_snapshot->read().phase;
 }
 
 FRAMEWORK_TEMPLATE_DECL
@@ -474,15 +699,42 @@ FRAMEWORK_TEMPLATE_DECL
 void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::set_fault(
   EFaultKey fault_key, bool fault_state, const std::string& message)
 {
+  // Most calls are a sensor saying it's still fine (or still broken), which don't need the batch lock at all
+  if (fault_manager->is_faulted(fault_key) == fault_state)
+  {
+    return;
+  }
+
   uint8_t fault_bit;
   bool did_fault_change;
+  mutex_enter_blocking(&state_batch_mtx);
   const uint32_t faults = fault_manager->set_fault_status(fault_key, fault_state, fault_bit, did_fault_change);
 
   if (!did_fault_change)
   {
+    mutex_exit(&state_batch_mtx);
     return;
   }
 
+  // Batched states are from before the change
+  if (usb_batch && usb_batch->size() > 0)
+  {
+    critical_section_enter_blocking(&internal::usb_cs);
+    send_usb_batch();
+    critical_section_exit(&internal::usb_cs);
+  }
+  if ((log_batch && log_batch->size() > 0) || (pre_trigger_buffer && pre_trigger_buffer->size() > 0))
+  {
+    shared_mutex_enter_blocking_shared(&logger_smtx);
+    drain_pre_trigger_buffer();
+    if (logger)
+    {
+      log_state_batch();
+    }
+    shared_mutex_exit_shared(&logger_smtx);
+  }
+  mutex_exit(&state_batch_mtx);
+
   const size_t encoded_size = 2 * sizeof(uint8_t) /* output packet, fault_bit */ + sizeof(uint32_t) + message.size() +
     1;
   uint8_t encoded_data[encoded_size];
@@ -496,13 +748,16 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::set
   internal::write_to_serial(encoded_data, encoded_size);
   critical_section_exit(&internal::usb_cs);
 
+  // send_framework_metadata takes the logger lock itself, and re-entering it shared would deadlock once a writer on
+  // the other core is queued
+  if (!did_write_metadata)
+  {
+    send_framework_metadata(true);
+  }
+
   shared_mutex_enter_blocking_shared(&logger_smtx);
   if (logger)
   {
-    if (!did_write_metadata)
-    {
-      send_framework_metadata(true);
-    }
     logger->log_data(encoded_data, encoded_size);
   }
   shared_mutex_exit_shared(&logger_smtx);
@@ -563,12 +818,28 @@ FRAMEWORK_TEMPLATE_DECL
 void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::check_for_log_write()
 {
   shared_mutex_enter_blocking_shared(&logger_smtx);
+  logger->commit_if_due();
   const bool did_succeed = logger->flush_write_buff();
+  logger->preallocate_next_segment();
   shared_mutex_exit_shared(&logger_smtx);
 
   set_fault(micro_sd_fault_key, !did_succeed);
 }
 
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::set_log_durability(
+  const LogDurability durability, const uint32_t commit_interval_ms)
+{
+  shared_mutex_enter_blocking_exclusive(&logger_smtx);
+  log_durability = durability;
+  log_commit_interval_ms = commit_interval_ms;
+  if (logger)
+  {
+    logger->set_durability(durability, commit_interval_ms);
+  }
+  shared_mutex_exit_exclusive(&logger_smtx);
+}
+
 FRAMEWORK_TEMPLATE_DECL
 void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::register_command(
   const std::string& command,
@@ -631,19 +902,28 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::set
 FRAMEWORK_TEMPLATE_DECL
 void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::finish_construction()
 {
-  logger = new StateFrameworkLogger(persistent_data_storage->get_string(launch_key));
+  logger = new StateFrameworkLogger(persistent_data_storage->get_string(launch_key), log_segment_size, log_durability,
+                                    log_commit_interval_ms);
 
   TStateData collection_data;
   encode_state(nullptr, collection_data, 0, true);
+  register_flight_estimate_variables();
 
-  if (logger->is_new_file())
+  if (pre_trigger_buffer_size > 0)
   {
-    did_write_metadata = false;
-    send_framework_metadata(true);
+    pre_trigger_buffer = new internal::PreTriggerBuffer(pre_trigger_buffer_size, encoded_state_size + 1);
   }
-  else
+
+  mutex_enter_blocking(&state_batch_mtx);
+  create_state_batchers();
+  mutex_exit(&state_batch_mtx);
+
+  // Every boot starts a new segment, which needs the metadata to be decoded on its own
+  did_write_metadata = false;
+  send_framework_metadata(true);
+
+  if (!logger->is_new_file())
   {
-    did_write_metadata = true;
     constexpr auto restart_marker = static_cast<uint8_t>(
       internal::OutputPacket::DeviceRestartMarker);
     logger->log_data(&restart_marker, sizeof(uint8_t));
@@ -671,26 +951,38 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::sen
     return;
   }
 
-  critical_section_enter_blocking(&internal::usb_cs);
-  if (write_to_file && logger)
+  // Logged as one packet at the end, so it's never split across commit records
+  std::vector<uint8_t> logged_metadata;
+  const auto log_metadata = [&logged_metadata](const uint8_t* data, const size_t len)
+  {
+    logged_metadata.insert(logged_metadata.end(), data, data + len);
+  };
+
+  // Held across the whole thing so the logger can't be swapped out part way through
+  if (write_to_file)
   {
     shared_mutex_enter_blocking_shared(&logger_smtx);
-    const auto packet_id = static_cast<uint8_t>(internal::OutputPacket::Metadata);
-    logger->log_data(&packet_id, sizeof(packet_id));
+  }
+  const bool is_logging = write_to_file && logger;
+  if (is_logging)
+  {
+    logged_metadata.push_back(static_cast<uint8_t>(internal::OutputPacket::Metadata));
   }
 
+  critical_section_enter_blocking(&internal::usb_cs);
+
   auto segment_id = static_cast<uint8_t>(internal::MetadataSegment::ApplicationName);
   const size_t initial_size = sizeof(FRAMEWORK_TAG) + sizeof(uint8_t) + application_name.size() + 1;
-  auto initial_data = new uint8_t[initial_size];
+  const std::unique_ptr<uint8_t[]> initial_data(new uint8_t[initial_size]);
 
-  *reinterpret_cast<uint64_t*>(initial_data) = FRAMEWORK_TAG;
+  memcpy(initial_data.get(), &FRAMEWORK_TAG, sizeof(FRAMEWORK_TAG));
   initial_data[sizeof(FRAMEWORK_TAG)] = segment_id;
-  memcpy(initial_data + sizeof(FRAMEWORK_TAG) + sizeof(segment_id), application_name.c_str(),
+  memcpy(initial_data.get() + sizeof(FRAMEWORK_TAG) + sizeof(segment_id), application_name.c_str(),
          application_name.size() + 1);
-  internal::write_to_serial(initial_data, initial_size, false);
-  if (write_to_file && logger)
+  internal::write_to_serial(initial_data.get(), initial_size, false);
+  if (is_logging)
   {
-    logger->log_data(initial_data + sizeof(FRAMEWORK_TAG), sizeof(uint8_t) + application_name.size() + 1);
+    log_metadata(initial_data.get() + sizeof(FRAMEWORK_TAG), sizeof(uint8_t) + application_name.size() + 1);
   }
 
   const uint8_t command_count = registered_commands.size();
@@ -714,9 +1006,9 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::sen
     segment_id = static_cast<uint8_t>(internal::MetadataSegment::VariableDefinitions);
     const uint8_t segment_header[3] = {segment_id, var_count, static_cast<uint8_t>(sizeof(size_t))};
     internal::write_to_serial(segment_header, 3, false);
-    if (write_to_file && logger)
+    if (is_logging)
     {
-      logger->log_data(segment_header, 3);
+      log_metadata(segment_header, 3);
     }
 
     for (const auto& var_def : std::views::values(variable_definitions))
@@ -724,9 +1016,9 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::sen
       size_t encoded_size;
       std::unique_ptr<uint8_t[]> encoded = var_def.encode_var(encoded_size);
       internal::write_to_serial(encoded.get(), encoded_size, false);
-      if (write_to_file && logger)
+      if (is_logging)
       {
-        logger->log_data(encoded.get(), encoded_size);
+        log_metadata(encoded.get(), encoded_size);
       }
     }
   }
@@ -737,9 +1029,9 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::sen
     segment_id, static_cast<uint8_t>(persistent_data_storage->get_entry_count()), static_cast<uint8_t>(sizeof(size_t))
   };
   internal::write_to_serial(persistent_data_segment_header, 3, false);
-  if (write_to_file && logger)
+  if (is_logging)
   {
-    logger->log_data(persistent_data_segment_header, 3);
+    log_metadata(persistent_data_segment_header, 3);
   }
 
   size_t encoded_size;
@@ -747,20 +1039,19 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::sen
 
   // We need to flush here so that we can dump persistent storage
   internal::write_to_serial(encoded_data.get(), encoded_size);
-  if (write_to_file && logger)
+  if (is_logging)
   {
-    logger->log_data(encoded_data.get(), encoded_size);
-    logger->flush_log();
+    log_metadata(encoded_data.get(), encoded_size);
   }
 
   persistent_data_storage->lock_active_data();
   internal::write_to_serial(
     static_cast<uint8_t*>(persistent_data_storage->get_active_data_loc()),
     persistent_data_storage->get_total_byte_size());
-  if (write_to_file && logger)
+  if (is_logging)
   {
-    logger->log_data(static_cast<uint8_t*>(persistent_data_storage->get_active_data_loc()),
-                     persistent_data_storage->get_total_byte_size());
+    log_metadata(static_cast<uint8_t*>(persistent_data_storage->get_active_data_loc()),
+                 persistent_data_storage->get_total_byte_size());
   }
   persistent_data_storage->release_active_data();
 
@@ -775,39 +1066,197 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::sen
   memcpy(fault_segment_header + 2, &all_faults, sizeof(uint32_t));
 
   internal::write_to_serial(fault_segment_header, header_len, false);
-  if (write_to_file && logger)
+  if (is_logging)
   {
-    logger->log_data(fault_segment_header, 2);
+    log_metadata(fault_segment_header, header_len);
   }
 
   encoded_data = fault_manager->encode_all_faults(encoded_size);
   internal::write_to_serial(encoded_data.get(), encoded_size, false);
-  if (write_to_file && logger)
+  if (is_logging)
   {
-    logger->log_data(encoded_data.get(), encoded_size);
+    log_metadata(encoded_data.get(), encoded_size);
   }
 
   segment_id = static_cast<uint8_t>(internal::MetadataSegment::InitialPhase);
   const std::string curr_phase_name = flight_phase_controller->get_phase_name(current_phase);
   size_t phase_change_size = 2 * sizeof(uint8_t) + curr_phase_name.size() + 1;
-  uint8_t phase_change_packet[encoded_size] = {segment_id, static_cast<uint8_t>(current_phase)};
+  uint8_t phase_change_packet[phase_change_size];
+  phase_change_packet[0] = segment_id;
+  phase_change_packet[1] = static_cast<uint8_t>(current_phase);
   memcpy(phase_change_packet + 2, curr_phase_name.c_str(), curr_phase_name.size() + 1);
   internal::write_to_serial(phase_change_packet, phase_change_size, false);
-  if (write_to_file && logger)
+  if (is_logging)
   {
-    logger->log_data(phase_change_packet, phase_change_size);
+    log_metadata(phase_change_packet, phase_change_size);
   }
 
   segment_id = static_cast<uint8_t>(internal::MetadataSegment::MetadataEnd);
   internal::write_to_serial(&segment_id, 1);
-  if (write_to_file && logger)
+  critical_section_exit(&internal::usb_cs);
+
+  // The logger takes its own locks and the flush waits on the card, neither can happen with interrupts off
+  if (is_logging)
   {
-    logger->log_data(&segment_id, 1);
+    log_metadata(&segment_id, 1);
+    logger->begin_segment_header();
+    logger->log_data(logged_metadata.data(), logged_metadata.size());
+    logger->end_segment_header();
     did_write_metadata = logger->flush_log();
+  }
+  if (write_to_file)
+  {
     shared_mutex_exit_shared(&logger_smtx);
   }
+}
 
-  critical_section_exit(&internal::usb_cs);
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::send_usb_batch()
+{
+  if (usb_batch->size() == 0)
+  {
+    return;
+  }
+
+  internal::write_to_serial(usb_batch->get_packet(), usb_batch->get_packet_size());
+  usb_batch->clear();
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::log_state_batch()
+{
+  if (!log_batch || log_batch->size() == 0)
+  {
+    return;
+  }
+
+  // Entries all point at the start of the batch, decoding from there still gets to their state
+  for (size_t i = 0; i < log_batch->size(); i++)
+  {
+    logger->index_state(log_batch->get_seq(i), log_batch->get_us_since_boot(i), log_batch_faults,
+                        static_cast<uint8_t>(log_batch_phase));
+  }
+  if (column_encoder)
+  {
+    column_encoder->encode(*log_batch);
+    logger->log_data(column_encoder->get_packet(), column_encoder->get_packet_size());
+  }
+  else
+  {
+    logger->log_data(log_batch->get_packet(), log_batch->get_packet_size());
+  }
+  log_batch->clear();
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::record_state(
+  const uint8_t* packet, const uint32_t faults, const EFlightPhase phase, const uint64_t now_us)
+{
+  if (!log_batch)
+  {
+    log_state_packet(packet, faults, phase);
+    return;
+  }
+
+  if (log_batch->size() > 0 && !log_batch->add(packet + 1))
+  {
+    log_state_batch();
+  }
+
+  if (log_batch->size() == 0)
+  {
+    log_batch_phase = phase;
+    log_batch_faults = faults;
+    log_batch->add(packet + 1);
+  }
+
+  if (log_batch->is_due(now_us))
+  {
+    log_state_batch();
+  }
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::log_state_packet(
+  const uint8_t* packet, const uint32_t faults, const EFlightPhase phase)
+{
+  uint64_t seq, us_since_boot;
+  memcpy(&seq, packet + 1, sizeof(seq));
+  memcpy(&us_since_boot, packet + 1 + sizeof(seq), sizeof(us_since_boot));
+
+  logger->index_state(seq, us_since_boot, faults, static_cast<uint8_t>(phase));
+  logger->log_data(packet, encoded_state_size + 1);
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::evict_pre_trigger_state(
+  const uint64_t now_us)
+{
+  const internal::PreTriggerEntry entry = pre_trigger_buffer->front();
+  if (logger && entry.is_recorded)
+  {
+    record_state(entry.packet, entry.faults, static_cast<EFlightPhase>(entry.phase), now_us);
+  }
+  pre_trigger_buffer->pop();
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::drain_pre_trigger_buffer()
+{
+  const uint64_t now_us = to_us_since_boot(get_absolute_time());
+  while (pre_trigger_buffer && pre_trigger_buffer->size() > 0)
+  {
+    evict_pre_trigger_state(now_us);
+  }
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::register_flight_estimate_variables()
+{
+  flight_estimate_offset = encoded_state_size;
+  register_data_variable("Fused Altitude", "m", encoded_state_size, DataType::Float);
+  register_data_variable("Vertical Velocity", "m/s", encoded_state_size + sizeof(float), DataType::Float);
+  register_data_variable("Vertical Acceleration", "m/s^2", encoded_state_size + 2 * sizeof(float), DataType::Float);
+  register_data_variable("Time To Apogee", "s", encoded_state_size + 3 * sizeof(float), DataType::Float);
+  register_data_variable("Predicted Apogee", "m", encoded_state_size + 4 * sizeof(float), DataType::Float);
+  register_data_variable("Time To Landing", "s", encoded_state_size + 5 * sizeof(float), DataType::Float);
+  encoded_state_size += 6 * sizeof(float);
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::encode_flight_estimate(
+  uint8_t* encoded_state, const VerticalEstimate& vertical, const FlightPrediction& prediction) const
+{
+  const float values[] = {
+    vertical.altitude, vertical.velocity, vertical.acceleration, prediction.time_to_apogee, prediction.apogee_altitude,
+    prediction.time_to_landing
+  };
+  memcpy(encoded_state + flight_estimate_offset, values, sizeof(values));
+}
+
+FRAMEWORK_TEMPLATE_DECL
+void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::create_state_batchers()
+{
+  delete usb_batch;
+  delete log_batch;
+  delete column_encoder;
+  usb_batch = log_batch = nullptr;
+  column_encoder = nullptr;
+
+  if (state_batch_size > 1)
+  {
+    usb_batch = new internal::StateBatcher(state_batch_size, encoded_state_size);
+  }
+
+  if (log_layout == LogLayout::Columns)
+  {
+    log_batch = new internal::StateBatcher(COLUMN_BLOCK_STATES, encoded_state_size, COLUMN_BLOCK_MAX_AGE_MS);
+    column_encoder = new internal::ColumnBlockEncoder(variable_definitions);
+  }
+  else if (state_batch_size > 1)
+  {
+    log_batch = new internal::StateBatcher(state_batch_size, encoded_state_size);
+  }
 }
 
 FRAMEWORK_TEMPLATE_DECL
@@ -826,8 +1275,11 @@ void elijah_state_framework::ElijahStateFramework<FRAMEWORK_TEMPLATE_TYPES>::sen
   if (logger)
   {
     shared_mutex_enter_blocking_shared(&logger_smtx);
-    logger->log_data(&packet_id, 1);
-    logger->log_data(static_cast<const uint8_t*>(data), data_len);
+    // One piece, so it isn't split across commit records
+    const std::unique_ptr<uint8_t[]> logged_update(new uint8_t[data_len + 1]);
+    logged_update[0] = packet_id;
+    memcpy(logged_update.get() + 1, data, data_len);
+    logger->log_data(logged_update.get(), data_len + 1);
     logger->flush_log();
     shared_mutex_exit_shared(&logger_smtx);
   }
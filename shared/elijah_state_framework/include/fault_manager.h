@@ -1,16 +1,21 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
 #include <ranges>
-#include <malloc.h>
 
 #include "communication_channel.h"
 #include "enum_type.h"
 #include "fault_definition.h"
-#include "shared_mutex.h"
+
+// Faults are packed into a single uint32 that gets sent over the wire, the first 4 bits are communication channels
+#define FAULT_MANAGER_MAX_FAULTS 32
+#define FAULT_MANAGER_COM_CHANNEL_COUNT 4
 
 template <elijah_state_framework::internal::EnumType FaultKeyType>
 class FaultManager
@@ -23,30 +28,43 @@ public:
   [[nodiscard]] uint8_t get_fault_count() const;
   [[nodiscard]] std::unique_ptr<uint8_t[]> encode_all_faults(size_t& encoded_size) const;
 
-  [[ nodiscard ]] uint32_t get_all_faults();
+  [[ nodiscard ]] uint32_t get_all_faults() const;
   uint32_t set_fault_status(FaultKeyType key, bool is_faulted, uint8_t& fault_bit, bool& did_fault_change);
-  [[nodiscard]] bool is_faulted(FaultKeyType key);
-  [[nodiscard]] bool is_faulted(CommunicationChannel communication_channel);
+  [[nodiscard]] bool is_faulted(FaultKeyType key) const;
+  [[nodiscard]] bool is_faulted(CommunicationChannel communication_channel) const;
 
 private:
-  // the shared mutex really only locks the fault uint32
-  shared_mutex_t faults_smtx;
+  // Everything set_fault_status needs for a key, so the hot path never has to touch fault_map
+  struct FaultTableEntry
+  {
+    uint32_t fault_mask = 0;
+    uint8_t fault_bit = 0;
+    CommunicationChannel communication_channel = CommunicationChannel::None;
+  };
+
+  // Indexed directly by the underlying value of the fault key
+  static constexpr size_t FAULT_TABLE_SIZE = 1 << 8 * sizeof(std::underlying_type_t<FaultKeyType>);
 
   // Leave room for communication channel bits
-  uint8_t next_fault_bit = 4;
-  uint32_t faults;
+  uint8_t next_fault_bit = FAULT_MANAGER_COM_CHANNEL_COUNT;
+
+  // Only ever updated with a CAS, so both cores can set faults without locking or disabling interrupts
+  std::atomic<uint32_t> faults;
+
+  std::array<FaultTableEntry, FAULT_TABLE_SIZE> fault_table{};
+
+  // The fault bits of every (non-channel) fault on each communication channel
+  std::array<uint32_t, FAULT_MANAGER_COM_CHANNEL_COUNT> channel_fault_masks{};
 
+  // Only used for encoding the fault metadata, which isn't on the hot path
   std::map<uint8_t, elijah_state_framework::internal::FaultDefinition<FaultKeyType>> fault_map;
 
   void register_fault(CommunicationChannel communication_channel, std::string fault_name);
-  elijah_state_framework::internal::FaultDefinition<FaultKeyType>* find_fault(FaultKeyType fault_key);
 };
 
 template <elijah_state_framework::internal::EnumType FaultKeyType>
 FaultManager<FaultKeyType>::FaultManager(const uint32_t default_faults) : faults(default_faults)
 {
-  shared_mutex_init(&faults_smtx);
-
   register_fault(CommunicationChannel::SPI_0, "SPI 0");
   register_fault(CommunicationChannel::SPI_1, "SPI 1");
   register_fault(CommunicationChannel::I2C_0, "I2C 0");
@@ -57,6 +75,20 @@ template <elijah_state_framework::internal::EnumType FaultKeyType>
 void FaultManager<FaultKeyType>::register_fault(FaultKeyType key, std::string fault_name,
                                                 CommunicationChannel communication_channel)
 {
+  assert(next_fault_bit < FAULT_MANAGER_MAX_FAULTS);
+
+  FaultTableEntry& entry = fault_table[static_cast<uint8_t>(key)];
+  assert(entry.fault_mask == 0);
+
+  entry.fault_mask = 0x01 << next_fault_bit;
+  entry.fault_bit = next_fault_bit;
+  entry.communication_channel = communication_channel;
+
+  if (communication_channel != CommunicationChannel::None)
+  {
+    channel_fault_masks[static_cast<uint8_t>(communication_channel)] |= entry.fault_mask;
+  }
+
   fault_map.emplace(
     next_fault_bit,
     elijah_state_framework::internal::FaultDefinition<FaultKeyType>(key, fault_name, next_fault_bit,
@@ -93,101 +125,68 @@ std::unique_ptr<uint8_t[]> FaultManager<FaultKeyType>::encode_all_faults(size_t&
 }
 
 template <elijah_state_framework::internal::EnumType FaultKeyType>
-uint32_t FaultManager<FaultKeyType>::get_all_faults()
+uint32_t FaultManager<FaultKeyType>::get_all_faults() const
 {
-  shared_mutex_enter_blocking_shared(&faults_smtx);
-  const uint32_t saved_ints = save_and_disable_interrupts();
-  const uint32_t curr_faults = faults;
-  shared_mutex_exit_shared(&faults_smtx);
-  restore_interrupts(saved_ints);
-  return curr_faults;
+  return faults.load(std::memory_order_acquire);
 }
 
 template <elijah_state_framework::internal::EnumType FaultKeyEnumType>
 uint32_t FaultManager<FaultKeyEnumType>::set_fault_status(FaultKeyEnumType key, const bool is_faulted,
                                                           uint8_t& fault_bit, bool& did_fault_change)
 {
-  shared_mutex_enter_blocking_exclusive(&faults_smtx);
-  const uint32_t saved_ints = save_and_disable_interrupts();
-
-  elijah_state_framework::internal::FaultDefinition<FaultKeyEnumType>* changing_fault_def = find_fault(key);
+  const FaultTableEntry& entry = fault_table[static_cast<uint8_t>(key)];
+  assert(entry.fault_mask != 0);
 
-  assert(changing_fault_def != nullptr);
+  fault_bit = entry.fault_bit;
 
-  fault_bit = changing_fault_def->get_fault_bit();
-  const bool is_currently_faulted = (faults & 0x01 << fault_bit) > 0;
-  if (is_currently_faulted == is_faulted)
+  uint32_t curr_faults = faults.load(std::memory_order_relaxed);
+  uint32_t new_faults;
+  do
   {
-    shared_mutex_exit_exclusive(&faults_smtx);
-    restore_interrupts_from_disabled(saved_ints);
-
-    did_fault_change = false;
-    return faults;
-  }
-  did_fault_change = true;
+    const bool is_currently_faulted = (curr_faults & entry.fault_mask) > 0;
+    if (is_currently_faulted == is_faulted)
+    {
+      did_fault_change = false;
+      return curr_faults;
+    }
 
-  if (is_faulted)
-  {
-    faults |= 0x01 << fault_bit;
-  }
-  else
-  {
-    faults &= ~(0x01 << fault_bit);
-  }
+    new_faults = is_faulted ? curr_faults | entry.fault_mask : curr_faults & ~entry.fault_mask;
 
-  if (changing_fault_def->get_communication_channel() != CommunicationChannel::None)
-  {
-    bool one_active = false;
-    for (const elijah_state_framework::internal::FaultDefinition<FaultKeyEnumType>& other_com_fault_def :
-         std::views::values(fault_map))
+    // The channel is faulted as long as any fault on it is
+    if (entry.communication_channel != CommunicationChannel::None)
     {
-      if (!other_com_fault_def.is_communication_channel() &&
-        other_com_fault_def.get_communication_channel() == changing_fault_def->get_communication_channel())
+      const auto channel_idx = static_cast<uint8_t>(entry.communication_channel);
+      const uint32_t channel_mask = 0x01 << channel_idx;
+      if ((new_faults & channel_fault_masks[channel_idx]) > 0)
       {
-        one_active |= (faults & (0x01 << other_com_fault_def.get_fault_bit())) > 0;
+        new_faults |= channel_mask;
+      }
+      else
+      {
+        new_faults &= ~channel_mask;
       }
-    }
-
-    elijah_state_framework::internal::FaultDefinition<FaultKeyEnumType>& com_entry = fault_map.at(
-      static_cast<uint8_t>(changing_fault_def->get_communication_channel()));
-    if (one_active)
-    {
-      faults |= 0x01 << com_entry.get_fault_bit();
-    }
-    else
-    {
-      faults &= ~(0x01 << com_entry.get_fault_bit());
     }
   }
+  while (!faults.compare_exchange_weak(curr_faults, new_faults, std::memory_order_acq_rel,
+                                       std::memory_order_relaxed));
 
-  shared_mutex_exit_exclusive(&faults_smtx);
-  restore_interrupts_from_disabled(saved_ints);
-  return faults;
+  did_fault_change = true;
+  return new_faults;
 }
 
 template <elijah_state_framework::internal::EnumType FaultKeyType>
-bool FaultManager<FaultKeyType>::is_faulted(FaultKeyType key)
+bool FaultManager<FaultKeyType>::is_faulted(FaultKeyType key) const
 {
-  shared_mutex_enter_blocking_shared(&faults_smtx);
-
-  elijah_state_framework::internal::FaultDefinition<FaultKeyType>* def = find_fault(key);
-  assert(def != nullptr);
-
-  const bool is_faulted = (faults & 0x01 << def->get_fault_bit()) > 0;;
+  const FaultTableEntry& entry = fault_table[static_cast<uint8_t>(key)];
+  assert(entry.fault_mask != 0);
 
-  shared_mutex_exit_shared(&faults_smtx);
-  return is_faulted;
+  return (faults.load(std::memory_order_acquire) & entry.fault_mask) > 0;
 }
 
 template <elijah_state_framework::internal::EnumType FaultKeyType>
-bool FaultManager<FaultKeyType>::is_faulted(CommunicationChannel communication_channel)
+bool FaultManager<FaultKeyType>::is_faulted(CommunicationChannel communication_channel) const
 {
-  shared_mutex_enter_blocking_shared(&faults_smtx);
-
-  const bool is_faulted = (faults & 0x01 << static_cast<uint8_t>(communication_channel)) > 0;
-
-  shared_mutex_exit_shared(&faults_smtx);
-  return is_faulted;
+  return (faults.load(std::memory_order_acquire) & 0x01 << static_cast<uint8_t>(communication_channel)) > 0;
 }
 
 template <elijah_state_framework::internal::EnumType FaultKeyType>
@@ -199,20 +198,3 @@ void FaultManager<FaultKeyType>::register_fault(CommunicationChannel communicati
                       communication_channel, true)
   );
 }
-
-template <elijah_state_framework::internal::EnumType FaultKeyType>
-elijah_state_framework::internal::FaultDefinition<FaultKeyType>* FaultManager<FaultKeyType>::find_fault(
-  FaultKeyType fault_key)
-{
-  for (elijah_state_framework::internal::FaultDefinition<FaultKeyType>& fault_def : std::views::values(fault_map))
-  {
-    typename elijah_state_framework::internal::FaultDefinition<FaultKeyType>::fault_key_t check_fault_key = fault_def.
-      get_fault_key();
-    if (std::holds_alternative<FaultKeyType>(check_fault_key) && std::get<FaultKeyType>(check_fault_key) == fault_key)
-    {
-      return &fault_def;
-    }
-  }
-
-  return nullptr;
-}
@@ -1,5 +1,11 @@
 #pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+
 #include "enum_type.h"
+#include "flight_prediction.h"
+#include "vertical_kalman_filter.h"
 
 namespace elijah_state_framework
 {
@@ -9,11 +15,19 @@ namespace elijah_state_framework
   public:
     virtual ~FlightPhaseController() = default;
     virtual EFlightPhase initial_flight_phase() const = 0;
-    virtual bool should_log(EFlightPhase current_phase) const = 0;
+
+    // Minimum time between states written to the log during a phase, 0 logs every state
+    virtual uint64_t get_log_interval_us(EFlightPhase current_phase) const = 0;
 
     virtual EFlightPhase update_phase(EFlightPhase current_phase, const std::deque<TStateData>& state_history) = 0;
     virtual EFlightPhase predict_phase(EFlightPhase last_known_phase, const std::deque<TStateData>& state_history) const = 0;
 
     virtual std::string get_phase_name(EFlightPhase phase) const = 0;
+
+    // Altitude, vertical velocity and acceleration from the controller's fusion stage as of the last update_phase(),
+    // all 0 for a controller without one
+    virtual VerticalEstimate get_vertical_estimate() const { return {}; }
+    // As of the last update_phase(), all -1 for a controller that doesn't predict
+    virtual FlightPrediction get_flight_prediction() const { return {-1, -1, -1}; }
   };
 }
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace elijah_state_framework
+{
+  // When a flight phase controller expects apogee and landing, in seconds from the state it last saw. Negative when it
+  // has nothing to go on yet (on the pad), 0 once it's happened.
+  struct FlightPrediction
+  {
+    float time_to_apogee;
+    float apogee_altitude;
+    float time_to_landing;
+  };
+
+  // How long something waiting on the landing can sleep for, until it's predicted but at least min_ms and at most
+  // max_ms, so a revised prediction is still picked up. max_ms with no prediction.
+  inline uint32_t get_landing_wait_ms(const FlightPrediction& prediction, const uint32_t min_ms, const uint32_t max_ms)
+  {
+    if (prediction.time_to_landing < 0)
+    {
+      return max_ms;
+    }
+    const float landing_ms = prediction.time_to_landing * 1000;
+    return landing_ms >= static_cast<float>(max_ms) ? max_ms : std::max(static_cast<uint32_t>(landing_ms), min_ms);
+  }
+}
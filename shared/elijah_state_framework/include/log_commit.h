@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Default for LogDurability::Interval, the most that can be lost when power goes out
+#define LOG_COMMIT_INTERVAL_MS 200
+// Segment headers are only rewritten once the log has grown this much, a boot (or decoder) finds the rest by walking
+// the commit records after the header's position
+#define LOG_COMMIT_HEADER_INTERVAL (64 * 1024)
+
+namespace elijah_state_framework
+{
+  // When logged data is committed to the card. Data is always committed when the log buffer fills up, these only add to
+  // that, and a phase change always commits what was logged before it.
+  enum class LogDurability : uint8_t
+  {
+    // Every check for a log write commits whatever has been logged since the last one
+    EveryRecord,
+    // Whatever has been logged for longer than the commit interval
+    Interval,
+    // Only on phase changes, the fastest but a long coast can lose a whole buffer
+    Phase
+  };
+}
+
+namespace elijah_state_framework::internal
+{
+  /**
+   * Every segment starts with a uint64 header, the low 32 bits are the position the log was last confirmed up to and the
+   * high 32 bits are the segment's key (0 in logs from before commit records). Everything after the header is a series
+   * of commit records (after the OutputPacket::CommitRecord id):
+   *
+   *   uint32  length of the packets in the record
+   *   uint32  CRC-32 of those packets, seeded with the segment's key
+   *   packets
+   *
+   * Records can be written past the header's position before it's updated (or the power goes out), a record that's
+   * there with a valid CRC was fully written. Seeding with the key keeps old records left on the card by a deleted log
+   * from passing as ours.
+   */
+  constexpr size_t LOG_COMMIT_HEADER_SIZE = sizeof(uint8_t) + 2 * sizeof(uint32_t);
+
+  [[nodiscard]] uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len);
+
+  [[nodiscard]] constexpr uint64_t make_segment_header(const uint64_t log_pos, const uint32_t key)
+  {
+    return (log_pos & 0xFFFFFFFF) | static_cast<uint64_t>(key) << 32;
+  }
+
+  [[nodiscard]] constexpr uint64_t get_segment_header_pos(const uint64_t header)
+  {
+    return header & 0xFFFFFFFF;
+  }
+
+  [[nodiscard]] constexpr uint32_t get_segment_header_key(const uint64_t header)
+  {
+    return static_cast<uint32_t>(header >> 32);
+  }
+}
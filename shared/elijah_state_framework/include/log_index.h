@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// One entry is kept per this many logged states, plus one on every phase change
+#define LOG_INDEX_STATE_INTERVAL 64
+// Entries are held in memory until there are this many, then written to the log as one index packet
+#define LOG_INDEX_BLOCK_ENTRIES 32
+
+namespace elijah_state_framework::internal
+{
+  // Written after the last flushed byte (past next_log_pos, so the next flush overwrites it) as the offset of the last
+  // index packet followed by this tag. Each index packet points to the one before it.
+  constexpr uint64_t LOG_INDEX_TRAILER_TAG = 0x3158444E494A4C45; // "ELJINDX1"
+
+  /**
+   * Index packet layout (after the OutputPacket::LogIndex id):
+   *
+   *   uint64  offset of the previous index packet in the file, 0 for the first
+   *   uint16  entry count
+   *   for each entry:
+   *     uint64  _sequence of the state at (or just before) the offset
+   *     uint64  _us_since_boot of that state
+   *     uint64  offset of a packet in the file, decoding can start there
+   *     uint32  faults at the offset
+   *     uint8   phase at the offset
+   */
+  struct LogIndexEntry
+  {
+    uint64_t seq;
+    uint64_t us_since_boot;
+    uint64_t offset;
+    uint32_t faults;
+    uint8_t phase;
+  };
+
+  constexpr size_t LOG_INDEX_ENTRY_SIZE = 3 * sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint8_t);
+  constexpr size_t LOG_INDEX_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint16_t);
+}
@@ -11,6 +11,14 @@ namespace elijah_state_framework::internal
     Metadata = 4,
     DeviceRestartMarker = 5,
     FaultsChanged = 6,
-    PhaseChanged = 7
+    PhaseChanged = 7,
+    // Log only, see log_index.h
+    LogIndex = 8,
+    // Log only, see log_commit.h
+    CommitRecord = 9,
+    // Several states in one packet, see state_batcher.h
+    StateBatch = 10,
+    // Log only, several states transposed into columns, see column_block.h
+    ColumnBlock = 11
   };
 }
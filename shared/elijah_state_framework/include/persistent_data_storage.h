@@ -162,7 +162,8 @@ elijah_state_framework::PersistentDataStorage<PersistentKeyType>::PersistentData
 template <elijah_state_framework::internal::EnumType PersistentKeyType>
 elijah_state_framework::PersistentDataStorage<PersistentKeyType>::~PersistentDataStorage()
 {
-  if (active_data_loc != nullptr)
+  // Until something is changed the active data is read straight out of flash, which was never allocated
+  if (active_data_loc != nullptr && active_data_loc != flash_data_loc)
   {
     free(active_data_loc);
   }
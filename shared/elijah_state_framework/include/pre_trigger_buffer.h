@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace elijah_state_framework::internal
+{
+  struct PreTriggerEntry
+  {
+    // Encoded state packet, output packet byte first, valid until the entry is popped
+    const uint8_t* packet;
+    uint32_t faults;
+    uint8_t phase;
+    // The recording policy picked it, so it's logged whether or not anything flushes it
+    bool is_recorded;
+  };
+
+  // Ring of the most recent encoded state packets, all of them, in order. The ones the recording policy picked are
+  // logged as they come out the other end, and a phase change logs every one still in it, so what's logged is always
+  // in order whether or not the states around a transition were skipped.
+  class PreTriggerBuffer
+  {
+  public:
+    PreTriggerBuffer(size_t capacity, size_t packet_size);
+
+    // There has to be room, pop() the oldest first if it's full
+    void push(const uint8_t* packet, uint32_t faults, uint8_t phase, bool is_recorded);
+    void pop();
+    void clear();
+
+    [[nodiscard]] PreTriggerEntry front() const;
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool is_full() const;
+
+  private:
+    std::unique_ptr<uint8_t[]> buff;
+    std::unique_ptr<PreTriggerEntry[]> entries;
+    size_t capacity;
+    size_t packet_size;
+
+    // Index of the oldest packet
+    size_t head = 0;
+    size_t count = 0;
+  };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+#include "enum_type.h"
+#include "flight_phase_controller.h"
+
+namespace elijah_state_framework::internal
+{
+  // Decides which states make it into the log, based on the flight phase controller's per-phase interval
+  template <typename TStateData, EnumType EFlightPhase>
+  class RecordingPolicy
+  {
+  public:
+    explicit RecordingPolicy(const FlightPhaseController<TStateData, EFlightPhase>* flight_phase_controller);
+
+    [[nodiscard]] bool should_record(EFlightPhase current_phase, bool phase_changed, uint64_t sample_time_us);
+
+  private:
+    const FlightPhaseController<TStateData, EFlightPhase>* flight_phase_controller;
+
+    bool has_recorded = false;
+    uint64_t last_record_time_us = 0;
+  };
+}
+
+template <typename TStateData, elijah_state_framework::internal::EnumType EFlightPhase>
+elijah_state_framework::internal::RecordingPolicy<TStateData, EFlightPhase>::RecordingPolicy(
+  const FlightPhaseController<TStateData, EFlightPhase>* flight_phase_controller) :
+  flight_phase_controller(flight_phase_controller)
+{
+}
+
+template <typename TStateData, elijah_state_framework::internal::EnumType EFlightPhase>
+bool elijah_state_framework::internal::RecordingPolicy<TStateData, EFlightPhase>::should_record(
+  const EFlightPhase current_phase, const bool phase_changed, const uint64_t sample_time_us)
+{
+  // Always keep the state that caused a transition, so the log shows what triggered it
+  const uint64_t log_interval_us = flight_phase_controller->get_log_interval_us(current_phase);
+  const bool interval_elapsed = !has_recorded || sample_time_us - last_record_time_us >= log_interval_us;
+  if (phase_changed || interval_elapsed)
+  {
+    has_recorded = true;
+    last_record_time_us = sample_time_us;
+    return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <hw_config.h>
+#include <pico/time.h>
+
+// How often a card that's programming a block is checked on, and how long it gets before the write is given up on
+#define SD_DMA_BUSY_POLL_US 100
+#define SD_DMA_BUSY_TIMEOUT_MS 500
+
+namespace elijah_state_framework::internal
+{
+  /**
+   * Writes blocks to an SPI card in the background. The command is sent before start() returns, then each block goes
+   * out over DMA, and the DMA's completion interrupt (DMA_IRQ_1, the driver has DMA_IRQ_0) sends its CRC and checks
+   * the card took it. While the card is programming a block an alarm polls it, so nothing spins on the core that
+   * started the write.
+   *
+   * The card can't be used for anything else until wait() says the write is done, on the host the write happens in
+   * wait(). wait() polls the DMA and the card itself, so it's safe to call with interrupts off.
+   */
+  class SdDmaWriter
+  {
+  public:
+    // False if the card can't be written like this (SDIO, or a byte addressed SDSC card) or didn't take the command,
+    // nothing has been written then. blocks has to stay as it is until wait().
+    bool start(sd_card_t* sd_card, const uint8_t* blocks, uint64_t first_block, uint32_t block_count);
+
+    [[nodiscard]] bool is_busy() const;
+
+    // True if every block of the last write made it, keeps saying so until the next start()
+    bool wait();
+
+  private:
+    enum class State : uint8_t
+    {
+      Idle,
+      SendingBlock,
+      Programming,
+      Stopping,
+      Done,
+      Failed
+    };
+
+    volatile State state = State::Idle;
+
+    sd_card_t* sd_card = nullptr;
+    const uint8_t* blocks = nullptr;
+    uint64_t first_block = 0;
+    uint32_t blocks_left = 0;
+
+#if PICO_ON_DEVICE
+    absolute_time_t busy_start_time = nil_time;
+    // The alarm polling the card while it programs a block, 0 if there isn't one
+    alarm_id_t busy_alarm = 0;
+
+    // All with the writer's lock held
+    void send_block();
+    void block_sent();
+    // The alarm only gets set again if should_schedule, wait() polls without one
+    void check_busy(bool should_schedule);
+    void finish(State end_state);
+
+    static void dma_irq_handler();
+    static int64_t busy_poll_callback(alarm_id_t id, void* user_data);
+#endif
+  };
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <hw_config.h>
+
+#include "sd_dma_writer.h"
+
+#define SD_BLOCK_SIZE 512
+
+namespace elijah_state_framework::internal
+{
+  /**
+   * Writes a segment straight to the card's blocks, bypassing FatFS after it has said where the segment is. Only works
+   * for a segment that's one contiguous run of clusters (what f_expand() gives it), and only ever appends.
+   *
+   * Each write goes out as a single multi-block write (CMD25 over SPI), in the background through SdDmaWriter when the
+   * card allows it. The last partly filled block is kept here and written again, with whatever comes after it, on the
+   * next write. The first block is kept too, so the header can be rewritten without reading it back.
+   *
+   * A write isn't known to have made it until finish(), which has to be called before the card is used for anything
+   * else (FatFS included) and before the next write.
+   */
+  class SegmentBlockWriter
+  {
+  public:
+    // Finds the segment's blocks and reads in the ones that are partly written, false if it isn't contiguous. fil has
+    // to be open for reading, with its file system mounted.
+    bool open(FIL& fil, uint64_t log_pos);
+    // Waits for the last write, but forgets it whether it made it or not
+    void close();
+
+    [[nodiscard]] bool is_open() const;
+
+    // Whether len bytes at pos can be written, they have to follow straight on from the last write
+    [[nodiscard]] bool can_write(uint64_t pos, size_t len) const;
+
+    // trailer goes after the data, but the next write goes over it
+    bool write(uint64_t pos, const uint8_t* data, size_t len, const uint8_t* trailer, size_t trailer_len);
+    // Finishes the last write first, so the header never gets ahead of the data
+    bool write_header(uint64_t header);
+
+    // Waits for the last write, and writes it again through the driver if it didn't make it. If that fails too, it's
+    // still there for get_unfinished().
+    bool finish();
+    // The data of a write finish() failed on, and where in the segment it goes
+    [[nodiscard]] const uint8_t* get_unfinished(uint64_t& pos, size_t& len) const;
+
+  private:
+    sd_card_t* sd_card = nullptr;
+    uint64_t first_block = 0;
+    uint64_t size = 0;
+
+    uint8_t header_block[SD_BLOCK_SIZE] = {};
+
+    // The block the next write starts in, and how much of it is already written
+    uint64_t tail_pos = 0;
+    size_t tail_len = 0;
+    uint8_t tail_block[SD_BLOCK_SIZE] = {};
+
+    SdDmaWriter dma_writer;
+    // The last write, whole blocks, until it's known to be on the card
+    std::vector<uint8_t> unfinished_blocks;
+    uint64_t unfinished_first_block = 0;
+    bool has_unfinished = false;
+    uint64_t unfinished_pos = 0;
+    // Where the data starts in unfinished_blocks, and how much of it there is
+    size_t unfinished_offset = 0;
+    size_t unfinished_len = 0;
+  };
+}
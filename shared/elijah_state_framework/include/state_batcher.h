@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// A batch goes out once its first state is this old, even if it isn't full, so the tool and the log never fall far
+// behind at low sample rates
+#define STATE_BATCH_MAX_AGE_MS 200
+
+namespace elijah_state_framework::internal
+{
+  // Every state starts with _sequence and _us_since_boot (see START_STATE_ENCODER), a batch only has them once
+  constexpr size_t STATE_HEADER_SIZE = 2 * sizeof(uint64_t);
+
+  /**
+   * State batch packet layout (after the OutputPacket::StateBatch id):
+   *
+   *   uint8   state count
+   *   uint64  _sequence of the first state
+   *   uint64  _us_since_boot of the first state
+   *   for each state:
+   *     uint16  _sequence minus the previous state's (0 for the first)
+   *     uint32  _us_since_boot minus the previous state's (0 for the first)
+   *     ...     the rest of the encoded state, everything after _us_since_boot
+   */
+  constexpr size_t STATE_BATCH_HEADER_SIZE = 2 * sizeof(uint8_t) + 2 * sizeof(uint64_t);
+  constexpr size_t STATE_BATCH_DELTA_SIZE = sizeof(uint16_t) + sizeof(uint32_t);
+
+  // Collects encoded states into one StateBatch packet, so they go out in a single write
+  class StateBatcher
+  {
+  public:
+    // state_size is the encoded state's, without a packet id. capacity is at most 255.
+    StateBatcher(size_t capacity, size_t state_size, uint32_t max_age_ms = STATE_BATCH_MAX_AGE_MS);
+
+    // False if the state doesn't fit in this batch (it's full, or too far after the last state for the deltas), send
+    // the batch and add it again
+    bool add(const uint8_t* state);
+    void clear();
+
+    [[nodiscard]] size_t size() const;
+    // Full, or the first state is max_age_ms older than us_since_boot
+    [[nodiscard]] bool is_due(uint64_t us_since_boot) const;
+
+    // Of each state, in the order they were added
+    [[nodiscard]] uint64_t get_seq(size_t idx) const;
+    [[nodiscard]] uint64_t get_us_since_boot(size_t idx) const;
+    // Everything after _us_since_boot
+    [[nodiscard]] const uint8_t* get_state(size_t idx) const;
+
+    [[nodiscard]] const uint8_t* get_packet() const;
+    [[nodiscard]] size_t get_packet_size() const;
+
+  private:
+    size_t capacity;
+    size_t state_size;
+    uint32_t max_age_ms;
+
+    std::unique_ptr<uint8_t[]> packet;
+    size_t packet_size = STATE_BATCH_HEADER_SIZE;
+
+    std::unique_ptr<uint64_t[]> seqs;
+    std::unique_ptr<uint64_t[]> us_since_boots;
+    size_t count = 0;
+  };
+}
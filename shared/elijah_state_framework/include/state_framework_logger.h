@@ -3,40 +3,139 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 #include <pico/mutex.h>
+#include <pico/time.h>
+
+#include "log_commit.h"
+#include "log_index.h"
+#include "segment_block_writer.h"
 
 #define LOG_BUFF_SIZE 1024
 
+// Segments are preallocated to this size, so each one is a single contiguous run of clusters and a bad FAT chain only
+// takes out one of them
+#define LOG_SEGMENT_SIZE (32ull * 1024 * 1024)
+// How full the current segment gets before the next one is preallocated
+#define LOG_SEGMENT_PREALLOCATE_PERCENT 50
+// Segments are named <launch name>.000 to <launch name>.999, the last one just keeps growing
+#define LOG_MAX_SEGMENTS 1000
+// Flushes to a segment that's one contiguous run of clusters go straight to the card's blocks, FatFS is only used to
+// find where it is. Segments that aren't (a fragmented card, or one that outgrew its preallocation) go through FatFS.
+// Block writes carry on in the background after the flush returns, the next flush waits for them.
+#ifndef LOG_RAW_BLOCK_WRITES
+#define LOG_RAW_BLOCK_WRITES 1
+#endif
+
 namespace elijah_state_framework
 {
   class StateFrameworkLogger
   {
   public:
-    explicit StateFrameworkLogger(std::string file_name);
+    explicit StateFrameworkLogger(std::string launch_name, uint64_t segment_size = LOG_SEGMENT_SIZE,
+                                  LogDurability durability = LogDurability::Interval,
+                                  uint32_t commit_interval_ms = LOG_COMMIT_INTERVAL_MS);
 
     static bool init_driver_on_core();
+    [[nodiscard]] static std::string get_segment_file_name(const std::string& launch_name, uint32_t segment);
 
+    // False if an earlier boot already logged to this launch, every boot starts its own segment either way
     [[nodiscard]] bool is_new_file() const;
 
+    // Each call has to be whole packets, so a commit record never ends part way through one
     void log_data(const uint8_t* data, size_t len);
+
+    // Queue a large block for writing without going through the log buffer, not limited to LOG_BUFF_SIZE
+    void log_bulk(const uint8_t* data, size_t len);
+
+    // Call right before logging each state (or the phase change packet when the state itself isn't logged), the logger
+    // decides which ones make it into the index
+    void index_state(uint64_t seq, uint64_t us_since_boot, uint32_t faults, uint8_t phase);
+
+    // Everything logged between these is logged again at the start of every later segment, so each segment can be
+    // decoded on its own
+    void begin_segment_header();
+    void end_segment_header();
+
+    void set_durability(LogDurability new_durability, uint32_t new_commit_interval_ms = LOG_COMMIT_INTERVAL_MS);
+
+    // Moves what's been logged to the write buffer if the durability says it's time, the next flush_write_buff() puts
+    // it on the card
+    void commit_if_due(bool is_phase_change = false);
+
     bool flush_log();
-    bool flush_write_buff();
+    // Only rewrites the segment header every LOG_COMMIT_HEADER_INTERVAL unless should_update_header
+    bool flush_write_buff(bool should_update_header = false);
+
+    // Creates the next segment once the current one is LOG_SEGMENT_PREALLOCATE_PERCENT full, so rotating to it later
+    // doesn't have to find clusters in the middle of a flush. Flushes from either core wait for it, call it while
+    // there's nothing else to do.
+    bool preallocate_next_segment();
 
   private:
     mutex_t log_buff_mtx;
     recursive_mutex_t write_buff_rmtx;
 
-    std::string file_name;
+    std::string launch_name;
+    uint64_t segment_size;
     bool was_file_existing = false;
+
+    LogDurability durability;
+    uint32_t commit_interval_ms;
+    // Seeds every record's CRC, see log_commit.h
+    uint32_t segment_key = 0;
+
+    // Segment the write buffer is flushed to
+    uint32_t segment = 0;
     uint64_t next_log_pos = sizeof(uint64_t);
+    // What the segment's header on the card says, behind next_log_pos by up to LOG_COMMIT_HEADER_INTERVAL
+    uint64_t header_log_pos = sizeof(uint64_t);
+    bool is_next_segment_preallocated = false;
+
+    internal::SegmentBlockWriter block_writer;
+    // Segment the block writer was last opened for, it isn't tried again for the same one
+    uint32_t block_writer_segment = UINT32_MAX;
 
-    std::unique_ptr<uint8_t[]> log_buff = std::unique_ptr<uint8_t[]>(new uint8_t[LOG_BUFF_SIZE]);
+    // Each fill of the log buffer is one commit record, the record's header is at the start
+    std::unique_ptr<uint8_t[]> log_buff = std::unique_ptr<uint8_t[]>(
+      new uint8_t[LOG_BUFF_SIZE + internal::LOG_COMMIT_HEADER_SIZE]);
     size_t log_size = 0;
+    absolute_time_t record_start_time = nil_time;
+
+    // Segment the next logged byte will end up in and where
+    uint32_t logged_segment = 0;
+    uint64_t logged_pos = sizeof(uint64_t);
+
+    std::vector<uint8_t> segment_header;
+    bool is_capturing_header = false;
+
+    std::vector<internal::LogIndexEntry> index_entries;
+    size_t states_since_index = 0;
+    bool has_indexed = false;
+    uint8_t last_indexed_phase = 0;
+    uint64_t last_index_pos = 0;
+    // Last index packet that's in the write buffer or on the card, what the trailer points at
+    uint64_t flushable_index_pos = 0;
 
     std::unique_ptr<uint8_t[]> write_buff = std::unique_ptr<uint8_t[]>(nullptr);
     size_t write_size = 0;
 
+    // Where in the write buffer the next segment starts, SIZE_MAX if it's all for the current one
+    size_t write_split = SIZE_MAX;
+    uint64_t split_index_pos = 0;
+
+    void append_to_log_buff(const uint8_t* data, size_t len);
+    void rotate_if_full(size_t len);
+    void write_index();
     void move_to_write_buff();
-    void load_old_data();
+    void append_to_write_buff(const uint8_t* data, size_t len);
+    void append_record_to_write_buff(const uint8_t* data, size_t len);
+    void fill_record_header(uint8_t* header, const uint8_t* data, size_t len) const;
+    bool write_to_segment(const uint8_t* data, size_t len, uint64_t index_pos, bool should_update_header);
+    bool write_to_blocks(const uint8_t* data, size_t len, uint64_t index_pos, bool should_update_header);
+    bool finish_block_write();
+    bool create_segment(uint32_t new_segment) const;
+    bool recover_segment(uint32_t recovered_segment, uint64_t& log_pos, uint32_t& key) const;
+    void find_segment();
   };
 }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "enum_type.h"
+#include "flight_prediction.h"
+#include "seqlock.h"
+#include "vertical_kalman_filter.h"
+
+namespace elijah_state_framework
+{
+  template <typename TStateData, internal::EnumType EFlightPhase>
+  struct StateSnapshot
+  {
+    TStateData state;
+    EFlightPhase phase;
+
+    // The flight phase controller's estimate after this state
+    VerticalEstimate vertical;
+    FlightPrediction prediction;
+
+    // Faults at the time the state was published
+    uint32_t faults;
+
+    // Sequence number of the state, 0 if no state has been published yet
+    uint64_t seq;
+  };
+
+  namespace internal
+  {
+    // Single-writer publication of the most recent snapshot, readers on either core never block the writer and
+    // the writer only waits for the other core's writer
+    template <typename TSnapshot>
+    class SnapshotPublisher
+    {
+      static_assert(std::is_trivially_copyable_v<TSnapshot>,
+                    "Snapshots are copied bytewise and must be trivially copyable");
+
+    public:
+      explicit SnapshotPublisher(const TSnapshot& initial_snapshot);
+
+      void publish(const TSnapshot& snapshot);
+      [[nodiscard]] TSnapshot read() const;
+
+    private:
+      seqlock_t seq_lck;
+      TSnapshot latest;
+    };
+  }
+}
+
+template <typename TSnapshot>
+elijah_state_framework::internal::SnapshotPublisher<TSnapshot>::SnapshotPublisher(const TSnapshot& initial_snapshot) :
+  latest(initial_snapshot)
+{
+  seqlock_init(&seq_lck);
+}
+
+template <typename TSnapshot>
+void elijah_state_framework::internal::SnapshotPublisher<TSnapshot>::publish(const TSnapshot& snapshot)
+{
+  seqlock_write(&seq_lck, &latest, &snapshot, sizeof(TSnapshot));
+}
+
+template <typename TSnapshot>
+TSnapshot elijah_state_framework::internal::SnapshotPublisher<TSnapshot>::read() const
+{
+  TSnapshot snapshot;
+  seqlock_read(&seq_lck, &snapshot, &latest, sizeof(TSnapshot));
+  return snapshot;
+}
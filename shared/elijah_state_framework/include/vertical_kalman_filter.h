@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace elijah_state_framework
+{
+  // Where the rocket is along the vertical, up is positive and acceleration doesn't include gravity
+  struct VerticalEstimate
+  {
+    float altitude;
+    float velocity;
+    float acceleration;
+  };
+
+  /**
+   * Kalman filter over altitude, vertical velocity and vertical acceleration, fusing a barometer's altitude with an
+   * accelerometer's vertical acceleration. Acceleration is assumed constant between predictions, with changes to it
+   * (jerk) as the process noise. Each measurement is its own scalar update, so either sensor can be read at any rate
+   * or be skipped when it's faulted.
+   */
+  class VerticalKalmanFilter
+  {
+  public:
+    // Standard deviations: jerk in m/s^3 per root Hz, altitude in m, acceleration in m/s^2
+    VerticalKalmanFilter(float jerk_noise, float altitude_noise, float accel_noise);
+
+    // Starts over at rest at altitude
+    void reset(float altitude);
+    void predict(float dt_s);
+    void update_altitude(float altitude);
+    void update_acceleration(float acceleration);
+
+    [[nodiscard]] bool is_initialized() const;
+    [[nodiscard]] VerticalEstimate get_estimate() const;
+
+  private:
+    void update(uint8_t state_idx, float measurement, float measurement_variance);
+
+    float jerk_variance, altitude_variance, accel_variance;
+
+    bool initialized = false;
+    // Altitude, velocity, acceleration and their covariance
+    float x[3] = {};
+    float p[3][3] = {};
+  };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/**
+ * Statistics over the samples of the last window_us, for flight phase controllers. Each one is updated once per sample
+ * and answers in O(1), however long the window is, instead of walking the state history every time. Samples have to be
+ * pushed in time order.
+ */
+namespace elijah_state_framework
+{
+  // Smallest and largest sample in the window, each kept in a deque that only ever holds samples that could still be
+  // the min (or max) once the ones before them leave the window
+  class SlidingMinMax
+  {
+  public:
+    explicit SlidingMinMax(uint64_t window_us);
+
+    void push(uint64_t time_us, double value);
+    void clear();
+
+    [[nodiscard]] bool is_empty() const;
+    // True once samples have been pushed for at least the whole window
+    [[nodiscard]] bool is_full() const;
+    [[nodiscard]] double get_min() const;
+    [[nodiscard]] double get_max() const;
+
+  private:
+    struct Sample
+    {
+      uint64_t time_us;
+      double value;
+    };
+
+    uint64_t window_us;
+    uint64_t first_time_us = 0, last_time_us = 0;
+    bool has_samples = false;
+
+    std::deque<Sample> mins, maxes;
+  };
+
+  // Mean and variance of the window, updated as samples come in and leave (Welford's, which doesn't lose the variance
+  // of a small wobble on a big value like a sum of squares would)
+  class RunningStats
+  {
+  public:
+    explicit RunningStats(uint64_t window_us);
+
+    void push(uint64_t time_us, double value);
+    void clear();
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool is_full() const;
+    [[nodiscard]] double get_mean() const;
+    [[nodiscard]] double get_variance() const;
+
+  private:
+    struct Sample
+    {
+      uint64_t time_us;
+      double value;
+    };
+
+    void remove_oldest();
+
+    uint64_t window_us;
+    uint64_t first_time_us = 0;
+
+    std::deque<Sample> samples;
+    double mean = 0, m2 = 0;
+  };
+
+  // Which way a value has been going, as how many samples in a row it's gone up or down, and how many steps in the
+  // window went each way. A step that doesn't change counts as neither.
+  class TrendCounter
+  {
+  public:
+    explicit TrendCounter(uint64_t window_us);
+
+    void push(uint64_t time_us, double value);
+    void clear();
+
+    [[nodiscard]] size_t get_consecutive_rises() const;
+    [[nodiscard]] size_t get_consecutive_falls() const;
+    [[nodiscard]] size_t get_window_rises() const;
+    [[nodiscard]] size_t get_window_falls() const;
+
+  private:
+    struct Step
+    {
+      uint64_t time_us;
+      int8_t direction;
+    };
+
+    uint64_t window_us;
+
+    bool has_value = false;
+    double last_value = 0;
+    size_t consecutive_rises = 0, consecutive_falls = 0;
+
+    std::deque<Step> steps;
+    size_t window_rises = 0, window_falls = 0;
+  };
+}
@@ -0,0 +1,159 @@
+#include "column_block.h"
+
+#include <cstring>
+
+#include "output_packet.h"
+
+namespace
+{
+  // _sequence and _us_since_boot only live in the batcher, the rest of the state is still encoded
+  const uint8_t* get_value(const elijah_state_framework::internal::StateBatcher& batch, const size_t idx,
+                           const size_t offset, uint64_t (&state_header)[2])
+  {
+    if (offset >= elijah_state_framework::internal::STATE_HEADER_SIZE)
+    {
+      return batch.get_state(idx) + offset - elijah_state_framework::internal::STATE_HEADER_SIZE;
+    }
+
+    state_header[0] = batch.get_seq(idx);
+    state_header[1] = batch.get_us_since_boot(idx);
+    return reinterpret_cast<const uint8_t*>(state_header) + offset;
+  }
+
+  template <typename T>
+  void write_column(uint8_t* dest, const elijah_state_framework::internal::StateBatcher& batch, const size_t offset)
+  {
+    uint64_t state_header[2];
+    T min{}, max{};
+    uint8_t* values = dest + 2 * sizeof(T);
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+      T value;
+      memcpy(&value, get_value(batch, i, offset, state_header), sizeof(T));
+      memcpy(values + i * sizeof(T), &value, sizeof(T));
+
+      // A NaN is only ever kept if every value is one (min != min)
+      if (i == 0 || value < min || min != min)
+      {
+        min = value;
+      }
+      if (i == 0 || value > max || max != max)
+      {
+        max = value;
+      }
+    }
+
+    memcpy(dest, &min, sizeof(T));
+    memcpy(dest + sizeof(T), &max, sizeof(T));
+  }
+
+  // Time isn't encoded as a number, but it only goes forward
+  void write_time_column(uint8_t* dest, const elijah_state_framework::internal::StateBatcher& batch,
+                         const size_t offset, const size_t size)
+  {
+    uint64_t state_header[2];
+    uint8_t* values = dest + 2 * size;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+      memcpy(values + i * size, get_value(batch, i, offset, state_header), size);
+    }
+
+    memcpy(dest, values, size);
+    memcpy(dest + size, values + (batch.size() - 1) * size, size);
+  }
+}
+
+elijah_state_framework::internal::ColumnBlockEncoder::ColumnBlockEncoder(
+  const std::map<uint8_t, VariableDefinition>& variables)
+{
+  for (const auto& [variable_id, variable] : variables)
+  {
+    if (data_type_helpers::get_size_for_data_type(variable.get_data_type()) > 0)
+    {
+      columns.push_back({variable_id, variable.get_offset(), variable.get_data_type()});
+    }
+  }
+}
+
+void elijah_state_framework::internal::ColumnBlockEncoder::encode(const StateBatcher& batch)
+{
+  const size_t count = batch.size();
+  size_t packet_size = COLUMN_BLOCK_HEADER_SIZE;
+  for (const Column& column : columns)
+  {
+    packet_size += COLUMN_HEADER_SIZE + (count + 2) * data_type_helpers::get_size_for_data_type(column.data_type);
+  }
+
+  // Only grows, so after the first full block nothing is allocated
+  packet.resize(packet_size);
+  packet[0] = static_cast<uint8_t>(OutputPacket::ColumnBlock);
+  packet[1] = static_cast<uint8_t>(count);
+  packet[2] = static_cast<uint8_t>(columns.size());
+
+  uint8_t* dest = packet.data() + COLUMN_BLOCK_HEADER_SIZE;
+  for (const Column& column : columns)
+  {
+    const size_t size = data_type_helpers::get_size_for_data_type(column.data_type);
+    const auto column_len = static_cast<uint32_t>((count + 2) * size);
+    dest[0] = column.variable_id;
+    memcpy(dest + sizeof(uint8_t), &column_len, sizeof(column_len));
+    dest += COLUMN_HEADER_SIZE;
+
+    if (count > 0)
+    {
+      switch (column.data_type)
+      {
+      case DataType::Int8:
+        write_column<int8_t>(dest, batch, column.offset);
+        break;
+      case DataType::Uint8:
+        write_column<uint8_t>(dest, batch, column.offset);
+        break;
+      case DataType::Int16:
+        write_column<int16_t>(dest, batch, column.offset);
+        break;
+      case DataType::UInt16:
+        write_column<uint16_t>(dest, batch, column.offset);
+        break;
+      case DataType::Int32:
+        write_column<int32_t>(dest, batch, column.offset);
+        break;
+      case DataType::UInt32:
+        write_column<uint32_t>(dest, batch, column.offset);
+        break;
+      case DataType::Int64:
+        write_column<int64_t>(dest, batch, column.offset);
+        break;
+      case DataType::UInt64:
+        write_column<uint64_t>(dest, batch, column.offset);
+        break;
+      case DataType::Float:
+        write_column<float>(dest, batch, column.offset);
+        break;
+      case DataType::Double:
+        write_column<double>(dest, batch, column.offset);
+        break;
+      case DataType::Time:
+        write_time_column(dest, batch, column.offset, size);
+        break;
+      case DataType::String:
+        break;
+      }
+    }
+    else
+    {
+      memset(dest, 0, column_len);
+    }
+    dest += column_len;
+  }
+}
+
+const uint8_t* elijah_state_framework::internal::ColumnBlockEncoder::get_packet() const
+{
+  return packet.data();
+}
+
+size_t elijah_state_framework::internal::ColumnBlockEncoder::get_packet_size() const
+{
+  return packet.size();
+}
@@ -0,0 +1,31 @@
+#include "log_commit.h"
+
+#include <array>
+
+namespace
+{
+  constexpr std::array<uint32_t, 256> crc32_table = []
+  {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < table.size(); i++)
+    {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; bit++)
+      {
+        crc = crc & 1 ? crc >> 1 ^ 0xEDB88320 : crc >> 1;
+      }
+      table[i] = crc;
+    }
+    return table;
+  }();
+}
+
+uint32_t elijah_state_framework::internal::crc32(uint32_t crc, const uint8_t* data, const size_t len)
+{
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++)
+  {
+    crc = crc >> 8 ^ crc32_table[(crc ^ data[i]) & 0xFF];
+  }
+  return ~crc;
+}
@@ -0,0 +1,56 @@
+#include "pre_trigger_buffer.h"
+
+#include <cassert>
+#include <cstring>
+
+elijah_state_framework::internal::PreTriggerBuffer::PreTriggerBuffer(const size_t capacity, const size_t packet_size) :
+  buff(new uint8_t[capacity * packet_size]), entries(new PreTriggerEntry[capacity]), capacity(capacity),
+  packet_size(packet_size)
+{
+  assert(capacity > 0);
+}
+
+void elijah_state_framework::internal::PreTriggerBuffer::push(const uint8_t* packet, const uint32_t faults,
+                                                              const uint8_t phase, const bool is_recorded)
+{
+  assert(count < capacity);
+  size_t slot = head + count;
+  if (slot >= capacity)
+  {
+    slot -= capacity;
+  }
+
+  uint8_t* slot_packet = buff.get() + slot * packet_size;
+  memcpy(slot_packet, packet, packet_size);
+  entries[slot] = {.packet = slot_packet, .faults = faults, .phase = phase, .is_recorded = is_recorded};
+  count++;
+}
+
+void elijah_state_framework::internal::PreTriggerBuffer::pop()
+{
+  assert(count > 0);
+  head = head + 1 == capacity ? 0 : head + 1;
+  count--;
+}
+
+void elijah_state_framework::internal::PreTriggerBuffer::clear()
+{
+  head = 0;
+  count = 0;
+}
+
+elijah_state_framework::internal::PreTriggerEntry elijah_state_framework::internal::PreTriggerBuffer::front() const
+{
+  assert(count > 0);
+  return entries[head];
+}
+
+size_t elijah_state_framework::internal::PreTriggerBuffer::size() const
+{
+  return count;
+}
+
+bool elijah_state_framework::internal::PreTriggerBuffer::is_full() const
+{
+  return count == capacity;
+}
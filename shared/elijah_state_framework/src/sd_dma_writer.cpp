@@ -0,0 +1,346 @@
+#include "sd_dma_writer.h"
+
+#include "segment_block_writer.h"
+
+#if PICO_ON_DEVICE
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <hardware/spi.h>
+#include <hardware/sync.h>
+#include <pico/platform.h>
+
+namespace
+{
+  constexpr uint8_t WRITE_MULTIPLE_BLOCK = 25;
+  constexpr uint8_t START_BLOCK_TOKEN = 0xFC;
+  constexpr uint8_t STOP_TRAN_TOKEN = 0xFD;
+  constexpr uint8_t DATA_RESPONSE_MASK = 0x1F;
+  constexpr uint8_t DATA_ACCEPTED = 0x05;
+  // Commands get a few bytes to answer in
+  constexpr int MAX_COMMAND_RESPONSE_BYTES = 10;
+  constexpr uint32_t READY_TIMEOUT_MS = 300;
+
+  // Only the one card, so the interrupt handler just needs to know which write is going
+  elijah_state_framework::internal::SdDmaWriter* active_writer = nullptr;
+  // Held for every step of a write, whether the interrupt, the alarm or wait() takes it
+  spin_lock_t* writer_lock = nullptr;
+  int tx_channel = -1;
+  int rx_channel = -1;
+  spi_inst_t* spi = nullptr;
+  uint cs_gpio = 0;
+  uint8_t rx_discard;
+
+  uint8_t transfer_byte(const uint8_t tx)
+  {
+    uint8_t rx;
+    spi_write_read_blocking(spi, &tx, &rx, 1);
+    return rx;
+  }
+
+  // CRC7 of a command, the card might have CRCs turned on
+  uint8_t command_crc(const uint8_t* command, const size_t len)
+  {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+      uint8_t byte = command[i];
+      for (int bit = 0; bit < 8; bit++)
+      {
+        crc <<= 1;
+        if ((byte ^ crc) & 0x80)
+        {
+          crc ^= 0x09;
+        }
+        byte <<= 1;
+      }
+    }
+    return crc << 1 | 1;
+  }
+
+  bool wait_until_ready()
+  {
+    const absolute_time_t timeout_time = make_timeout_time_ms(READY_TIMEOUT_MS);
+    while (transfer_byte(0xFF) != 0xFF)
+    {
+      if (time_reached(timeout_time))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+bool elijah_state_framework::internal::SdDmaWriter::start(sd_card_t* sd_card, const uint8_t* blocks,
+                                                          const uint64_t first_block, const uint32_t block_count)
+{
+  if (is_busy() || block_count == 0 || sd_card->type != SD_IF_SPI || sd_card->state.card_type != SDCARD_V2HC)
+  {
+    return false;
+  }
+
+  // Channels are claimed on the first write, the interrupt goes to the core doing it
+  if (tx_channel < 0)
+  {
+    tx_channel = dma_claim_unused_channel(false);
+    rx_channel = dma_claim_unused_channel(false);
+    if (tx_channel < 0 || rx_channel < 0)
+    {
+      return false;
+    }
+
+    writer_lock = spin_lock_init(spin_lock_claim_unused(true));
+    irq_add_shared_handler(DMA_IRQ_1, dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+    dma_channel_set_irq1_enabled(rx_channel, true);
+  }
+
+  spi = sd_card->spi_if_p->spi->hw_inst;
+  cs_gpio = sd_card->spi_if_p->ss_gpio;
+  gpio_put(cs_gpio, false);
+
+  uint8_t command[6] = {
+    static_cast<uint8_t>(0x40 | WRITE_MULTIPLE_BLOCK), static_cast<uint8_t>(first_block >> 24),
+    static_cast<uint8_t>(first_block >> 16), static_cast<uint8_t>(first_block >> 8), static_cast<uint8_t>(first_block)
+  };
+  command[5] = command_crc(command, 5);
+
+  uint8_t response = 0xFF;
+  if (wait_until_ready())
+  {
+    spi_write_blocking(spi, command, sizeof(command));
+    for (int i = 0; i < MAX_COMMAND_RESPONSE_BYTES && response & 0x80; i++)
+    {
+      response = transfer_byte(0xFF);
+    }
+  }
+
+  if (response != 0)
+  {
+    gpio_put(cs_gpio, true);
+    transfer_byte(0xFF);
+    return false;
+  }
+
+  this->sd_card = sd_card;
+  this->blocks = blocks;
+  this->first_block = first_block;
+  blocks_left = block_count;
+  const uint32_t saved_irq = spin_lock_blocking(writer_lock);
+  active_writer = this;
+  send_block();
+  spin_unlock(writer_lock, saved_irq);
+  return true;
+}
+
+bool elijah_state_framework::internal::SdDmaWriter::is_busy() const
+{
+  return state == State::SendingBlock || state == State::Programming || state == State::Stopping;
+}
+
+bool elijah_state_framework::internal::SdDmaWriter::wait()
+{
+  // The interrupt and the alarm can't be counted on here, wait() might be called with interrupts off (inside a
+  // critical section) on the core they go to. So it moves the write along itself, polling the DMA and the card.
+  while (is_busy())
+  {
+    const uint32_t saved_irq = spin_lock_blocking(writer_lock);
+    if (state == State::SendingBlock)
+    {
+      if (!dma_channel_is_busy(rx_channel))
+      {
+        // The interrupt finds nothing to do once it does get to run
+        dma_channel_acknowledge_irq1(rx_channel);
+        block_sent();
+      }
+    }
+    else if (state == State::Programming || state == State::Stopping)
+    {
+      if (busy_alarm > 0)
+      {
+        cancel_alarm(busy_alarm);
+        busy_alarm = 0;
+      }
+      check_busy(false);
+    }
+    spin_unlock(writer_lock, saved_irq);
+    tight_loop_contents();
+  }
+
+  return state != State::Failed;
+}
+
+void elijah_state_framework::internal::SdDmaWriter::send_block()
+{
+  state = State::SendingBlock;
+
+  // The card needs a byte between blocks
+  transfer_byte(0xFF);
+  transfer_byte(START_BLOCK_TOKEN);
+
+  // Sniffing the block as it goes out gives its CRC16 for free
+  dma_channel_config tx_config = dma_channel_get_default_config(tx_channel);
+  channel_config_set_transfer_data_size(&tx_config, DMA_SIZE_8);
+  channel_config_set_dreq(&tx_config, spi_get_dreq(spi, true));
+  channel_config_set_sniff_enable(&tx_config, true);
+  dma_sniffer_enable(tx_channel, DMA_SNIFF_CTRL_CALC_VALUE_CRC16, true);
+  dma_hw->sniff_data = 0;
+
+  // Everything clocked back in is thrown away, it just can't be left in the RX FIFO
+  dma_channel_config rx_config = dma_channel_get_default_config(rx_channel);
+  channel_config_set_transfer_data_size(&rx_config, DMA_SIZE_8);
+  channel_config_set_dreq(&rx_config, spi_get_dreq(spi, false));
+  channel_config_set_read_increment(&rx_config, false);
+  channel_config_set_write_increment(&rx_config, false);
+
+  dma_channel_configure(rx_channel, &rx_config, &rx_discard, &spi_get_hw(spi)->dr, SD_BLOCK_SIZE, false);
+  dma_channel_configure(tx_channel, &tx_config, &spi_get_hw(spi)->dr, blocks, SD_BLOCK_SIZE, false);
+  dma_start_channel_mask(1u << tx_channel | 1u << rx_channel);
+}
+
+void elijah_state_framework::internal::SdDmaWriter::check_busy(const bool should_schedule)
+{
+  if (transfer_byte(0xFF) != 0xFF)
+  {
+    if (absolute_time_diff_us(busy_start_time, get_absolute_time()) > SD_DMA_BUSY_TIMEOUT_MS * 1000ll)
+    {
+      finish(State::Failed);
+    }
+    else if (should_schedule)
+    {
+      // Not fire_if_past, that would call back in here with the lock held. 0 is the time going by while it was set.
+      busy_alarm = add_alarm_in_us(SD_DMA_BUSY_POLL_US, busy_poll_callback, this, false);
+      if (busy_alarm < 0)
+      {
+        busy_alarm = 0;
+        finish(State::Failed);
+      }
+      else if (busy_alarm == 0)
+      {
+        check_busy(true);
+      }
+    }
+    return;
+  }
+
+  if (state == State::Stopping)
+  {
+    finish(State::Done);
+  }
+  else if (blocks_left > 0)
+  {
+    send_block();
+  }
+  else
+  {
+    transfer_byte(STOP_TRAN_TOKEN);
+    transfer_byte(0xFF);
+    state = State::Stopping;
+    busy_start_time = get_absolute_time();
+    check_busy(should_schedule);
+  }
+}
+
+void elijah_state_framework::internal::SdDmaWriter::finish(const State end_state)
+{
+  // Ends the write part way through if it failed, the driver's next command waits out whatever the card is doing
+  if (end_state == State::Failed && state != State::Stopping)
+  {
+    transfer_byte(STOP_TRAN_TOKEN);
+  }
+
+  gpio_put(cs_gpio, true);
+  transfer_byte(0xFF);
+  active_writer = nullptr;
+  state = end_state;
+}
+
+void elijah_state_framework::internal::SdDmaWriter::dma_irq_handler()
+{
+  if (rx_channel < 0)
+  {
+    return;
+  }
+
+  // wait() might have got to it first
+  const uint32_t saved_irq = spin_lock_blocking(writer_lock);
+  if (dma_channel_get_irq1_status(rx_channel))
+  {
+    dma_channel_acknowledge_irq1(rx_channel);
+
+    SdDmaWriter* writer = active_writer;
+    if (writer && writer->state == State::SendingBlock)
+    {
+      writer->block_sent();
+    }
+  }
+  spin_unlock(writer_lock, saved_irq);
+}
+
+void elijah_state_framework::internal::SdDmaWriter::block_sent()
+{
+  const auto crc = static_cast<uint16_t>(dma_hw->sniff_data);
+  transfer_byte(crc >> 8);
+  transfer_byte(crc & 0xFF);
+  if ((transfer_byte(0xFF) & DATA_RESPONSE_MASK) != DATA_ACCEPTED)
+  {
+    finish(State::Failed);
+    return;
+  }
+
+  blocks += SD_BLOCK_SIZE;
+  blocks_left--;
+  state = State::Programming;
+  busy_start_time = get_absolute_time();
+  check_busy(true);
+}
+
+int64_t elijah_state_framework::internal::SdDmaWriter::busy_poll_callback(const alarm_id_t id, void* user_data)
+{
+  auto* writer = static_cast<SdDmaWriter*>(user_data);
+  const uint32_t saved_irq = spin_lock_blocking(writer_lock);
+  // Left over if wait() took over the polling
+  if (id == writer->busy_alarm)
+  {
+    writer->busy_alarm = 0;
+    writer->check_busy(true);
+  }
+  spin_unlock(writer_lock, saved_irq);
+  return 0;
+}
+#else
+bool elijah_state_framework::internal::SdDmaWriter::start(sd_card_t* sd_card, const uint8_t* blocks,
+                                                          const uint64_t first_block, const uint32_t block_count)
+{
+  if (is_busy() || block_count == 0)
+  {
+    return false;
+  }
+
+  this->sd_card = sd_card;
+  this->blocks = blocks;
+  this->first_block = first_block;
+  blocks_left = block_count;
+  state = State::SendingBlock;
+  return true;
+}
+
+bool elijah_state_framework::internal::SdDmaWriter::is_busy() const
+{
+  return state == State::SendingBlock;
+}
+
+bool elijah_state_framework::internal::SdDmaWriter::wait()
+{
+  // Nothing to overlap with on the host, the write just waits until someone needs it done
+  if (state == State::SendingBlock)
+  {
+    state = sd_card->write_blocks(sd_card, blocks, first_block, blocks_left) == SD_BLOCK_DEVICE_ERROR_NONE
+              ? State::Done
+              : State::Failed;
+  }
+
+  return state != State::Failed;
+}
+#endif
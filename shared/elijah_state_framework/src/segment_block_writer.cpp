@@ -0,0 +1,152 @@
+#include "segment_block_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool elijah_state_framework::internal::SegmentBlockWriter::open(FIL& fil, const uint64_t log_pos)
+{
+  close();
+
+#if FF_USE_FASTSEEK && FF_MAX_SS == SD_BLOCK_SIZE
+  // Room for one fragment, a file in more than one doesn't fit and can't be written to directly
+  DWORD link_map[4] = {4};
+  fil.cltbl = link_map;
+  const FRESULT fr = f_lseek(&fil, CREATE_LINKMAP);
+  fil.cltbl = nullptr;
+  if (fr != FR_OK || link_map[1] == 0)
+  {
+    return false;
+  }
+
+  const FATFS* fs = fil.obj.fs;
+  first_block = fs->database + static_cast<uint64_t>(fs->csize) * (link_map[2] - 2);
+  size = std::min<uint64_t>(static_cast<uint64_t>(link_map[1]) * fs->csize * SD_BLOCK_SIZE, f_size(&fil));
+
+  size_t bytes_read;
+  if (log_pos >= size || f_lseek(&fil, 0) != FR_OK ||
+    f_read(&fil, header_block, SD_BLOCK_SIZE, &bytes_read) != FR_OK || bytes_read != SD_BLOCK_SIZE)
+  {
+    return false;
+  }
+
+  tail_pos = log_pos / SD_BLOCK_SIZE * SD_BLOCK_SIZE;
+  tail_len = log_pos - tail_pos;
+  if (f_lseek(&fil, tail_pos) != FR_OK || f_read(&fil, tail_block, tail_len, &bytes_read) != FR_OK ||
+    bytes_read != tail_len)
+  {
+    return false;
+  }
+
+  sd_card = sd_get_by_num(0);
+  return sd_card != nullptr;
+#else
+  return false;
+#endif
+}
+
+void elijah_state_framework::internal::SegmentBlockWriter::close()
+{
+  // A write that's still going needs its blocks to stay put
+  dma_writer.wait();
+  has_unfinished = false;
+  sd_card = nullptr;
+}
+
+bool elijah_state_framework::internal::SegmentBlockWriter::is_open() const
+{
+  return sd_card != nullptr;
+}
+
+bool elijah_state_framework::internal::SegmentBlockWriter::can_write(const uint64_t pos, const size_t len) const
+{
+  return is_open() && pos == tail_pos + tail_len && pos + len <= size;
+}
+
+bool elijah_state_framework::internal::SegmentBlockWriter::write(const uint64_t pos, const uint8_t* data,
+                                                                 const size_t len, const uint8_t* trailer,
+                                                                 const size_t trailer_len)
+{
+  const size_t written_len = tail_len + len + trailer_len;
+  const size_t block_count = (written_len + SD_BLOCK_SIZE - 1) / SD_BLOCK_SIZE;
+  if (has_unfinished || !can_write(pos, len) || tail_pos + block_count * SD_BLOCK_SIZE > size)
+  {
+    return false;
+  }
+
+  // Past the trailer is zeroed, so a decoder looking for more records stops there instead of at whatever was on the
+  // card before
+  unfinished_blocks.assign(block_count * SD_BLOCK_SIZE, 0);
+  uint8_t* blocks = unfinished_blocks.data();
+  memcpy(blocks, tail_block, tail_len);
+  memcpy(blocks + tail_len, data, len);
+  memcpy(blocks + tail_len + len, trailer, trailer_len);
+
+  // The header is only ever changed by write_header()
+  if (tail_pos == 0)
+  {
+    memcpy(blocks, header_block, sizeof(uint64_t));
+  }
+
+  const uint64_t block = first_block + tail_pos / SD_BLOCK_SIZE;
+  if (dma_writer.start(sd_card, blocks, block, block_count))
+  {
+    has_unfinished = true;
+    unfinished_first_block = block;
+    unfinished_pos = pos;
+    unfinished_offset = tail_len;
+    unfinished_len = len;
+  }
+  // A card the DMA writer can't drive still gets block writes, they just don't overlap with anything
+  else if (sd_card->write_blocks(sd_card, blocks, block, block_count) != SD_BLOCK_DEVICE_ERROR_NONE)
+  {
+    return false;
+  }
+
+  if (tail_pos == 0)
+  {
+    memcpy(header_block, blocks, SD_BLOCK_SIZE);
+  }
+
+  const size_t data_end = tail_len + len;
+  const size_t full_len = data_end / SD_BLOCK_SIZE * SD_BLOCK_SIZE;
+  tail_pos += full_len;
+  tail_len = data_end - full_len;
+  memcpy(tail_block, blocks + full_len, tail_len);
+  return true;
+}
+
+bool elijah_state_framework::internal::SegmentBlockWriter::write_header(const uint64_t header)
+{
+  if (!is_open() || !finish())
+  {
+    return false;
+  }
+
+  memcpy(header_block, &header, sizeof(header));
+  return sd_card->write_blocks(sd_card, header_block, first_block, 1) == SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+bool elijah_state_framework::internal::SegmentBlockWriter::finish()
+{
+  if (!has_unfinished)
+  {
+    return true;
+  }
+
+  if (!dma_writer.wait() && sd_card->write_blocks(sd_card, unfinished_blocks.data(), unfinished_first_block,
+                                                   unfinished_blocks.size() / SD_BLOCK_SIZE) !=
+    SD_BLOCK_DEVICE_ERROR_NONE)
+  {
+    return false;
+  }
+
+  has_unfinished = false;
+  return true;
+}
+
+const uint8_t* elijah_state_framework::internal::SegmentBlockWriter::get_unfinished(uint64_t& pos, size_t& len) const
+{
+  pos = unfinished_pos;
+  len = has_unfinished ? unfinished_len : 0;
+  return unfinished_blocks.data() + unfinished_offset;
+}
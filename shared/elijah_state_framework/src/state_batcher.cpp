@@ -0,0 +1,97 @@
+#include "state_batcher.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "output_packet.h"
+
+elijah_state_framework::internal::StateBatcher::StateBatcher(const size_t capacity, const size_t state_size,
+                                                           const uint32_t max_age_ms) :
+  capacity(capacity), state_size(state_size), max_age_ms(max_age_ms),
+  packet(new uint8_t[STATE_BATCH_HEADER_SIZE + capacity * (STATE_BATCH_DELTA_SIZE + state_size - STATE_HEADER_SIZE)]),
+  seqs(new uint64_t[capacity]), us_since_boots(new uint64_t[capacity])
+{
+  assert(capacity > 0 && capacity <= UINT8_MAX && state_size >= STATE_HEADER_SIZE);
+  packet[0] = static_cast<uint8_t>(OutputPacket::StateBatch);
+}
+
+bool elijah_state_framework::internal::StateBatcher::add(const uint8_t* state)
+{
+  uint64_t seq, us_since_boot;
+  memcpy(&seq, state, sizeof(seq));
+  memcpy(&us_since_boot, state + sizeof(seq), sizeof(us_since_boot));
+
+  uint16_t seq_delta = 0;
+  uint32_t us_delta = 0;
+  if (count > 0)
+  {
+    if (count >= capacity || seq < seqs[count - 1] || seq - seqs[count - 1] > UINT16_MAX ||
+      us_since_boot < us_since_boots[count - 1] || us_since_boot - us_since_boots[count - 1] > UINT32_MAX)
+    {
+      return false;
+    }
+
+    seq_delta = static_cast<uint16_t>(seq - seqs[count - 1]);
+    us_delta = static_cast<uint32_t>(us_since_boot - us_since_boots[count - 1]);
+  }
+  else
+  {
+    memcpy(packet.get() + 2, &seq, sizeof(seq));
+    memcpy(packet.get() + 2 + sizeof(seq), &us_since_boot, sizeof(us_since_boot));
+  }
+
+  uint8_t* dest = packet.get() + packet_size;
+  memcpy(dest, &seq_delta, sizeof(seq_delta));
+  memcpy(dest + sizeof(seq_delta), &us_delta, sizeof(us_delta));
+  memcpy(dest + STATE_BATCH_DELTA_SIZE, state + STATE_HEADER_SIZE, state_size - STATE_HEADER_SIZE);
+  packet_size += STATE_BATCH_DELTA_SIZE + state_size - STATE_HEADER_SIZE;
+
+  seqs[count] = seq;
+  us_since_boots[count] = us_since_boot;
+  count++;
+  packet[1] = static_cast<uint8_t>(count);
+  return true;
+}
+
+void elijah_state_framework::internal::StateBatcher::clear()
+{
+  count = 0;
+  packet_size = STATE_BATCH_HEADER_SIZE;
+}
+
+size_t elijah_state_framework::internal::StateBatcher::size() const
+{
+  return count;
+}
+
+bool elijah_state_framework::internal::StateBatcher::is_due(const uint64_t us_since_boot) const
+{
+  return count >= capacity ||
+    (count > 0 && us_since_boot >= us_since_boots[0] + max_age_ms * 1000ull);
+}
+
+uint64_t elijah_state_framework::internal::StateBatcher::get_seq(const size_t idx) const
+{
+  return seqs[idx];
+}
+
+uint64_t elijah_state_framework::internal::StateBatcher::get_us_since_boot(const size_t idx) const
+{
+  return us_since_boots[idx];
+}
+
+const uint8_t* elijah_state_framework::internal::StateBatcher::get_state(const size_t idx) const
+{
+  return packet.get() + STATE_BATCH_HEADER_SIZE + idx * (STATE_BATCH_DELTA_SIZE + state_size - STATE_HEADER_SIZE) +
+    STATE_BATCH_DELTA_SIZE;
+}
+
+const uint8_t* elijah_state_framework::internal::StateBatcher::get_packet() const
+{
+  return packet.get();
+}
+
+size_t elijah_state_framework::internal::StateBatcher::get_packet_size() const
+{
+  return packet_size;
+}
@@ -1,17 +1,34 @@
 #include "state_framework_logger.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <utility>
 #include <sd_card.h>
+#include <pico/rand.h>
 
+#include "output_packet.h"
 #include "usb_comm.h"
 
-elijah_state_framework::StateFrameworkLogger::StateFrameworkLogger(std::string file_name) : file_name(
-  std::move(file_name))
+elijah_state_framework::StateFrameworkLogger::StateFrameworkLogger(std::string launch_name,
+                                                                   const uint64_t segment_size,
+                                                                   const LogDurability durability,
+                                                                   const uint32_t commit_interval_ms) :
+  launch_name(std::move(launch_name)), segment_size(segment_size), durability(durability),
+  commit_interval_ms(commit_interval_ms)
 {
   mutex_init(&log_buff_mtx);
   recursive_mutex_init(&write_buff_rmtx);
 
-  load_old_data();
+  // 0 is what logs from before commit records have
+  while (segment_key == 0)
+  {
+    segment_key = get_rand_32();
+  }
+
+  find_segment();
+  logged_segment = segment;
+  logged_pos = next_log_pos;
 }
 
 bool elijah_state_framework::StateFrameworkLogger::init_driver_on_core()
@@ -19,6 +36,14 @@ bool elijah_state_framework::StateFrameworkLogger::init_driver_on_core()
   return sd_init_driver();
 }
 
+std::string elijah_state_framework::StateFrameworkLogger::get_segment_file_name(const std::string& launch_name,
+                                                                                const uint32_t segment)
+{
+  char extension[8];
+  snprintf(extension, sizeof(extension), ".%03u", static_cast<unsigned>(segment));
+  return launch_name + extension;
+}
+
 bool elijah_state_framework::StateFrameworkLogger::is_new_file() const
 {
   return !was_file_existing;
@@ -26,17 +51,98 @@ bool elijah_state_framework::StateFrameworkLogger::is_new_file() const
 
 void elijah_state_framework::StateFrameworkLogger::log_data(const uint8_t* data, const size_t len)
 {
-  assert(len <= LOG_BUFF_SIZE);
+  // Packets are never split across commit records, one that doesn't fit in the log buffer gets a record of its own
+  if (len > LOG_BUFF_SIZE)
+  {
+    log_bulk(data, len);
+    return;
+  }
+
+  mutex_enter_blocking(&log_buff_mtx);
+  rotate_if_full(len);
+  append_to_log_buff(data, len);
+  mutex_exit(&log_buff_mtx);
+}
+
+void elijah_state_framework::StateFrameworkLogger::log_bulk(const uint8_t* data, const size_t len)
+{
+  recursive_mutex_enter_blocking(&write_buff_rmtx);
+  mutex_enter_blocking(&log_buff_mtx);
+  rotate_if_full(len);
+
+  // Anything already in the log buffer was logged first and has to be written first
+  move_to_write_buff();
+  append_record_to_write_buff(data, len);
 
+  if (is_capturing_header)
+  {
+    segment_header.insert(segment_header.end(), data, data + len);
+  }
+
+  mutex_exit(&log_buff_mtx);
+  recursive_mutex_exit(&write_buff_rmtx);
+}
+
+void elijah_state_framework::StateFrameworkLogger::index_state(const uint64_t seq, const uint64_t us_since_boot,
+                                                               const uint32_t faults, const uint8_t phase)
+{
   mutex_enter_blocking(&log_buff_mtx);
-  if (log_size + len > LOG_BUFF_SIZE)
+
+  // Phase changes are always indexed so a decoder can jump straight to one
+  const bool is_phase_change = has_indexed && phase != last_indexed_phase;
+  if (has_indexed && !is_phase_change && ++states_since_index < LOG_INDEX_STATE_INTERVAL)
   {
-    move_to_write_buff();
+    mutex_exit(&log_buff_mtx);
+    return;
   }
 
-  memcpy(log_buff.get() + log_size, data, len);
-  log_size += len;
+  if (index_entries.size() >= LOG_INDEX_BLOCK_ENTRIES)
+  {
+    write_index();
+  }
+
+  index_entries.push_back({seq, us_since_boot, logged_pos, faults, phase});
+  states_since_index = 0;
+  has_indexed = true;
+  last_indexed_phase = phase;
+
+  mutex_exit(&log_buff_mtx);
+}
+
+void elijah_state_framework::StateFrameworkLogger::begin_segment_header()
+{
+  mutex_enter_blocking(&log_buff_mtx);
+  segment_header.clear();
+  is_capturing_header = true;
+  mutex_exit(&log_buff_mtx);
+}
+
+void elijah_state_framework::StateFrameworkLogger::end_segment_header()
+{
+  mutex_enter_blocking(&log_buff_mtx);
+  is_capturing_header = false;
+  mutex_exit(&log_buff_mtx);
+}
 
+void elijah_state_framework::StateFrameworkLogger::set_durability(const LogDurability new_durability,
+                                                                  const uint32_t new_commit_interval_ms)
+{
+  mutex_enter_blocking(&log_buff_mtx);
+  durability = new_durability;
+  commit_interval_ms = new_commit_interval_ms;
+  mutex_exit(&log_buff_mtx);
+}
+
+void elijah_state_framework::StateFrameworkLogger::commit_if_due(const bool is_phase_change)
+{
+  mutex_enter_blocking(&log_buff_mtx);
+  const bool is_due = is_phase_change || durability == LogDurability::EveryRecord ||
+    (durability == LogDurability::Interval &&
+      absolute_time_diff_us(record_start_time, get_absolute_time()) >= commit_interval_ms * 1000ll);
+  if (log_size > 0 && is_due)
+  {
+    move_to_write_buff();
+  }
   mutex_exit(&log_buff_mtx);
 }
 
@@ -44,28 +150,62 @@ bool elijah_state_framework::StateFrameworkLogger::flush_log()
 {
   recursive_mutex_enter_blocking(&write_buff_rmtx);
   mutex_enter_blocking(&log_buff_mtx);
+  write_index();
   bool did_flush = flush_write_buff();
   move_to_write_buff();
-  did_flush = did_flush && flush_write_buff();
+  did_flush = did_flush && flush_write_buff(true);
+
+  // Everything has to be on the card by the time this returns, a block write that didn't make it goes through FatFS
+  if (!finish_block_write())
+  {
+    did_flush = did_flush && flush_write_buff(true);
+  }
   mutex_exit(&log_buff_mtx);
   recursive_mutex_exit(&write_buff_rmtx);
 
   return did_flush;
 }
 
-bool elijah_state_framework::StateFrameworkLogger::flush_write_buff()
+bool elijah_state_framework::StateFrameworkLogger::flush_write_buff(const bool should_update_header)
 {
   recursive_mutex_enter_blocking(&write_buff_rmtx);
 
-  if (write_size == 0)
+  if (write_size == 0 && (!should_update_header || header_log_pos == next_log_pos))
   {
     recursive_mutex_exit(&write_buff_rmtx);
     return true;
   }
 
+  // The last flush's block write has to be on the card before the next one, or before FatFS touches the card. If it
+  // didn't make it, its data is back in the write buffer and goes through FatFS below.
+  finish_block_write();
+
+  // Once the block writer has the segment, flushing to it doesn't need the file system at all
+  const uint64_t flushed_len = write_size + (flushable_index_pos > 0 ? 2 * sizeof(uint64_t) : 0);
+  if (LOG_RAW_BLOCK_WRITES && write_split == SIZE_MAX && block_writer_segment == segment &&
+    block_writer.can_write(next_log_pos, flushed_len))
+  {
+    const bool did_write = write_to_blocks(write_buff.get(), write_size, flushable_index_pos,
+                                           should_update_header ||
+                                           next_log_pos + write_size - header_log_pos >= LOG_COMMIT_HEADER_INTERVAL);
+    if (did_write)
+    {
+      write_buff.reset();
+      write_size = 0;
+    }
+    else
+    {
+      // Back to FatFS for the rest of this segment
+      block_writer.close();
+      log_serial_message("Will not flush write buffer, failed to write blocks");
+    }
+
+    recursive_mutex_exit(&write_buff_rmtx);
+    return did_write;
+  }
+
   FATFS fs;
-  FIL fil;
-  FRESULT fr = f_mount(&fs, "0:", 1);
+  const FRESULT fr = f_mount(&fs, "0:", 1);
   if (fr != FR_OK)
   {
     recursive_mutex_exit(&write_buff_rmtx);
@@ -73,126 +213,582 @@ bool elijah_state_framework::StateFrameworkLogger::flush_write_buff()
     return false;
   }
 
-  fr = f_open(&fil, file_name.c_str(), FA_OPEN_ALWAYS | FA_READ | FA_WRITE);
-  if (fr != FR_OK)
+  if (write_split != SIZE_MAX)
+  {
+    // Finish off the current segment, the rest of the buffer starts the next one. Its header is brought up to date, so
+    // only the last segment ever has records past its header.
+    if (!write_to_segment(write_buff.get(), write_split, split_index_pos, true))
+    {
+      f_unmount("");
+      recursive_mutex_exit(&write_buff_rmtx);
+      return false;
+    }
+
+    segment++;
+    next_log_pos = header_log_pos = sizeof(uint64_t);
+    if (!is_next_segment_preallocated && !create_segment(segment))
+    {
+      log_serial_message("Failed to create next log segment");
+    }
+    is_next_segment_preallocated = false;
+
+    write_size -= write_split;
+    memmove(write_buff.get(), write_buff.get() + write_split, write_size);
+    write_split = SIZE_MAX;
+  }
+
+  const bool did_write = write_to_segment(write_buff.get(), write_size, flushable_index_pos,
+                                         should_update_header ||
+                                         next_log_pos + write_size - header_log_pos >= LOG_COMMIT_HEADER_INTERVAL);
+  f_unmount("");
+
+  if (did_write)
+  {
+    write_buff.reset();
+    write_size = 0;
+  }
+
+  recursive_mutex_exit(&write_buff_rmtx);
+  return did_write;
+}
+
+bool elijah_state_framework::StateFrameworkLogger::preallocate_next_segment()
+{
+  // Held the whole way through, every mount of the card and every block write goes through write_buff_rmtx. Anything
+  // that flushes from the other core meanwhile waits, it would be fighting over the card otherwise.
+  recursive_mutex_enter_blocking(&write_buff_rmtx);
+  const uint32_t next_segment = segment + 1;
+  if (is_next_segment_preallocated || next_segment >= LOG_MAX_SEGMENTS ||
+    next_log_pos < segment_size * LOG_SEGMENT_PREALLOCATE_PERCENT / 100)
+  {
+    recursive_mutex_exit(&write_buff_rmtx);
+    return true;
+  }
+
+  finish_block_write();
+
+  FATFS fs;
+  if (f_mount(&fs, "0:", 1) != FR_OK)
   {
-    f_unmount("");
     recursive_mutex_exit(&write_buff_rmtx);
-    log_serial_message("Will not flush write buffer, failed to open file");
     return false;
   }
+  const bool did_create = create_segment(next_segment);
+  f_unmount("");
 
-  size_t bytes_written;
-  if (f_size(&fil) == 0)
+  is_next_segment_preallocated = did_create;
+  recursive_mutex_exit(&write_buff_rmtx);
+
+  return did_create;
+}
+
+void elijah_state_framework::StateFrameworkLogger::append_to_log_buff(const uint8_t* data, const size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+
+  if (log_size + len > LOG_BUFF_SIZE + internal::LOG_COMMIT_HEADER_SIZE)
+  {
+    move_to_write_buff();
+  }
+
+  // Room for the record's header, which is filled in once the record is complete
+  if (log_size == 0)
+  {
+    log_size = internal::LOG_COMMIT_HEADER_SIZE;
+    logged_pos += internal::LOG_COMMIT_HEADER_SIZE;
+    record_start_time = get_absolute_time();
+  }
+
+  memcpy(log_buff.get() + log_size, data, len);
+  log_size += len;
+  logged_pos += len;
+
+  if (is_capturing_header)
+  {
+    segment_header.insert(segment_header.end(), data, data + len);
+  }
+}
+
+void elijah_state_framework::StateFrameworkLogger::rotate_if_full(const size_t len)
+{
+  // Leave room for the index packet written on the way out and the trailer
+  constexpr size_t reserved_size = internal::LOG_INDEX_HEADER_SIZE + LOG_INDEX_BLOCK_ENTRIES *
+    internal::LOG_INDEX_ENTRY_SIZE + 2 * internal::LOG_COMMIT_HEADER_SIZE + 2 * sizeof(uint64_t);
+
+  // A segment always gets more than just the header, however big a packet is
+  if (is_capturing_header || logged_pos + len + reserved_size <= segment_size ||
+    logged_pos <= sizeof(uint64_t) + segment_header.size() || logged_segment + 1 >= LOG_MAX_SEGMENTS)
+  {
+    return;
+  }
+
+  recursive_mutex_enter_blocking(&write_buff_rmtx);
+
+  // The write buffer can only split once, if the card has been failing long enough for a second rotation, this segment
+  // just goes over its size
+  if (write_split != SIZE_MAX)
+  {
+    recursive_mutex_exit(&write_buff_rmtx);
+    return;
+  }
+
+  write_index();
+  move_to_write_buff();
+  write_split = write_size;
+  split_index_pos = flushable_index_pos;
+
+  logged_segment++;
+  logged_pos = sizeof(uint64_t);
+  last_index_pos = flushable_index_pos = 0;
+  has_indexed = false;
+  states_since_index = 0;
+
+  append_record_to_write_buff(segment_header.data(), segment_header.size());
+
+  recursive_mutex_exit(&write_buff_rmtx);
+}
+
+void elijah_state_framework::StateFrameworkLogger::write_index()
+{
+  static_assert(internal::LOG_INDEX_HEADER_SIZE + LOG_INDEX_BLOCK_ENTRIES * internal::LOG_INDEX_ENTRY_SIZE <=
+                LOG_BUFF_SIZE, "An index packet has to fit in the log buffer");
+
+  if (index_entries.empty())
   {
-    constexpr decltype(next_log_pos) log_pos = 0;
-    fr = f_write(&fil, &log_pos, sizeof(next_log_pos), &bytes_written);
+    return;
   }
-  else
+
+  uint8_t packet[internal::LOG_INDEX_HEADER_SIZE + LOG_INDEX_BLOCK_ENTRIES * internal::LOG_INDEX_ENTRY_SIZE];
+  const auto entry_count = static_cast<uint16_t>(index_entries.size());
+  packet[0] = static_cast<uint8_t>(internal::OutputPacket::LogIndex);
+  memcpy(packet + 1, &last_index_pos, sizeof(last_index_pos));
+  memcpy(packet + 1 + sizeof(last_index_pos), &entry_count, sizeof(entry_count));
+
+  uint8_t* entry_ptr = packet + internal::LOG_INDEX_HEADER_SIZE;
+  for (const internal::LogIndexEntry& entry : index_entries)
   {
-    fr = f_lseek(&fil, next_log_pos);
+    memcpy(entry_ptr, &entry.seq, sizeof(entry.seq));
+    memcpy(entry_ptr + 8, &entry.us_since_boot, sizeof(entry.us_since_boot));
+    memcpy(entry_ptr + 16, &entry.offset, sizeof(entry.offset));
+    memcpy(entry_ptr + 24, &entry.faults, sizeof(entry.faults));
+    entry_ptr[28] = entry.phase;
+    entry_ptr += internal::LOG_INDEX_ENTRY_SIZE;
   }
 
+  // Appending can move the log buffer out, which must not count this packet as flushable yet. It can also start a new
+  // commit record, so the packet's position is only known after.
+  const size_t packet_len = entry_ptr - packet;
+  append_to_log_buff(packet, packet_len);
+  last_index_pos = logged_pos - packet_len;
+  index_entries.clear();
+}
+
+void elijah_state_framework::StateFrameworkLogger::move_to_write_buff()
+{
+  recursive_mutex_enter_blocking(&write_buff_rmtx);
+
+  // Everything logged so far is about to be in the write buffer, including the last index packet
+  flushable_index_pos = last_index_pos;
+
+  if (log_size > 0)
+  {
+    fill_record_header(log_buff.get(), log_buff.get() + internal::LOG_COMMIT_HEADER_SIZE,
+                       log_size - internal::LOG_COMMIT_HEADER_SIZE);
+  }
+
+  // If the last write buffer hasn't been flushed yet, add to it rather than dropping it
+  if (write_size > 0)
+  {
+    append_to_write_buff(log_buff.get(), log_size);
+    recursive_mutex_exit(&write_buff_rmtx);
+    log_size = 0;
+    return;
+  }
+
+  write_buff = std::move(log_buff);
+  write_size = log_size;
+  recursive_mutex_exit(&write_buff_rmtx);
+
+  log_buff = std::unique_ptr<uint8_t[]>(new uint8_t[LOG_BUFF_SIZE + internal::LOG_COMMIT_HEADER_SIZE]);
+  log_size = 0;
+}
+
+void elijah_state_framework::StateFrameworkLogger::append_to_write_buff(const uint8_t* data, const size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+
+  recursive_mutex_enter_blocking(&write_buff_rmtx);
+  std::unique_ptr<uint8_t[]> new_write_buff(new uint8_t[write_size + len]);
+  if (write_size > 0)
+  {
+    memcpy(new_write_buff.get(), write_buff.get(), write_size);
+  }
+  memcpy(new_write_buff.get() + write_size, data, len);
+
+  write_buff = std::move(new_write_buff);
+  write_size += len;
+  recursive_mutex_exit(&write_buff_rmtx);
+}
+
+void elijah_state_framework::StateFrameworkLogger::append_record_to_write_buff(const uint8_t* data, const size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+
+  uint8_t record_header[internal::LOG_COMMIT_HEADER_SIZE];
+  fill_record_header(record_header, data, len);
+  append_to_write_buff(record_header, sizeof(record_header));
+  append_to_write_buff(data, len);
+  logged_pos += sizeof(record_header) + len;
+}
+
+void elijah_state_framework::StateFrameworkLogger::fill_record_header(uint8_t* header, const uint8_t* data,
+                                                                      const size_t len) const
+{
+  const auto record_len = static_cast<uint32_t>(len);
+  const uint32_t record_crc = internal::crc32(segment_key, data, len);
+  header[0] = static_cast<uint8_t>(internal::OutputPacket::CommitRecord);
+  memcpy(header + 1, &record_len, sizeof(record_len));
+  memcpy(header + 1 + sizeof(record_len), &record_crc, sizeof(record_crc));
+}
+
+bool elijah_state_framework::StateFrameworkLogger::write_to_segment(const uint8_t* data, const size_t len,
+                                                                    const uint64_t index_pos,
+                                                                    const bool should_update_header)
+{
+  FIL fil;
+  const std::string file_name = get_segment_file_name(launch_name, segment);
+  FRESULT fr = f_open(&fil, file_name.c_str(), FA_OPEN_ALWAYS | FA_READ | FA_WRITE);
+  if (fr != FR_OK)
+  {
+    log_serial_message("Will not flush write buffer, failed to open file");
+    return false;
+  }
+
+#if LOG_RAW_BLOCK_WRITES
+  // The first flush to each segment finds its blocks, every later one can skip FatFS (see flush_write_buff())
+  if (block_writer_segment != segment)
+  {
+    block_writer_segment = segment;
+    if (block_writer.open(fil, next_log_pos))
+    {
+      f_close(&fil);
+      if (write_to_blocks(data, len, index_pos, should_update_header))
+      {
+        return true;
+      }
+
+      block_writer.close();
+      fr = f_open(&fil, file_name.c_str(), FA_OPEN_ALWAYS | FA_READ | FA_WRITE);
+      if (fr != FR_OK)
+      {
+        log_serial_message("Will not flush write buffer, failed to open file");
+        return false;
+      }
+    }
+  }
+#endif
+
+  // Preallocated segments are already their full size, so the file's size says nothing about where the log ends
+  fr = f_lseek(&fil, next_log_pos);
   if (fr != FR_OK)
   {
     f_close(&fil);
-    f_unmount("");
-    recursive_mutex_exit(&write_buff_rmtx);
-    log_serial_message("Will not flush write buffer, failed to seek to or write next log position");
+    log_serial_message("Will not flush write buffer, failed to seek to next log position");
     return false;
   }
 
-  fr = f_write(&fil, write_buff.get(), write_size, &bytes_written);
-  if (fr != FR_OK || bytes_written != write_size)
+  size_t bytes_written;
+  fr = f_write(&fil, data, len, &bytes_written);
+  if (fr != FR_OK || bytes_written != len)
   {
     f_close(&fil);
-    f_unmount("");
-    recursive_mutex_exit(&write_buff_rmtx);
     log_serial_message("Will not flush write buffer, failed to write data");
     return false;
   }
-  next_log_pos += write_size;
+  next_log_pos += len;
+
+  // Not counted in next_log_pos, so the next flush writes over it. Losing it only costs decoders the index.
+  if (index_pos > 0)
+  {
+    const uint64_t trailer[2] = {index_pos, internal::LOG_INDEX_TRAILER_TAG};
+    size_t trailer_bytes_written;
+    f_write(&fil, trailer, sizeof(trailer), &trailer_bytes_written);
+  }
+
+  // The records are enough to find where the log ends, the header only saves walking all of them
+  if (!should_update_header)
+  {
+    fr = f_close(&fil);
+    if (fr != FR_OK)
+    {
+      log_serial_message("Will not flush write buffer, failed to close file");
+      return false;
+    }
+    return true;
+  }
 
   fr = f_lseek(&fil, 0);
-  if (fr != FR_OK || bytes_written != write_size)
+  if (fr != FR_OK)
   {
     f_close(&fil);
-    f_unmount("");
-    recursive_mutex_exit(&write_buff_rmtx);
     log_serial_message("Failed to update log position, could not seek to beginning of file to write next log position");
     return false;
   }
 
-  fr = f_write(&fil, &next_log_pos, sizeof(next_log_pos), &bytes_written);
+  const uint64_t header = internal::make_segment_header(next_log_pos, segment_key);
+  fr = f_write(&fil, &header, sizeof(header), &bytes_written);
   f_close(&fil);
-  f_unmount("");
 
   if (fr != FR_OK)
   {
-    recursive_mutex_exit(&write_buff_rmtx);
     log_serial_message("Failed to update log position, unable to write at beginning of file");
     return false;
   }
+  header_log_pos = next_log_pos;
+  return true;
+}
 
-  write_buff.reset();
-  write_size = 0;
+bool elijah_state_framework::StateFrameworkLogger::write_to_blocks(const uint8_t* data, const size_t len,
+                                                                   const uint64_t index_pos,
+                                                                   const bool should_update_header)
+{
+  const uint64_t trailer[2] = {index_pos, internal::LOG_INDEX_TRAILER_TAG};
+  const size_t trailer_len = index_pos > 0 ? sizeof(trailer) : 0;
+  if (!block_writer.write(next_log_pos, data, len, reinterpret_cast<const uint8_t*>(trailer), trailer_len))
+  {
+    return false;
+  }
+  next_log_pos += len;
 
-  recursive_mutex_exit(&write_buff_rmtx);
+  // The data is already on the card, a header that didn't get written just means the next boot walks more records
+  if (should_update_header)
+  {
+    if (block_writer.write_header(internal::make_segment_header(next_log_pos, segment_key)))
+    {
+      header_log_pos = next_log_pos;
+    }
+    else
+    {
+      log_serial_message("Failed to update log position, unable to write header block");
+    }
+  }
   return true;
 }
 
-void elijah_state_framework::StateFrameworkLogger::move_to_write_buff()
+bool elijah_state_framework::StateFrameworkLogger::finish_block_write()
 {
-  recursive_mutex_enter_blocking(&write_buff_rmtx);
-  write_buff = std::move(log_buff);
-  write_size = log_size;
-  recursive_mutex_exit(&write_buff_rmtx);
+  if (block_writer.finish())
+  {
+    return true;
+  }
 
-  log_buff = std::unique_ptr<uint8_t[]>(new uint8_t[LOG_BUFF_SIZE]);
-  log_size = 0;
+  // Put what didn't make it back at the front of the write buffer, FatFS writes it again where it was meant to go
+  uint64_t unfinished_pos;
+  size_t unfinished_len;
+  const uint8_t* unfinished = block_writer.get_unfinished(unfinished_pos, unfinished_len);
+  std::unique_ptr<uint8_t[]> new_write_buff(new uint8_t[unfinished_len + write_size]);
+  memcpy(new_write_buff.get(), unfinished, unfinished_len);
+  if (write_size > 0)
+  {
+    memcpy(new_write_buff.get() + unfinished_len, write_buff.get(), write_size);
+  }
+
+  write_buff = std::move(new_write_buff);
+  write_size += unfinished_len;
+  if (write_split != SIZE_MAX)
+  {
+    write_split += unfinished_len;
+  }
+  next_log_pos = unfinished_pos;
+
+  // Back to FatFS for the rest of this segment
+  block_writer.close();
+  log_serial_message("Failed to write blocks, writing them through the file system instead");
+  return false;
 }
 
-void elijah_state_framework::StateFrameworkLogger::load_old_data()
+bool elijah_state_framework::StateFrameworkLogger::create_segment(const uint32_t new_segment) const
 {
-  FATFS fs;
   FIL fil;
-  FRESULT fr = f_mount(&fs, "0:", 1);
+  const std::string file_name = get_segment_file_name(launch_name, new_segment);
+  FRESULT fr = f_open(&fil, file_name.c_str(), FA_CREATE_NEW | FA_WRITE);
+
+  // An empty segment left by an earlier boot is taken over, its header just needs our key
+  const bool is_existing = fr == FR_EXIST;
+  if (is_existing)
+  {
+    fr = f_open(&fil, file_name.c_str(), FA_OPEN_EXISTING | FA_WRITE);
+  }
   if (fr != FR_OK)
   {
-    return;
+    return false;
   }
 
-  fr = f_stat(file_name.c_str(), nullptr);
-  was_file_existing = fr != FR_NO_FILE;
-  if (was_file_existing)
+  // A card too fragmented for a contiguous run still works, writes just have to allocate clusters as they go
+#if FF_USE_EXPAND
+  if (!is_existing)
   {
-    return;
+    f_expand(&fil, segment_size, 1);
   }
+#endif
 
-  fr = f_open(&fil, file_name.c_str(), FA_READ);
-  if (fr != FR_OK)
+  // Marks the segment as empty, otherwise whatever was on the card before would look like data
+  const uint64_t empty_header = internal::make_segment_header(sizeof(uint64_t), segment_key);
+  size_t bytes_written;
+  fr = f_lseek(&fil, 0);
+  if (fr == FR_OK)
   {
-    f_unmount("");
-    return;
+    fr = f_write(&fil, &empty_header, sizeof(empty_header), &bytes_written);
   }
+  f_close(&fil);
 
-  fr = f_lseek(&fil, 0);
-  if (fr != FR_OK)
+  return fr == FR_OK;
+}
+
+bool elijah_state_framework::StateFrameworkLogger::recover_segment(const uint32_t recovered_segment,
+                                                                   uint64_t& log_pos, uint32_t& key) const
+{
+  FIL fil;
+  if (f_open(&fil, get_segment_file_name(launch_name, recovered_segment).c_str(), FA_READ | FA_WRITE) != FR_OK)
   {
-    f_close(&fil);
-    f_unmount("");
-    return;
+    return false;
   }
 
+  uint64_t header;
   size_t bytes_read;
-  decltype(next_log_pos) read_log_pos;
-  fr = f_read(&fil, &read_log_pos, sizeof(next_log_pos), &bytes_read);
+  if (f_read(&fil, &header, sizeof(header), &bytes_read) != FR_OK || bytes_read != sizeof(header))
+  {
+    f_close(&fil);
+    return false;
+  }
+
+  log_pos = internal::get_segment_header_pos(header);
+  key = internal::get_segment_header_key(header);
+  if (key == 0)
+  {
+    // From before commit records, the header is all there is
+    f_close(&fil);
+    return true;
+  }
+
+  // Walk whatever records made it to the card after the header was last updated, up to the first one that didn't make
+  // it in full
+  const uint64_t file_size = f_size(&fil);
+  uint64_t end_pos = log_pos;
+  uint8_t buff[512];
+  while (true)
+  {
+    uint8_t record_header[internal::LOG_COMMIT_HEADER_SIZE];
+    if (f_lseek(&fil, end_pos) != FR_OK || f_read(&fil, record_header, sizeof(record_header), &bytes_read) != FR_OK ||
+      bytes_read != sizeof(record_header) ||
+      record_header[0] != static_cast<uint8_t>(internal::OutputPacket::CommitRecord))
+    {
+      break;
+    }
+
+    uint32_t record_len, record_crc;
+    memcpy(&record_len, record_header + 1, sizeof(record_len));
+    memcpy(&record_crc, record_header + 1 + sizeof(record_len), sizeof(record_crc));
+    if (record_len > file_size - end_pos - sizeof(record_header))
+    {
+      break;
+    }
+
+    uint32_t crc = key;
+    size_t remaining = record_len;
+    while (remaining > 0)
+    {
+      const size_t chunk_len = std::min(remaining, sizeof(buff));
+      if (f_read(&fil, buff, chunk_len, &bytes_read) != FR_OK || bytes_read != chunk_len)
+      {
+        break;
+      }
+      crc = internal::crc32(crc, buff, chunk_len);
+      remaining -= chunk_len;
+    }
+
+    if (remaining > 0 || crc != record_crc)
+    {
+      break;
+    }
+    end_pos += sizeof(record_header) + record_len;
+  }
+
+  // Saves decoders walking them again
+  if (end_pos != log_pos)
+  {
+    const uint64_t recovered_header = internal::make_segment_header(end_pos, key);
+    size_t bytes_written;
+    if (f_lseek(&fil, 0) == FR_OK)
+    {
+      f_write(&fil, &recovered_header, sizeof(recovered_header), &bytes_written);
+    }
+    log_pos = end_pos;
+  }
 
   f_close(&fil);
-  f_unmount("");
+  return true;
+}
 
-  if (fr == FR_OK)
+void elijah_state_framework::StateFrameworkLogger::find_segment()
+{
+  FATFS fs;
+  if (f_mount(&fs, "0:", 1) != FR_OK)
   {
-    next_log_pos = read_log_pos;
+    return;
   }
+
+  uint32_t segment_count = 0;
+  while (segment_count < LOG_MAX_SEGMENTS &&
+    f_stat(get_segment_file_name(launch_name, segment_count).c_str(), nullptr) == FR_OK)
+  {
+    segment_count++;
+  }
+
+  segment = segment_count;
+  bool is_continuing_segment = false;
+  if (segment_count > 0)
+  {
+    // The last boot's headers can be behind what it wrote, find where it really stopped
+    uint64_t last_log_pos = 0;
+    uint32_t last_key = 0;
+    const bool is_readable = recover_segment(segment_count - 1, last_log_pos, last_key);
+
+    // The last segment might have been preallocated and never written to, it can be used instead of starting another.
+    // The one before it is then the one the last boot stopped in.
+    if (is_readable && last_log_pos <= sizeof(uint64_t))
+    {
+      uint64_t previous_log_pos;
+      uint32_t previous_key;
+      if (segment_count > 1)
+      {
+        recover_segment(segment_count - 2, previous_log_pos, previous_key);
+      }
+      segment = segment_count - 1;
+    }
+    // Out of segments, the last one keeps growing
+    else if (segment_count == LOG_MAX_SEGMENTS)
+    {
+      segment = segment_count - 1;
+      next_log_pos = header_log_pos = is_readable ? last_log_pos : sizeof(uint64_t);
+      segment_key = last_key != 0 ? last_key : segment_key;
+      is_continuing_segment = true;
+    }
+  }
+
+  was_file_existing = segment > 0;
+  if (!is_continuing_segment)
+  {
+    create_segment(segment);
+  }
+  f_unmount("");
 }
@@ -0,0 +1,137 @@
+#include "vertical_kalman_filter.h"
+
+namespace
+{
+  // Nothing is known about the velocity or acceleration when the filter starts
+  constexpr float INITIAL_VARIANCE = 100;
+}
+
+elijah_state_framework::VerticalKalmanFilter::VerticalKalmanFilter(const float jerk_noise, const float altitude_noise,
+                                                                   const float accel_noise) :
+  jerk_variance(jerk_noise * jerk_noise), altitude_variance(altitude_noise * altitude_noise),
+  accel_variance(accel_noise * accel_noise)
+{
+}
+
+void elijah_state_framework::VerticalKalmanFilter::reset(const float altitude)
+{
+  x[0] = altitude;
+  x[1] = 0;
+  x[2] = 0;
+
+  for (auto& row : p)
+  {
+    for (float& cell : row)
+    {
+      cell = 0;
+    }
+  }
+  p[0][0] = altitude_variance;
+  p[1][1] = INITIAL_VARIANCE;
+  p[2][2] = INITIAL_VARIANCE;
+
+  initialized = true;
+}
+
+void elijah_state_framework::VerticalKalmanFilter::predict(const float dt_s)
+{
+  if (!initialized || dt_s <= 0)
+  {
+    return;
+  }
+
+  const float dt2 = dt_s * dt_s;
+  const float f[3][3] = {
+    {1, dt_s, dt2 / 2},
+    {0, 1, dt_s},
+    {0, 0, 1}
+  };
+
+  x[0] += x[1] * dt_s + x[2] * dt2 / 2;
+  x[1] += x[2] * dt_s;
+
+  // P = F P F^T + Q
+  float fp[3][3];
+  for (int row = 0; row < 3; row++)
+  {
+    for (int col = 0; col < 3; col++)
+    {
+      fp[row][col] = f[row][0] * p[0][col] + f[row][1] * p[1][col] + f[row][2] * p[2][col];
+    }
+  }
+  for (int row = 0; row < 3; row++)
+  {
+    for (int col = 0; col < 3; col++)
+    {
+      p[row][col] = fp[row][0] * f[col][0] + fp[row][1] * f[col][1] + fp[row][2] * f[col][2];
+    }
+  }
+
+  // Jerk as white noise, integrated up through acceleration, velocity and altitude over dt
+  const float dt3 = dt2 * dt_s, dt4 = dt3 * dt_s, dt5 = dt4 * dt_s;
+  p[0][0] += jerk_variance * dt5 / 20;
+  p[0][1] += jerk_variance * dt4 / 8;
+  p[0][2] += jerk_variance * dt3 / 6;
+  p[1][0] += jerk_variance * dt4 / 8;
+  p[1][1] += jerk_variance * dt3 / 3;
+  p[1][2] += jerk_variance * dt2 / 2;
+  p[2][0] += jerk_variance * dt3 / 6;
+  p[2][1] += jerk_variance * dt2 / 2;
+  p[2][2] += jerk_variance * dt_s;
+}
+
+void elijah_state_framework::VerticalKalmanFilter::update_altitude(const float altitude)
+{
+  if (!initialized)
+  {
+    reset(altitude);
+    return;
+  }
+  update(0, altitude, altitude_variance);
+}
+
+void elijah_state_framework::VerticalKalmanFilter::update_acceleration(const float acceleration)
+{
+  if (initialized)
+  {
+    update(2, acceleration, accel_variance);
+  }
+}
+
+bool elijah_state_framework::VerticalKalmanFilter::is_initialized() const
+{
+  return initialized;
+}
+
+elijah_state_framework::VerticalEstimate elijah_state_framework::VerticalKalmanFilter::get_estimate() const
+{
+  return {x[0], x[1], x[2]};
+}
+
+void elijah_state_framework::VerticalKalmanFilter::update(const uint8_t state_idx, const float measurement,
+                                                          const float measurement_variance)
+{
+  // The measurement is one of the states directly, so the gain is just that state's column of P
+  const float innovation = measurement - x[state_idx];
+  const float innovation_variance = p[state_idx][state_idx] + measurement_variance;
+  if (innovation_variance <= 0)
+  {
+    return;
+  }
+
+  float gain[3];
+  for (int i = 0; i < 3; i++)
+  {
+    gain[i] = p[i][state_idx] / innovation_variance;
+    x[i] += gain[i] * innovation;
+  }
+
+  const float measured_row[3] = {p[state_idx][0], p[state_idx][1], p[state_idx][2]};
+  for (int row = 0; row < 3; row++)
+  {
+    for (int col = 0; col < 3; col++)
+    {
+      p[row][col] -= gain[row] * measured_row[col];
+    }
+  }
+}
@@ -0,0 +1,216 @@
+#include "windowed_stats.h"
+
+namespace
+{
+  // Whether a sample at time_us has left a window ending at now_us
+  bool is_expired(const uint64_t time_us, const uint64_t now_us, const uint64_t window_us)
+  {
+    return now_us - time_us > window_us;
+  }
+}
+
+elijah_state_framework::SlidingMinMax::SlidingMinMax(const uint64_t window_us) : window_us(window_us)
+{
+}
+
+void elijah_state_framework::SlidingMinMax::push(const uint64_t time_us, const double value)
+{
+  if (!has_samples)
+  {
+    first_time_us = time_us;
+    has_samples = true;
+  }
+  last_time_us = time_us;
+
+  // Anything the new sample is at least as small (or large) as can't be the min (or max) again before it leaves
+  while (!mins.empty() && mins.back().value >= value)
+  {
+    mins.pop_back();
+  }
+  mins.push_back({time_us, value});
+
+  while (!maxes.empty() && maxes.back().value <= value)
+  {
+    maxes.pop_back();
+  }
+  maxes.push_back({time_us, value});
+
+  while (is_expired(mins.front().time_us, time_us, window_us))
+  {
+    mins.pop_front();
+  }
+  while (is_expired(maxes.front().time_us, time_us, window_us))
+  {
+    maxes.pop_front();
+  }
+}
+
+void elijah_state_framework::SlidingMinMax::clear()
+{
+  mins.clear();
+  maxes.clear();
+  has_samples = false;
+}
+
+bool elijah_state_framework::SlidingMinMax::is_empty() const
+{
+  return !has_samples;
+}
+
+bool elijah_state_framework::SlidingMinMax::is_full() const
+{
+  return has_samples && last_time_us - first_time_us >= window_us;
+}
+
+double elijah_state_framework::SlidingMinMax::get_min() const
+{
+  return mins.empty() ? 0 : mins.front().value;
+}
+
+double elijah_state_framework::SlidingMinMax::get_max() const
+{
+  return maxes.empty() ? 0 : maxes.front().value;
+}
+
+elijah_state_framework::RunningStats::RunningStats(const uint64_t window_us) : window_us(window_us)
+{
+}
+
+void elijah_state_framework::RunningStats::push(const uint64_t time_us, const double value)
+{
+  if (samples.empty())
+  {
+    first_time_us = time_us;
+  }
+
+  samples.push_back({time_us, value});
+  const double delta = value - mean;
+  mean += delta / static_cast<double>(samples.size());
+  m2 += delta * (value - mean);
+
+  while (is_expired(samples.front().time_us, time_us, window_us))
+  {
+    remove_oldest();
+  }
+}
+
+void elijah_state_framework::RunningStats::clear()
+{
+  samples.clear();
+  mean = 0;
+  m2 = 0;
+}
+
+size_t elijah_state_framework::RunningStats::size() const
+{
+  return samples.size();
+}
+
+bool elijah_state_framework::RunningStats::is_full() const
+{
+  return !samples.empty() && samples.back().time_us - first_time_us >= window_us;
+}
+
+double elijah_state_framework::RunningStats::get_mean() const
+{
+  return mean;
+}
+
+double elijah_state_framework::RunningStats::get_variance() const
+{
+  // Rounding can leave it a hair under 0 when every sample is the same
+  return samples.size() > 1 && m2 > 0 ? m2 / static_cast<double>(samples.size() - 1) : 0;
+}
+
+void elijah_state_framework::RunningStats::remove_oldest()
+{
+  const double value = samples.front().value;
+  samples.pop_front();
+
+  if (samples.empty())
+  {
+    mean = 0;
+    m2 = 0;
+    return;
+  }
+
+  // Welford's update run backwards
+  const double delta = value - mean;
+  mean -= delta / static_cast<double>(samples.size());
+  m2 -= delta * (value - mean);
+}
+
+elijah_state_framework::TrendCounter::TrendCounter(const uint64_t window_us) : window_us(window_us)
+{
+}
+
+void elijah_state_framework::TrendCounter::push(const uint64_t time_us, const double value)
+{
+  if (!has_value)
+  {
+    last_value = value;
+    has_value = true;
+    return;
+  }
+
+  int8_t direction = 0;
+  if (value > last_value)
+  {
+    direction = 1;
+    window_rises++;
+    consecutive_rises++;
+    consecutive_falls = 0;
+  }
+  else if (value < last_value)
+  {
+    direction = -1;
+    window_falls++;
+    consecutive_falls++;
+    consecutive_rises = 0;
+  }
+  last_value = value;
+
+  steps.push_back({time_us, direction});
+  while (is_expired(steps.front().time_us, time_us, window_us))
+  {
+    if (steps.front().direction > 0)
+    {
+      window_rises--;
+    }
+    else if (steps.front().direction < 0)
+    {
+      window_falls--;
+    }
+    steps.pop_front();
+  }
+}
+
+void elijah_state_framework::TrendCounter::clear()
+{
+  has_value = false;
+  consecutive_rises = 0;
+  consecutive_falls = 0;
+  steps.clear();
+  window_rises = 0;
+  window_falls = 0;
+}
+
+size_t elijah_state_framework::TrendCounter::get_consecutive_rises() const
+{
+  return consecutive_rises;
+}
+
+size_t elijah_state_framework::TrendCounter::get_consecutive_falls() const
+{
+  return consecutive_falls;
+}
+
+size_t elijah_state_framework::TrendCounter::get_window_rises() const
+{
+  return window_rises;
+}
+
+size_t elijah_state_framework::TrendCounter::get_window_falls() const
+{
+  return window_falls;
+}
@@ -68,6 +68,10 @@ public:
   bool get_data(double& xa, double& ya, double& za, double& xg,
                 double& yg, double& zg);
 
+  // Scales raw counts and applies the calibration, everything get_data does after the bus transfer
+  void compensate(int16_t raw_xa, int16_t raw_ya, int16_t raw_za, int16_t raw_xg, int16_t raw_yg, int16_t raw_zg,
+                  double& xa, double& ya, double& za, double& xg, double& yg, double& zg) const;
+
 private:
   static constexpr uint8_t REG_SELF_TEST_X = 0x0D;
   static constexpr uint8_t REG_SELF_TEST_Y = 0x0E;
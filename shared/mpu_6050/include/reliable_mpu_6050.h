@@ -3,7 +3,6 @@
 #include <hardware/gpio.h>
 
 #include "mpu_6050.h"
-#include "pin_outs.h"
 #include "reliable_component_helper.h"
 
 FRAMEWORK_TEMPLATE_DECL
@@ -68,7 +67,7 @@ void ReliableMPU6050<FRAMEWORK_TEMPLATE_TYPES>::calibrate(const unsigned int cyc
   MPU_OVERRIDE_PERSISTENT_STATE_SAVE(calib_xa_key, diff_xa);
   MPU_OVERRIDE_PERSISTENT_STATE_SAVE(calib_ya_key, diff_ya);
   MPU_OVERRIDE_PERSISTENT_STATE_SAVE(calib_za_key, diff_za);
-  MPU_OVERRIDE_PERSISTENT_STATE_SAVE(calib_xg_key, diff_yg);
+  MPU_OVERRIDE_PERSISTENT_STATE_SAVE(calib_xg_key, diff_xg);
   MPU_OVERRIDE_PERSISTENT_STATE_SAVE(calib_yg_key, diff_yg);
   MPU_OVERRIDE_PERSISTENT_STATE_SAVE(calib_zg_key, diff_zg);
 #undef MPU_OVERRIDE_PERSISTENT_STATE_SAVE
@@ -222,20 +222,25 @@ bool MPU6050::get_uncompensated_data(double& uncomp_xa, double& uncomp_ya, doubl
 
 bool MPU6050::get_data(double& xa, double& ya, double& za, double& xg, double& yg, double& zg)
 {
-  double uncomp_xa, uncomp_ya, uncomp_za, uncomp_xg, uncomp_yg, uncomp_zg;
-  const bool success = get_uncompensated_data(uncomp_xa, uncomp_ya, uncomp_za, uncomp_xg, uncomp_yg, uncomp_zg);
-  if (!success)
+  int16_t raw_xa, raw_ya, raw_za, raw_xg, raw_yg, raw_zg;
+  if (!get_raw_data(raw_xa, raw_ya, raw_za, raw_xg, raw_yg, raw_zg))
   {
     return false;
   }
 
-  xa = uncomp_xa + calibration_data.diff_xa;
-  ya = uncomp_ya + calibration_data.diff_ya;
-  za = uncomp_za + calibration_data.diff_za;
+  compensate(raw_xa, raw_ya, raw_za, raw_xg, raw_yg, raw_zg, xa, ya, za, xg, yg, zg);
+  return true;
+}
 
-  xg = uncomp_xg + calibration_data.diff_xg;
-  yg = uncomp_yg + calibration_data.diff_yg;
-  zg = uncomp_zg + calibration_data.diff_zg;
+void MPU6050::compensate(const int16_t raw_xa, const int16_t raw_ya, const int16_t raw_za, const int16_t raw_xg,
+                         const int16_t raw_yg, const int16_t raw_zg, double& xa, double& ya, double& za, double& xg,
+                         double& yg, double& zg) const
+{
+  xa = raw_xa * calibration_data.accel_scale + calibration_data.diff_xa;
+  ya = raw_ya * calibration_data.accel_scale + calibration_data.diff_ya;
+  za = raw_za * calibration_data.accel_scale + calibration_data.diff_za;
 
-  return true;
+  xg = raw_xg * calibration_data.gyro_scale + calibration_data.diff_xg;
+  yg = raw_yg * calibration_data.gyro_scale + calibration_data.diff_yg;
+  zg = raw_zg * calibration_data.gyro_scale + calibration_data.diff_zg;
 }
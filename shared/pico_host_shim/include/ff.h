@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "pico.h"
+
+// Host stand-in for FatFS, every drive maps onto a directory on the host (see host_fatfs_set_root) and files are
+// plain host files
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint64_t QWORD;
+typedef char TCHAR;
+
+// On the RP2040 size_t and unsigned int are the same type, and callers rely on that when passing byte counts
+typedef size_t UINT;
+
+// Built with exFAT, f_expand and fast seek enabled, like the no-OS-FatFS configuration
+#define FF_USE_EXPAND 1
+#define FF_USE_FASTSEEK 1
+#define FF_MAX_SS 512
+typedef QWORD FSIZE_t;
+typedef QWORD LBA_t;
+
+typedef enum
+{
+  FR_OK = 0,
+  FR_DISK_ERR,
+  FR_INT_ERR,
+  FR_NOT_READY,
+  FR_NO_FILE,
+  FR_NO_PATH,
+  FR_INVALID_NAME,
+  FR_DENIED,
+  FR_EXIST,
+  FR_INVALID_OBJECT,
+  FR_WRITE_PROTECTED,
+  FR_INVALID_DRIVE,
+  FR_NOT_ENABLED,
+  FR_NO_FILESYSTEM,
+  FR_MKFS_ABORTED,
+  FR_TIMEOUT,
+  FR_LOCKED,
+  FR_NOT_ENOUGH_CORE,
+  FR_TOO_MANY_OPEN_FILES,
+  FR_INVALID_PARAMETER
+} FRESULT;
+
+#define FA_READ 0x01
+#define FA_WRITE 0x02
+#define FA_OPEN_EXISTING 0x00
+#define FA_CREATE_NEW 0x04
+#define FA_CREATE_ALWAYS 0x08
+#define FA_OPEN_ALWAYS 0x10
+#define FA_OPEN_APPEND 0x30
+
+// Passed to f_lseek() with FIL::cltbl set to fill it with the file's fragments
+#define CREATE_LINKMAP ((FSIZE_t) 0 - 1)
+
+// Only the fields callers use. Files are given clusters on a simulated card when their link map is created, see
+// sd_card.h.
+typedef struct
+{
+  bool is_mounted;
+  WORD csize;
+  LBA_t database;
+} FATFS;
+
+typedef struct
+{
+  FATFS* fs;
+  DWORD sclust;
+} FFOBJID;
+
+typedef struct
+{
+  FFOBJID obj;
+  FILE* host_file;
+  BYTE flag;
+  FSIZE_t fptr;
+  FSIZE_t obj_size;
+  DWORD* cltbl;
+  char host_path[1024];
+} FIL;
+
+typedef struct
+{
+  FSIZE_t fsize;
+  BYTE fattrib;
+  TCHAR fname[256];
+} FILINFO;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void host_fatfs_set_root(const char* root_dir);
+const char* host_fatfs_get_root(void);
+
+FRESULT f_mount(FATFS* fs, const TCHAR* path, BYTE opt);
+FRESULT f_open(FIL* fp, const TCHAR* path, BYTE mode);
+FRESULT f_close(FIL* fp);
+FRESULT f_read(FIL* fp, void* buff, UINT btr, UINT* br);
+FRESULT f_write(FIL* fp, const void* buff, UINT btw, UINT* bw);
+FRESULT f_lseek(FIL* fp, FSIZE_t ofs);
+FRESULT f_truncate(FIL* fp);
+FRESULT f_sync(FIL* fp);
+FRESULT f_expand(FIL* fp, FSIZE_t fsz, BYTE opt);
+FRESULT f_stat(const TCHAR* path, FILINFO* fno);
+FRESULT f_unlink(const TCHAR* path);
+FRESULT f_rename(const TCHAR* path_old, const TCHAR* path_new);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define f_unmount(path) f_mount(0, path, 0)
+#define f_size(fp) ((fp)->obj_size)
+#define f_tell(fp) ((fp)->fptr)
+#define f_eof(fp) ((int) ((fp)->fptr == (fp)->obj_size))
+#define f_rewind(fp) f_lseek((fp), 0)
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "pico.h"
+
+#define NUM_ADC_CHANNELS 5
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Conversions return whatever was last injected for the selected input
+void host_adc_set_value(uint input, uint16_t value);
+
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+uint adc_get_selected_input(void);
+uint16_t adc_read(void);
+void adc_set_temp_sensor_enabled(bool enable);
+
+#ifdef __cplusplus
+}
+#endif
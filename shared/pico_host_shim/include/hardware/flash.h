@@ -0,0 +1,22 @@
+#pragma once
+
+#include "pico.h"
+#include "hardware/regs/addressmap.h"
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define FLASH_BLOCK_SIZE (1u << 16)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The flash image lives in RAM, optionally loaded from and written back to a file on every erase/program
+bool host_flash_set_backing_file(const char* path);
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "pico.h"
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+enum gpio_function
+{
+  GPIO_FUNC_XIP = 0,
+  GPIO_FUNC_SPI = 1,
+  GPIO_FUNC_UART = 2,
+  GPIO_FUNC_I2C = 3,
+  GPIO_FUNC_PWM = 4,
+  GPIO_FUNC_SIO = 5,
+  GPIO_FUNC_PIO0 = 6,
+  GPIO_FUNC_PIO1 = 7,
+  GPIO_FUNC_GPCK = 8,
+  GPIO_FUNC_USB = 9,
+  GPIO_FUNC_NULL = 0x1f
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Output levels are remembered so they can be inspected, nothing else has any effect
+void gpio_init(uint gpio);
+void gpio_deinit(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_pull_up(uint gpio);
+void gpio_pull_down(uint gpio);
+void gpio_disable_pulls(uint gpio);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+
+#ifdef __cplusplus
+}
+#endif
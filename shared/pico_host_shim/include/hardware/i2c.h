@@ -0,0 +1,33 @@
+#pragma once
+
+#include "pico.h"
+
+typedef struct i2c_inst
+{
+  uint index;
+} i2c_inst_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern i2c_inst_t host_i2c0_inst, host_i2c1_inst;
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate);
+void i2c_deinit(i2c_inst_t* i2c);
+
+// Transfers go to the HostI2CDevice attached at the address (see host_i2c_device.h), without one every transfer fails,
+// as if the bus had nothing on it
+int i2c_write_blocking_until(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop,
+                             absolute_time_t until);
+int i2c_read_blocking_until(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop,
+                            absolute_time_t until);
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define i2c0 (&host_i2c0_inst)
+#define i2c1 (&host_i2c1_inst)
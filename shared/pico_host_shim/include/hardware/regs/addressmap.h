@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint8_t host_flash_image[PICO_FLASH_SIZE_BYTES];
+
+#ifdef __cplusplus
+}
+#endif
+
+// Reads through XIP become reads of the flash image
+#define XIP_BASE ((uintptr_t) host_flash_image)
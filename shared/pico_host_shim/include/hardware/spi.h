@@ -0,0 +1,30 @@
+#pragma once
+
+#include "pico.h"
+
+typedef struct spi_inst
+{
+  uint index;
+} spi_inst_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern spi_inst_t host_spi0_inst, host_spi1_inst;
+
+uint spi_init(spi_inst_t* spi, uint baudrate);
+void spi_deinit(spi_inst_t* spi);
+void spi_set_slave(spi_inst_t* spi, bool slave);
+
+// Without a device attached writes go nowhere and reads return the repeated tx byte
+int spi_write_blocking(spi_inst_t* spi, const uint8_t* src, size_t len);
+int spi_read_blocking(spi_inst_t* spi, uint8_t repeated_tx_data, uint8_t* dst, size_t len);
+int spi_write_read_blocking(spi_inst_t* spi, const uint8_t* src, uint8_t* dst, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define spi0 (&host_spi0_inst)
+#define spi1 (&host_spi1_inst)
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pico/types.h"
+
+// There are no interrupts on the host, and the hardware spin locks are plain atomic flags
+
+typedef volatile uint32_t spin_lock_t;
+
+#define NUM_SPIN_LOCKS 32u
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+spin_lock_t* spin_lock_instance(uint lock_num);
+uint spin_lock_get_num(spin_lock_t* lock);
+void spin_lock_claim(uint lock_num);
+int spin_lock_claim_unused(bool required);
+uint next_striped_spin_lock_num(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline void __dmb(void)
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __mem_fence_acquire(void)
+{
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+static inline void __mem_fence_release(void)
+{
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void __sev(void)
+{
+}
+
+static inline void __wfe(void)
+{
+  sched_yield();
+}
+
+static inline void __nop(void)
+{
+}
+
+static inline void tight_loop_contents(void)
+{
+}
+
+static inline uint32_t save_and_disable_interrupts(void)
+{
+  return 0;
+}
+
+static inline void restore_interrupts(const uint32_t status)
+{
+  (void) status;
+}
+
+static inline void restore_interrupts_from_disabled(const uint32_t status)
+{
+  (void) status;
+}
+
+static inline void spin_lock_unsafe_blocking(spin_lock_t* lock)
+{
+  while (__atomic_exchange_n(lock, 1u, __ATOMIC_ACQUIRE))
+  {
+    sched_yield();
+  }
+}
+
+static inline void spin_unlock_unsafe(spin_lock_t* lock)
+{
+  __atomic_store_n(lock, 0u, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t spin_lock_blocking(spin_lock_t* lock)
+{
+  spin_lock_unsafe_blocking(lock);
+  return save_and_disable_interrupts();
+}
+
+static inline void spin_unlock(spin_lock_t* lock, const uint32_t saved_irq)
+{
+  spin_unlock_unsafe(lock);
+  restore_interrupts(saved_irq);
+}
+
+static inline spin_lock_t* spin_lock_init(const uint lock_num)
+{
+  spin_lock_t* lock = spin_lock_instance(lock_num);
+  spin_unlock_unsafe(lock);
+  return lock;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "pico.h"
+
+static inline void watchdog_enable(const uint32_t delay_ms, const bool pause_on_debug)
+{
+  (void) delay_ms;
+  (void) pause_on_debug;
+}
+
+static inline void watchdog_disable(void)
+{
+}
+
+static inline void watchdog_update(void)
+{
+}
+
+static inline bool watchdog_caused_reboot(void)
+{
+  return false;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "hardware/i2c.h"
+
+/**
+ * Something that answers on a host I2C bus in place of a real chip.
+ *
+ * Each call is one transfer to the device's address, and returns the number of bytes transferred, or a PICO_ERROR_*
+ * code just like the SDK would (PICO_ERROR_GENERIC for a NAK, PICO_ERROR_TIMEOUT for a hung bus). nostop is true when
+ * the transfer is followed by a repeated start instead of a stop.
+ */
+class HostI2CDevice
+{
+public:
+  virtual ~HostI2CDevice() = default;
+
+  virtual int write(const uint8_t* src, size_t len, bool nostop) = 0;
+  virtual int read(uint8_t* dst, size_t len, bool nostop) = 0;
+};
+
+// Attached devices are not owned by the bus, and must be detached before they're destroyed
+void host_i2c_attach(i2c_inst_t* i2c, uint8_t addr, HostI2CDevice* device);
+void host_i2c_detach(i2c_inst_t* i2c, uint8_t addr);
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "sd_card.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Provided by the application on the device (sd_hw_config.c), the host has the one simulated card
+size_t sd_get_num(void);
+sd_card_t* sd_get_by_num(size_t num);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+// Host stand-in for the Pico SDK's base header, only what the shared libraries actually use is provided
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pico/types.h"
+#include "pico/error.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+// Like the SDK, prints the message and stops. Checks that have to hold in Release builds too use this, not assert.
+void __attribute__((noreturn)) panic(const char* fmt, ...);
+
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <pthread.h>
+
+#include "pico.h"
+
+typedef struct
+{
+  pthread_mutex_t mtx;
+} critical_section_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void critical_section_init(critical_section_t* crit_sec);
+void critical_section_init_with_lock_num(critical_section_t* crit_sec, uint lock_num);
+void critical_section_enter_blocking(critical_section_t* crit_sec);
+void critical_section_exit(critical_section_t* crit_sec);
+void critical_section_deinit(critical_section_t* crit_sec);
+
+#ifdef __cplusplus
+}
+#endif
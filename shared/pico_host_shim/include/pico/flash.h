@@ -0,0 +1,16 @@
+#pragma once
+
+#include "pico.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Nothing else can be executing from flash on the host, so the function is just called
+int flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms);
+bool flash_safe_execute_core_init(void);
+bool flash_safe_execute_core_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "pico.h"
+
+typedef struct lock_core
+{
+  spin_lock_t* spin_lock;
+} lock_core_t;
+
+static inline void lock_init(lock_core_t* core, const uint lock_num)
+{
+  core->spin_lock = spin_lock_instance(lock_num);
+}
+
+// No wait-for-event on the host, give the other thread a chance to run instead
+#define lock_internal_spin_unlock_with_wait(lock, save) (spin_unlock((lock)->spin_lock, save), sched_yield())
+#define lock_internal_spin_unlock_with_notify(lock, save) spin_unlock((lock)->spin_lock, save)
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <pthread.h>
+
+#include "pico.h"
+#include "pico/lock_core.h"
+
+// Backed by pthreads (what std::mutex uses on Linux) so the header stays usable from C
+
+typedef struct
+{
+  pthread_mutex_t mtx;
+} mutex_t;
+
+typedef struct
+{
+  pthread_mutex_t mtx;
+} recursive_mutex_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void mutex_init(mutex_t* mtx);
+void mutex_enter_blocking(mutex_t* mtx);
+bool mutex_try_enter(mutex_t* mtx, uint32_t* owner_out);
+void mutex_exit(mutex_t* mtx);
+
+void recursive_mutex_init(recursive_mutex_t* mtx);
+void recursive_mutex_enter_blocking(recursive_mutex_t* mtx);
+bool recursive_mutex_try_enter(recursive_mutex_t* mtx, uint32_t* owner_out);
+void recursive_mutex_exit(recursive_mutex_t* mtx);
+
+#ifdef __cplusplus
+}
+#endif
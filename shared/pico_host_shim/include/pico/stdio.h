@@ -0,0 +1,21 @@
+#pragma once
+
+#include "pico.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// USB CDC is replaced with a pair of file descriptors (usually a pipe or a pty), the device counts as "connected"
+// once an output descriptor is set
+void host_stdio_set_fds(int in_fd, int out_fd);
+
+bool stdio_init_all(void);
+void stdio_flush(void);
+int stdio_put_string(const char* s, int len, bool newline, bool cr_translation);
+int stdio_get_until(char* buf, int len, absolute_time_t until);
+int stdio_getchar_timeout_us(uint32_t timeout_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The clock is either the real monotonic clock, or a manual clock that only moves when told to (sleeps advance it
+// instantly), which lets replays and tests run faster than real time
+void host_time_set_manual(bool manual);
+void host_time_set_us(uint64_t us_since_boot);
+void host_time_advance_us(uint64_t us);
+
+uint64_t time_us_64(void);
+absolute_time_t get_absolute_time(void);
+
+void sleep_until(absolute_time_t target);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us(uint64_t delay_us);
+void busy_wait_us_32(uint32_t delay_us);
+void busy_wait_ms(uint32_t delay_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline uint32_t time_us_32(void)
+{
+  return (uint32_t) time_us_64();
+}
+
+static inline uint32_t to_ms_since_boot(const absolute_time_t t)
+{
+  return (uint32_t) (to_us_since_boot(t) / 1000);
+}
+
+static inline absolute_time_t delayed_by_us(const absolute_time_t t, const uint64_t us)
+{
+  return t + us;
+}
+
+static inline absolute_time_t delayed_by_ms(const absolute_time_t t, const uint32_t ms)
+{
+  return t + (uint64_t) ms * 1000;
+}
+
+static inline absolute_time_t make_timeout_time_us(const uint64_t us)
+{
+  return delayed_by_us(get_absolute_time(), us);
+}
+
+static inline absolute_time_t make_timeout_time_ms(const uint32_t ms)
+{
+  return delayed_by_ms(get_absolute_time(), ms);
+}
+
+static inline int64_t absolute_time_diff_us(const absolute_time_t from, const absolute_time_t to)
+{
+  return (int64_t) (to - from);
+}
+
+static inline bool time_reached(const absolute_time_t t)
+{
+  return get_absolute_time() >= t;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef unsigned int uint;
+
+// Same as the SDK when PICO_OPAQUE_ABSOLUTE_TIME_T is off
+typedef uint64_t absolute_time_t;
+
+#define nil_time ((absolute_time_t) 0)
+#define at_the_end_of_time ((absolute_time_t) INT64_MAX)
+
+static inline uint64_t to_us_since_boot(const absolute_time_t t)
+{
+  return t;
+}
+
+static inline void update_us_since_boot(absolute_time_t* t, const uint64_t us_since_boot)
+{
+  *t = us_since_boot;
+}
+
+static inline absolute_time_t from_us_since_boot(const uint64_t us_since_boot)
+{
+  return us_since_boot;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+  SD_BLOCK_DEVICE_ERROR_NONE = 0,
+  SD_BLOCK_DEVICE_ERROR_PARAMETER = 1 << 2,
+  SD_BLOCK_DEVICE_ERROR_NO_DEVICE = 1 << 4,
+  SD_BLOCK_DEVICE_ERROR_WRITE = 1 << 10
+} block_dev_err_t;
+
+typedef struct sd_card_t sd_card_t;
+
+// Blocks are mapped back onto the host files that were given them by f_lseek(CREATE_LINKMAP), so raw block writes
+// land in the same files FatFS reads
+struct sd_card_t
+{
+  block_dev_err_t (*write_blocks)(sd_card_t* sd_card_p, const uint8_t* buffer, uint64_t ulSectorNumber,
+                                  uint32_t blockCnt);
+  block_dev_err_t (*read_blocks)(sd_card_t* sd_card_p, uint8_t* buffer, uint64_t ulSectorNumber, uint32_t ulSectorCount);
+  block_dev_err_t (*sync)(sd_card_t* sd_card_p);
+};
+
+// The card is always there on the host
+bool sd_init_driver(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,434 @@
+#include "ff.h"
+#include "hw_config.h"
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Geometry of the simulated card raw block writes go to, 32 KB clusters like a freshly formatted SDXC card
+#define HOST_CLUSTER_SECTORS 64
+#define HOST_DATA_START_SECTOR 0x2000
+
+namespace
+{
+  std::string fatfs_root = ".";
+  FATFS* mounted_fs = nullptr;
+
+  // Every file that's had its link map created is one contiguous run of clusters on the simulated card
+  struct HostExtent
+  {
+    std::string host_path;
+    DWORD cluster_count;
+  };
+
+  std::mutex extents_mtx;
+  std::map<DWORD, HostExtent> extents_by_cluster;
+  std::map<std::pair<dev_t, ino_t>, DWORD> extents_by_file;
+  DWORD next_free_cluster = 2;
+
+  FRESULT from_errno();
+
+  std::string to_host_path(const TCHAR* path)
+  {
+    std::string fat_path(path);
+
+    // Drive numbers ("0:") all map onto the same root
+    const size_t drive_sep = fat_path.find(':');
+    if (drive_sep != std::string::npos)
+    {
+      fat_path = fat_path.substr(drive_sep + 1);
+    }
+
+    while (!fat_path.empty() && fat_path.front() == '/')
+    {
+      fat_path.erase(0, 1);
+    }
+
+    return fatfs_root + "/" + fat_path;
+  }
+
+  bool host_file_exists(const std::string& host_path)
+  {
+    struct stat host_stat{};
+    return stat(host_path.c_str(), &host_stat) == 0 && S_ISREG(host_stat.st_mode);
+  }
+
+  block_dev_err_t host_write_blocks(sd_card_t*, const uint8_t* buffer, const uint64_t sector, const uint32_t count)
+  {
+    if (sector < HOST_DATA_START_SECTOR)
+    {
+      return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    }
+
+    const std::lock_guard lock(extents_mtx);
+    const auto cluster = static_cast<DWORD>((sector - HOST_DATA_START_SECTOR) / HOST_CLUSTER_SECTORS + 2);
+    auto extent_it = extents_by_cluster.upper_bound(cluster);
+    if (extent_it == extents_by_cluster.begin())
+    {
+      return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    }
+    --extent_it;
+
+    const uint64_t extent_sector = HOST_DATA_START_SECTOR + static_cast<uint64_t>(extent_it->first - 2) *
+      HOST_CLUSTER_SECTORS;
+    const uint64_t offset = (sector - extent_sector) * FF_MAX_SS;
+    const uint64_t len = static_cast<uint64_t>(count) * FF_MAX_SS;
+    if (offset + len > static_cast<uint64_t>(extent_it->second.cluster_count) * HOST_CLUSTER_SECTORS * FF_MAX_SS)
+    {
+      return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    }
+
+    FILE* host_file = fopen(extent_it->second.host_path.c_str(), "r+b");
+    if (!host_file)
+    {
+      return SD_BLOCK_DEVICE_ERROR_NO_DEVICE;
+    }
+
+    const bool did_write = fseeko(host_file, static_cast<off_t>(offset), SEEK_SET) == 0 &&
+      fwrite(buffer, 1, len, host_file) == len;
+    fclose(host_file);
+    return did_write ? SD_BLOCK_DEVICE_ERROR_NONE : SD_BLOCK_DEVICE_ERROR_WRITE;
+  }
+
+  block_dev_err_t host_read_blocks(sd_card_t*, uint8_t*, uint64_t, uint32_t)
+  {
+    // Nothing reads the card without FatFS yet
+    return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+  }
+
+  block_dev_err_t host_sync(sd_card_t*)
+  {
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+  }
+
+  sd_card_t host_sd_card = {host_write_blocks, host_read_blocks, host_sync};
+
+  FRESULT create_link_map(FIL* fp)
+  {
+    if (!fp->cltbl || !fp->obj.fs)
+    {
+      return FR_INVALID_PARAMETER;
+    }
+
+    fflush(fp->host_file);
+    struct stat host_stat{};
+    if (fstat(fileno(fp->host_file), &host_stat) != 0)
+    {
+      return from_errno();
+    }
+
+    constexpr FSIZE_t cluster_size = HOST_CLUSTER_SECTORS * FF_MAX_SS;
+    const auto cluster_count = static_cast<DWORD>((fp->obj_size + cluster_size - 1) / cluster_size);
+    if (cluster_count == 0)
+    {
+      fp->cltbl[0] = 1;
+      fp->cltbl[1] = 0;
+      return FR_OK;
+    }
+
+    if (fp->cltbl[0] < 4)
+    {
+      fp->cltbl[0] = 4;
+      return FR_NOT_ENOUGH_CORE;
+    }
+
+    // A file that's grown past its clusters is moved to new ones, like it had been copied somewhere contiguous
+    const std::lock_guard lock(extents_mtx);
+    const std::pair file_key(host_stat.st_dev, host_stat.st_ino);
+    auto file_it = extents_by_file.find(file_key);
+    if (file_it != extents_by_file.end() && extents_by_cluster[file_it->second].cluster_count < cluster_count)
+    {
+      extents_by_cluster.erase(file_it->second);
+      extents_by_file.erase(file_it);
+      file_it = extents_by_file.end();
+    }
+
+    if (file_it == extents_by_file.end())
+    {
+      file_it = extents_by_file.emplace(file_key, next_free_cluster).first;
+      extents_by_cluster[next_free_cluster] = {fp->host_path, cluster_count};
+      next_free_cluster += cluster_count;
+    }
+
+    fp->obj.sclust = file_it->second;
+    fp->cltbl[0] = 4;
+    fp->cltbl[1] = cluster_count;
+    fp->cltbl[2] = file_it->second;
+    fp->cltbl[3] = 0;
+    return FR_OK;
+  }
+
+  FRESULT from_errno()
+  {
+    switch (errno)
+    {
+    case ENOENT:
+      return FR_NO_FILE;
+    case ENOTDIR:
+      return FR_NO_PATH;
+    case EACCES:
+    case EPERM:
+      return FR_DENIED;
+    case EEXIST:
+      return FR_EXIST;
+    case EROFS:
+      return FR_WRITE_PROTECTED;
+    case ENOMEM:
+      return FR_NOT_ENOUGH_CORE;
+    case EMFILE:
+    case ENFILE:
+      return FR_TOO_MANY_OPEN_FILES;
+    default:
+      return FR_DISK_ERR;
+    }
+  }
+}
+
+void host_fatfs_set_root(const char* root_dir)
+{
+  fatfs_root = root_dir;
+}
+
+const char* host_fatfs_get_root()
+{
+  return fatfs_root.c_str();
+}
+
+bool sd_init_driver()
+{
+  return true;
+}
+
+size_t sd_get_num()
+{
+  return 1;
+}
+
+sd_card_t* sd_get_by_num(const size_t num)
+{
+  return num == 0 ? &host_sd_card : nullptr;
+}
+
+FRESULT f_mount(FATFS* fs, const TCHAR*, BYTE)
+{
+  if (fs)
+  {
+    fs->is_mounted = true;
+    fs->csize = HOST_CLUSTER_SECTORS;
+    fs->database = HOST_DATA_START_SECTOR;
+  }
+  mounted_fs = fs;
+  return FR_OK;
+}
+
+FRESULT f_open(FIL* fp, const TCHAR* path, const BYTE mode)
+{
+  const std::string host_path = to_host_path(path);
+  const bool exists = host_file_exists(host_path);
+
+  fp->host_file = nullptr;
+  fp->flag = mode;
+  fp->fptr = 0;
+  fp->obj_size = 0;
+  fp->obj = {mounted_fs, 0};
+  fp->cltbl = nullptr;
+  snprintf(fp->host_path, sizeof(fp->host_path), "%s", host_path.c_str());
+
+  const BYTE create_mode = mode & (FA_CREATE_NEW | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS);
+  if (create_mode == FA_CREATE_NEW && exists)
+  {
+    return FR_EXIST;
+  }
+
+  if (!exists && create_mode == 0)
+  {
+    return FR_NO_FILE;
+  }
+
+  const bool truncate = create_mode == FA_CREATE_ALWAYS || create_mode == FA_CREATE_NEW || !exists;
+  fp->host_file = fopen(host_path.c_str(), truncate ? "w+b" : "r+b");
+  if (!fp->host_file)
+  {
+    return from_errno();
+  }
+
+  fseeko(fp->host_file, 0, SEEK_END);
+  fp->obj_size = ftello(fp->host_file);
+  fseeko(fp->host_file, 0, SEEK_SET);
+
+  if ((mode & FA_OPEN_APPEND) == FA_OPEN_APPEND)
+  {
+    return f_lseek(fp, fp->obj_size);
+  }
+
+  return FR_OK;
+}
+
+FRESULT f_close(FIL* fp)
+{
+  if (!fp->host_file)
+  {
+    return FR_INVALID_OBJECT;
+  }
+
+  const int result = fclose(fp->host_file);
+  fp->host_file = nullptr;
+  return result == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_read(FIL* fp, void* buff, const UINT btr, UINT* br)
+{
+  *br = 0;
+  if (!fp->host_file)
+  {
+    return FR_INVALID_OBJECT;
+  }
+
+  if (!(fp->flag & FA_READ))
+  {
+    return FR_DENIED;
+  }
+
+  fseeko(fp->host_file, static_cast<off_t>(fp->fptr), SEEK_SET);
+  *br = fread(buff, 1, btr, fp->host_file);
+  fp->fptr += *br;
+  return ferror(fp->host_file) ? FR_DISK_ERR : FR_OK;
+}
+
+FRESULT f_write(FIL* fp, const void* buff, const UINT btw, UINT* bw)
+{
+  *bw = 0;
+  if (!fp->host_file)
+  {
+    return FR_INVALID_OBJECT;
+  }
+
+  if (!(fp->flag & FA_WRITE))
+  {
+    return FR_DENIED;
+  }
+
+  fseeko(fp->host_file, static_cast<off_t>(fp->fptr), SEEK_SET);
+  *bw = fwrite(buff, 1, btw, fp->host_file);
+  fp->fptr += *bw;
+  if (fp->fptr > fp->obj_size)
+  {
+    fp->obj_size = fp->fptr;
+  }
+  return *bw == btw ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_lseek(FIL* fp, const FSIZE_t ofs)
+{
+  if (!fp->host_file)
+  {
+    return FR_INVALID_OBJECT;
+  }
+
+  if (ofs == CREATE_LINKMAP)
+  {
+    return create_link_map(fp);
+  }
+
+  // Like FatFS, seeking past the end of a writable file extends it
+  if (ofs > fp->obj_size)
+  {
+    if (!(fp->flag & FA_WRITE))
+    {
+      fp->fptr = fp->obj_size;
+      return FR_OK;
+    }
+
+    fflush(fp->host_file);
+    if (ftruncate(fileno(fp->host_file), static_cast<off_t>(ofs)) != 0)
+    {
+      return from_errno();
+    }
+    fp->obj_size = ofs;
+  }
+
+  fp->fptr = ofs;
+  return FR_OK;
+}
+
+FRESULT f_truncate(FIL* fp)
+{
+  if (!fp->host_file)
+  {
+    return FR_INVALID_OBJECT;
+  }
+
+  fflush(fp->host_file);
+  if (ftruncate(fileno(fp->host_file), static_cast<off_t>(fp->fptr)) != 0)
+  {
+    return from_errno();
+  }
+  fp->obj_size = fp->fptr;
+  return FR_OK;
+}
+
+FRESULT f_sync(FIL* fp)
+{
+  if (!fp->host_file)
+  {
+    return FR_INVALID_OBJECT;
+  }
+
+  return fflush(fp->host_file) == 0 ? FR_OK : FR_DISK_ERR;
+}
+
+FRESULT f_expand(FIL* fp, const FSIZE_t fsz, BYTE)
+{
+  if (!fp->host_file)
+  {
+    return FR_INVALID_OBJECT;
+  }
+
+  // FatFS only allows expanding empty files
+  if (fp->obj_size != 0 || !(fp->flag & FA_WRITE))
+  {
+    return FR_DENIED;
+  }
+
+  fflush(fp->host_file);
+  if (ftruncate(fileno(fp->host_file), static_cast<off_t>(fsz)) != 0)
+  {
+    return from_errno();
+  }
+  fp->obj_size = fsz;
+  return FR_OK;
+}
+
+FRESULT f_stat(const TCHAR* path, FILINFO* fno)
+{
+  const std::string host_path = to_host_path(path);
+
+  struct stat host_stat{};
+  if (stat(host_path.c_str(), &host_stat) != 0)
+  {
+    return from_errno();
+  }
+
+  if (fno)
+  {
+    fno->fsize = host_stat.st_size;
+    fno->fattrib = 0;
+    snprintf(fno->fname, sizeof(fno->fname), "%s", path);
+  }
+  return FR_OK;
+}
+
+FRESULT f_unlink(const TCHAR* path)
+{
+  return remove(to_host_path(path).c_str()) == 0 ? FR_OK : from_errno();
+}
+
+FRESULT f_rename(const TCHAR* path_old, const TCHAR* path_new)
+{
+  return rename(to_host_path(path_old).c_str(), to_host_path(path_new).c_str()) == 0 ? FR_OK : from_errno();
+}
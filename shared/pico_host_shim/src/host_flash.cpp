@@ -0,0 +1,92 @@
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+uint8_t host_flash_image[PICO_FLASH_SIZE_BYTES];
+
+namespace
+{
+  std::string backing_file_path;
+
+  // Erased flash reads back as all ones
+  [[maybe_unused]] const bool did_erase_image = []
+  {
+    memset(host_flash_image, 0xFF, sizeof(host_flash_image));
+    return true;
+  }();
+
+  void write_back()
+  {
+    if (backing_file_path.empty())
+    {
+      return;
+    }
+
+    FILE* backing_file = fopen(backing_file_path.c_str(), "wb");
+    if (!backing_file)
+    {
+      return;
+    }
+
+    fwrite(host_flash_image, 1, sizeof(host_flash_image), backing_file);
+    fclose(backing_file);
+  }
+}
+
+bool host_flash_set_backing_file(const char* path)
+{
+  backing_file_path = path;
+
+  FILE* backing_file = fopen(path, "rb");
+  if (!backing_file)
+  {
+    return false;
+  }
+
+  const size_t bytes_read = fread(host_flash_image, 1, sizeof(host_flash_image), backing_file);
+  fclose(backing_file);
+  return bytes_read == sizeof(host_flash_image);
+}
+
+void flash_range_erase(const uint32_t flash_offs, const size_t count)
+{
+  assert(flash_offs % FLASH_SECTOR_SIZE == 0);
+  assert(flash_offs + count <= sizeof(host_flash_image));
+
+  // Real flash erases whole sectors
+  const size_t erase_count = (count + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+  memset(host_flash_image + flash_offs, 0xFF, erase_count);
+  write_back();
+}
+
+void flash_range_program(const uint32_t flash_offs, const uint8_t* data, const size_t count)
+{
+  assert(flash_offs % FLASH_PAGE_SIZE == 0);
+  assert(flash_offs + count <= sizeof(host_flash_image));
+
+  // Programming can only clear bits
+  for (size_t i = 0; i < count; i++)
+  {
+    host_flash_image[flash_offs + i] &= data[i];
+  }
+  write_back();
+}
+
+int flash_safe_execute(void (*func)(void*), void* param, uint32_t)
+{
+  func(param);
+  return PICO_OK;
+}
+
+bool flash_safe_execute_core_init()
+{
+  return true;
+}
+
+bool flash_safe_execute_core_deinit()
+{
+  return true;
+}
@@ -0,0 +1,188 @@
+#include <array>
+#include <atomic>
+
+#include "hardware/adc.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "host_i2c_device.h"
+
+i2c_inst_t host_i2c0_inst{0}, host_i2c1_inst{1};
+spi_inst_t host_spi0_inst{0}, host_spi1_inst{1};
+
+namespace
+{
+  constexpr uint gpio_count = 30;
+
+  std::array<std::atomic<bool>, gpio_count> gpio_levels{};
+
+  std::array<std::atomic<uint16_t>, NUM_ADC_CHANNELS> adc_values{};
+  std::atomic<uint> selected_adc_input = 0;
+
+  constexpr uint i2c_addr_count = 1 << 7;
+
+  std::array<std::array<std::atomic<HostI2CDevice*>, i2c_addr_count>, 2> i2c_devices{};
+
+  HostI2CDevice* get_i2c_device(const i2c_inst_t* i2c, const uint8_t addr)
+  {
+    assert(i2c->index < i2c_devices.size());
+    return addr < i2c_addr_count ? i2c_devices[i2c->index][addr].load() : nullptr;
+  }
+}
+
+void gpio_init(const uint gpio)
+{
+  assert(gpio < gpio_count);
+  gpio_levels[gpio] = false;
+}
+
+void gpio_deinit(const uint gpio)
+{
+  gpio_init(gpio);
+}
+
+void gpio_set_dir(uint, bool)
+{
+}
+
+void gpio_set_function(uint, gpio_function)
+{
+}
+
+void gpio_pull_up(uint)
+{
+}
+
+void gpio_pull_down(uint)
+{
+}
+
+void gpio_disable_pulls(uint)
+{
+}
+
+void gpio_put(const uint gpio, const bool value)
+{
+  assert(gpio < gpio_count);
+  gpio_levels[gpio] = value;
+}
+
+bool gpio_get(const uint gpio)
+{
+  assert(gpio < gpio_count);
+  return gpio_levels[gpio];
+}
+
+void host_adc_set_value(const uint input, const uint16_t value)
+{
+  assert(input < NUM_ADC_CHANNELS);
+  adc_values[input] = value & 0xFFF;
+}
+
+void adc_init()
+{
+}
+
+void adc_gpio_init(uint)
+{
+}
+
+void adc_select_input(const uint input)
+{
+  assert(input < NUM_ADC_CHANNELS);
+  selected_adc_input = input;
+}
+
+uint adc_get_selected_input()
+{
+  return selected_adc_input;
+}
+
+uint16_t adc_read()
+{
+  return adc_values[selected_adc_input];
+}
+
+void adc_set_temp_sensor_enabled(bool)
+{
+}
+
+uint i2c_init(i2c_inst_t*, const uint baudrate)
+{
+  return baudrate;
+}
+
+void i2c_deinit(i2c_inst_t*)
+{
+}
+
+void host_i2c_attach(i2c_inst_t* i2c, const uint8_t addr, HostI2CDevice* device)
+{
+  assert(i2c->index < i2c_devices.size() && addr < i2c_addr_count);
+  i2c_devices[i2c->index][addr] = device;
+}
+
+void host_i2c_detach(i2c_inst_t* i2c, const uint8_t addr)
+{
+  host_i2c_attach(i2c, addr, nullptr);
+}
+
+int i2c_write_blocking_until(i2c_inst_t* i2c, const uint8_t addr, const uint8_t* src, const size_t len,
+                             const bool nostop, absolute_time_t)
+{
+  HostI2CDevice* device = get_i2c_device(i2c, addr);
+  return device ? device->write(src, len, nostop) : PICO_ERROR_GENERIC;
+}
+
+int i2c_read_blocking_until(i2c_inst_t* i2c, const uint8_t addr, uint8_t* dst, const size_t len, const bool nostop,
+                            absolute_time_t)
+{
+  HostI2CDevice* device = get_i2c_device(i2c, addr);
+  return device ? device->read(dst, len, nostop) : PICO_ERROR_GENERIC;
+}
+
+int i2c_write_blocking(i2c_inst_t* i2c, const uint8_t addr, const uint8_t* src, const size_t len, const bool nostop)
+{
+  return i2c_write_blocking_until(i2c, addr, src, len, nostop, at_the_end_of_time);
+}
+
+int i2c_read_blocking(i2c_inst_t* i2c, const uint8_t addr, uint8_t* dst, const size_t len, const bool nostop)
+{
+  return i2c_read_blocking_until(i2c, addr, dst, len, nostop, at_the_end_of_time);
+}
+
+uint spi_init(spi_inst_t*, const uint baudrate)
+{
+  return baudrate;
+}
+
+void spi_deinit(spi_inst_t*)
+{
+}
+
+void spi_set_slave(spi_inst_t*, bool)
+{
+}
+
+int spi_write_blocking(spi_inst_t*, const uint8_t*, const size_t len)
+{
+  return static_cast<int>(len);
+}
+
+int spi_read_blocking(spi_inst_t*, const uint8_t repeated_tx_data, uint8_t* dst, const size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    dst[i] = repeated_tx_data;
+  }
+  return static_cast<int>(len);
+}
+
+int spi_write_read_blocking(spi_inst_t*, const uint8_t* src, uint8_t* dst, const size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    dst[i] = src[i];
+  }
+  return static_cast<int>(len);
+}
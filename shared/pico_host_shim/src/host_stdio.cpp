@@ -0,0 +1,110 @@
+#include "pico/stdio.h"
+#include "pico/stdio_usb.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <unistd.h>
+
+namespace
+{
+  std::atomic<int> stdio_in_fd = -1;
+  std::atomic<int> stdio_out_fd = -1;
+}
+
+void host_stdio_set_fds(const int in_fd, const int out_fd)
+{
+  stdio_in_fd = in_fd;
+  stdio_out_fd = out_fd;
+}
+
+bool stdio_init_all()
+{
+  return true;
+}
+
+bool stdio_usb_init()
+{
+  return true;
+}
+
+bool stdio_usb_connected()
+{
+  return stdio_out_fd >= 0;
+}
+
+void stdio_flush()
+{
+}
+
+int stdio_put_string(const char* s, const int len, bool, bool)
+{
+  const int out_fd = stdio_out_fd;
+  if (out_fd < 0)
+  {
+    return len;
+  }
+
+  int total_written = 0;
+  while (total_written < len)
+  {
+    const ssize_t written = write(out_fd, s + total_written, len - total_written);
+    if (written <= 0)
+    {
+      break;
+    }
+    total_written += static_cast<int>(written);
+  }
+
+  return total_written;
+}
+
+int stdio_get_until(char* buf, const int len, const absolute_time_t until)
+{
+  const int in_fd = stdio_in_fd;
+  if (in_fd < 0)
+  {
+    return PICO_ERROR_TIMEOUT;
+  }
+
+  int total_read = 0;
+  while (total_read < len)
+  {
+    const int64_t remaining_us = absolute_time_diff_us(get_absolute_time(), until);
+
+    pollfd poll_fd{in_fd, POLLIN, 0};
+    const int poll_result = poll(&poll_fd, 1, remaining_us > 0 ? static_cast<int>(remaining_us / 1000) : 0);
+    if (poll_result <= 0)
+    {
+      break;
+    }
+
+    const ssize_t bytes_read = read(in_fd, buf + total_read, len - total_read);
+    if (bytes_read <= 0)
+    {
+      break;
+    }
+    total_read += static_cast<int>(bytes_read);
+  }
+
+  return total_read == 0 ? PICO_ERROR_TIMEOUT : total_read;
+}
+
+int stdio_getchar_timeout_us(const uint32_t timeout_us)
+{
+  char c;
+  const int bytes_read = stdio_get_until(&c, 1, make_timeout_time_us(timeout_us));
+  return bytes_read == 1 ? static_cast<uint8_t>(c) : static_cast<int>(PICO_ERROR_TIMEOUT);
+}
+
+void panic(const char* fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+  fputc('\n', stderr);
+  abort();
+}
@@ -0,0 +1,144 @@
+#include <atomic>
+#include <random>
+
+#include "hardware/sync.h"
+#include "pico/critical_section.h"
+#include "pico/mutex.h"
+#include "pico/rand.h"
+
+namespace
+{
+  spin_lock_t spin_locks[NUM_SPIN_LOCKS];
+  std::atomic<uint32_t> claimed_spin_locks = 0;
+
+  // Same split as the SDK, the first 16 are reserved and the striped ones are handed out round-robin
+  constexpr uint first_striped_spin_lock = 16;
+  constexpr uint last_striped_spin_lock = 23;
+  constexpr uint first_claimable_spin_lock = 24;
+  std::atomic<uint> next_striped_spin_lock = first_striped_spin_lock;
+}
+
+spin_lock_t* spin_lock_instance(const uint lock_num)
+{
+  assert(lock_num < NUM_SPIN_LOCKS);
+  return &spin_locks[lock_num];
+}
+
+uint spin_lock_get_num(spin_lock_t* lock)
+{
+  return static_cast<uint>(lock - spin_locks);
+}
+
+void spin_lock_claim(const uint lock_num)
+{
+  if ((claimed_spin_locks.fetch_or(1u << lock_num) & 1u << lock_num) != 0)
+  {
+    panic("Spin lock %u already claimed", lock_num);
+  }
+}
+
+int spin_lock_claim_unused(const bool required)
+{
+  for (uint lock_num = first_claimable_spin_lock; lock_num < NUM_SPIN_LOCKS; lock_num++)
+  {
+    const uint32_t prev = claimed_spin_locks.fetch_or(1u << lock_num);
+    if ((prev & 1u << lock_num) == 0)
+    {
+      return static_cast<int>(lock_num);
+    }
+  }
+
+  if (required)
+  {
+    panic("No spin locks left to claim");
+  }
+  return -1;
+}
+
+uint next_striped_spin_lock_num()
+{
+  uint lock_num = next_striped_spin_lock.fetch_add(1);
+  lock_num = first_striped_spin_lock + (lock_num - first_striped_spin_lock) % (last_striped_spin_lock -
+    first_striped_spin_lock + 1);
+  return lock_num;
+}
+
+void mutex_init(mutex_t* mtx)
+{
+  pthread_mutex_init(&mtx->mtx, nullptr);
+}
+
+void mutex_enter_blocking(mutex_t* mtx)
+{
+  pthread_mutex_lock(&mtx->mtx);
+}
+
+bool mutex_try_enter(mutex_t* mtx, uint32_t*)
+{
+  return pthread_mutex_trylock(&mtx->mtx) == 0;
+}
+
+void mutex_exit(mutex_t* mtx)
+{
+  pthread_mutex_unlock(&mtx->mtx);
+}
+
+void recursive_mutex_init(recursive_mutex_t* mtx)
+{
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&mtx->mtx, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+void recursive_mutex_enter_blocking(recursive_mutex_t* mtx)
+{
+  pthread_mutex_lock(&mtx->mtx);
+}
+
+bool recursive_mutex_try_enter(recursive_mutex_t* mtx, uint32_t*)
+{
+  return pthread_mutex_trylock(&mtx->mtx) == 0;
+}
+
+void recursive_mutex_exit(recursive_mutex_t* mtx)
+{
+  pthread_mutex_unlock(&mtx->mtx);
+}
+
+void critical_section_init(critical_section_t* crit_sec)
+{
+  pthread_mutex_init(&crit_sec->mtx, nullptr);
+}
+
+void critical_section_init_with_lock_num(critical_section_t* crit_sec, uint)
+{
+  critical_section_init(crit_sec);
+}
+
+void critical_section_enter_blocking(critical_section_t* crit_sec)
+{
+  pthread_mutex_lock(&crit_sec->mtx);
+}
+
+void critical_section_exit(critical_section_t* crit_sec)
+{
+  pthread_mutex_unlock(&crit_sec->mtx);
+}
+
+void critical_section_deinit(critical_section_t* crit_sec)
+{
+  pthread_mutex_destroy(&crit_sec->mtx);
+}
+
+uint32_t get_rand_32()
+{
+  return static_cast<uint32_t>(get_rand_64());
+}
+
+uint64_t get_rand_64()
+{
+  thread_local std::mt19937_64 rng(std::random_device{}());
+  return rng();
+}
@@ -0,0 +1,99 @@
+#include "pico/time.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+  const std::chrono::steady_clock::time_point boot_time = std::chrono::steady_clock::now();
+
+  std::atomic<bool> is_manual_clock = false;
+  std::atomic<uint64_t> manual_us_since_boot = 0;
+}
+
+void host_time_set_manual(const bool manual)
+{
+  if (manual && !is_manual_clock)
+  {
+    manual_us_since_boot = time_us_64();
+  }
+  is_manual_clock = manual;
+}
+
+void host_time_set_us(const uint64_t us_since_boot)
+{
+  manual_us_since_boot = us_since_boot;
+}
+
+void host_time_advance_us(const uint64_t us)
+{
+  manual_us_since_boot += us;
+}
+
+uint64_t time_us_64()
+{
+  if (is_manual_clock)
+  {
+    return manual_us_since_boot;
+  }
+
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot_time).count();
+}
+
+absolute_time_t get_absolute_time()
+{
+  return from_us_since_boot(time_us_64());
+}
+
+void sleep_until(const absolute_time_t target)
+{
+  if (is_manual_clock)
+  {
+    if (to_us_since_boot(target) > manual_us_since_boot)
+    {
+      manual_us_since_boot = to_us_since_boot(target);
+    }
+    return;
+  }
+
+  const int64_t remaining_us = absolute_time_diff_us(get_absolute_time(), target);
+  if (remaining_us > 0)
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(remaining_us));
+  }
+}
+
+void sleep_us(const uint64_t us)
+{
+  sleep_until(delayed_by_us(get_absolute_time(), us));
+}
+
+void sleep_ms(const uint32_t ms)
+{
+  sleep_us(static_cast<uint64_t>(ms) * 1000);
+}
+
+void busy_wait_us(const uint64_t delay_us)
+{
+  if (is_manual_clock)
+  {
+    host_time_advance_us(delay_us);
+    return;
+  }
+
+  const absolute_time_t target = delayed_by_us(get_absolute_time(), delay_us);
+  while (!time_reached(target))
+  {
+  }
+}
+
+void busy_wait_us_32(const uint32_t delay_us)
+{
+  busy_wait_us(delay_us);
+}
+
+void busy_wait_ms(const uint32_t delay_ms)
+{
+  busy_wait_us(static_cast<uint64_t>(delay_ms) * 1000);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "bmp_280.h"
+#include "simulated_i2c_device.h"
+
+namespace sensor_sim
+{
+  struct BMP280SimSettings
+  {
+    double sea_level_pressure = 101325;
+    double sea_level_temperature = 15;
+
+    // RMS noise with 1x oversampling, more oversampling reduces it by the square root
+    double pressure_noise_pa = 2.62;
+    double temperature_noise = 0.01;
+
+    // The typical trimming values from the datasheet
+    BMP280::CalibrationData calibration = {
+      27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000
+    };
+  };
+
+  /**
+   * A BMP 280 on I2C, converting pressure and temperature from the trajectory's altitude in the standard atmosphere.
+   *
+   * Raw ADC counts are found by inverting the datasheet compensation for the configured trimming values, so the driver's
+   * compensation gets back (within noise and oversampling resolution) what was simulated. Sleep, forced and normal
+   * mode, oversampling, standby time and the IIR filter all behave like they do on the chip.
+   */
+  class BMP280Sim final : public SimulatedI2CDevice
+  {
+  public:
+    BMP280Sim(const TrajectoryProfile* profile, uint32_t seed, const BMP280SimSettings& settings = BMP280SimSettings());
+
+    static double compensate_temperature(int32_t adc_temperature, const BMP280::CalibrationData& calibration,
+                                         int32_t& t_fine);
+    static double compensate_pressure(int32_t adc_pressure, int32_t t_fine, const BMP280::CalibrationData& calibration);
+
+  protected:
+    void reset_registers() override;
+    void write_transfer(const uint8_t* src, size_t len) override;
+    [[nodiscard]] uint8_t read_register(uint8_t reg) const override;
+    [[nodiscard]] uint64_t get_sample_period_us() const override;
+    void update_data_registers(const TrajectorySample& sample) override;
+
+  private:
+    static constexpr uint8_t REG_CALIBRATION = 0x88;
+    static constexpr uint8_t CALIBRATION_SIZE = 24;
+    static constexpr uint8_t REG_CHIP_ID = 0xD0;
+    static constexpr uint8_t REG_SOFT_RESET = 0xE0;
+    static constexpr uint8_t REG_STATUS = 0xF3;
+    static constexpr uint8_t REG_CTRL_MEAS = 0xF4;
+    static constexpr uint8_t REG_CONFIG = 0xF5;
+    static constexpr uint8_t REG_PRESS_MSB = 0xF7;
+    static constexpr uint8_t DATA_SIZE = 6;
+
+    BMP280SimSettings settings;
+    uint8_t calibration_regs[CALIBRATION_SIZE]{};
+
+    uint8_t ctrl_meas = 0, config = 0;
+    double filtered_adc_pressure = 0, filtered_adc_temperature = 0;
+    bool has_filtered_value = false;
+    uint8_t data_regs[DATA_SIZE]{};
+
+    [[nodiscard]] int32_t find_adc_temperature(double temperature) const;
+    [[nodiscard]] int32_t find_adc_pressure(double pressure, int32_t t_fine) const;
+
+    static uint8_t get_oversampling(uint8_t osrs);
+    static int32_t apply_resolution(double adc, uint8_t osrs, bool is_filtered);
+  };
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "mpu_6050.h"
+#include "simulated_i2c_device.h"
+
+namespace sensor_sim
+{
+  struct MPU6050SimSettings
+  {
+    // RMS noise with the 44 Hz low pass filter the drivers use, from the noise density in the datasheet
+    double accel_noise = 0.026;
+    double gyro_noise = 0.033;
+
+    // Zero offsets, so calibration has something to remove
+    double accel_bias_x = 0.35, accel_bias_y = -0.2, accel_bias_z = 0.6;
+    double gyro_bias_x = -1.8, gyro_bias_y = 0.9, gyro_bias_z = 0.4;
+
+    double temperature = 25;
+  };
+
+  /**
+   * An MPU 6050, reading the trajectory's acceleration and rotation through the configured full scale ranges (including
+   * saturating at the top of them), sample rate, and sleep/reset bits of PWR_MGMT_1.
+   */
+  class MPU6050Sim final : public SimulatedI2CDevice
+  {
+  public:
+    MPU6050Sim(const TrajectoryProfile* profile, uint32_t seed,
+               const MPU6050SimSettings& settings = MPU6050SimSettings());
+
+  protected:
+    void reset_registers() override;
+    void write_transfer(const uint8_t* src, size_t len) override;
+    [[nodiscard]] uint8_t read_register(uint8_t reg) const override;
+    [[nodiscard]] uint64_t get_sample_period_us() const override;
+    void update_data_registers(const TrajectorySample& sample) override;
+
+  private:
+    static constexpr uint8_t REG_SELF_TEST_X = 0x0D;
+    static constexpr uint8_t REG_SMPLRT_DIV = 0x19;
+    static constexpr uint8_t REG_CONFIG = 0x1A;
+    static constexpr uint8_t REG_GYRO_CONFIG = 0x1B;
+    static constexpr uint8_t REG_ACCEL_CONFIG = 0x1C;
+    static constexpr uint8_t REG_ACCEL_XOUT = 0x3B;
+    static constexpr uint8_t REG_ACCEL_YOUT = 0x3D;
+    static constexpr uint8_t REG_ACCEL_ZOUT = 0x3F;
+    static constexpr uint8_t REG_TEMP_OUT = 0x41;
+    static constexpr uint8_t REG_GYRO_XOUT = 0x43;
+    static constexpr uint8_t REG_GYRO_YOUT = 0x45;
+    static constexpr uint8_t REG_GYRO_ZOUT = 0x47;
+    static constexpr uint8_t REG_PWR_MGMT_1 = 0x6B;
+    static constexpr uint8_t REG_WHO_AM_I = 0x75;
+
+    static constexpr uint8_t PWR_MGMT_1_RESET = 0x40;
+    static constexpr uint8_t PWR_MGMT_1_DEVICE_RESET = 0x80;
+    static constexpr uint8_t PWR_MGMT_1_SLEEP = 0x40;
+
+    static constexpr size_t REG_COUNT = 0x80;
+
+    MPU6050SimSettings settings;
+    uint8_t regs[REG_COUNT]{};
+
+    void put_data(uint8_t reg, double value, double scale);
+  };
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "host_i2c_device.h"
+#include "trajectory_profile.h"
+
+namespace sensor_sim
+{
+  struct SimulatedBusFaults
+  {
+    // Chance that any single transfer is NAKed
+    double nak_probability = 0;
+
+    // Chance that a conversion doesn't happen and the data registers keep their old value, for stuck_samples samples
+    double stuck_probability = 0;
+    uint32_t stuck_samples = 10;
+  };
+
+  struct SimulatedDeviceStats
+  {
+    uint64_t transfers = 0;
+    uint64_t naks = 0;
+    uint64_t samples = 0;
+    uint64_t stuck_samples = 0;
+    uint64_t resets = 0;
+  };
+
+  /**
+   * Register-level simulation of an I2C sensor, attached to a host bus with host_i2c_attach().
+   *
+   * Data registers are only updated once per sample period of the chip (measured on the shim clock), from wherever the
+   * trajectory is at that time, like a real chip converting in the background. Reads start at the register pointer and
+   * auto-increment, writes are left to the chip since they differ between them.
+   */
+  class SimulatedI2CDevice : public HostI2CDevice
+  {
+  public:
+    SimulatedI2CDevice(const TrajectoryProfile* profile, uint32_t seed);
+
+    int write(const uint8_t* src, size_t len, bool nostop) override;
+    int read(uint8_t* dst, size_t len, bool nostop) override;
+
+    void set_faults(const SimulatedBusFaults& faults);
+
+    /**
+     * Drop off the bus (every transfer NAKs) between the two times on the shim clock, and come back powered on again
+     * with every register reset, as if a connector came loose.
+     */
+    void disconnect_between(uint64_t from_us, uint64_t to_us);
+
+    // Reset every register to its power on value, as if power was cycled
+    void power_cycle();
+
+    [[nodiscard]] const SimulatedDeviceStats& get_stats() const;
+
+  protected:
+    uint8_t reg_ptr = 0;
+
+    // Put every register back to its power on value
+    virtual void reset_registers() = 0;
+
+    // Handle an entire write transfer, which has at least one byte
+    virtual void write_transfer(const uint8_t* src, size_t len) = 0;
+    [[nodiscard]] virtual uint8_t read_register(uint8_t reg) const = 0;
+
+    // How long between conversions with the current settings, 0 if the chip isn't converting
+    [[nodiscard]] virtual uint64_t get_sample_period_us() const = 0;
+    virtual void update_data_registers(const TrajectorySample& sample) = 0;
+
+    [[nodiscard]] double noise(double std_dev);
+
+  private:
+    struct DisconnectWindow
+    {
+      uint64_t from_us, to_us;
+    };
+
+    const TrajectoryProfile* profile;
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> chance{0, 1};
+    std::normal_distribution<double> normal{0, 1};
+
+    SimulatedBusFaults faults{};
+    SimulatedDeviceStats stats{};
+
+    std::vector<DisconnectWindow> disconnect_windows;
+    bool is_disconnected = false;
+
+    uint64_t next_sample_us = 0;
+    uint32_t remaining_stuck_samples = 0;
+
+    // Whether the transfer should go through, also handles coming back from a disconnect
+    bool begin_transfer();
+    void update_samples();
+  };
+}
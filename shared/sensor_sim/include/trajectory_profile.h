@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace sensor_sim
+{
+  /**
+   * What the sensors are experiencing at a point in time.
+   *
+   * Accelerations are the specific force in the sensor frame (what an accelerometer reads, so sitting still reads 1g
+   * opposite gravity), and gyro rates are in deg/s. Altitude is above sea level.
+   */
+  struct TrajectorySample
+  {
+    double time_s;
+    double altitude;
+    double accel_x, accel_y, accel_z;
+    double gyro_x, gyro_y, gyro_z;
+  };
+
+  struct SimulatedFlightSettings
+  {
+    double ground_altitude = 250;
+
+    double pad_time_s = 10;
+    double burn_time_s = 2;
+
+    // Motor acceleration during the burn, before gravity and drag
+    double thrust_accel = 100;
+
+    // Drag deceleration is drag_coefficient * v^2, the chute's is chosen so the descent rate is reached
+    double drag_coefficient = 0.0015;
+    double descent_rate = 6;
+
+    double landed_time_s = 10;
+
+    // Spin about the long axis while under thrust
+    double boost_roll_rate = 90;
+  };
+
+  /**
+   * A trajectory the simulated sensors sample from, linearly interpolated between its points. Times before the first
+   * point or after the last one hold the first or last point.
+   */
+  class TrajectoryProfile
+  {
+  public:
+    explicit TrajectoryProfile(std::vector<TrajectorySample> samples);
+
+    /**
+     * A single stage flight along the y axis, mounted so that sitting on the pad reads -1g in y (the same orientation
+     * the payload and override calibrate for). Sampled every millisecond.
+     */
+    static TrajectoryProfile simulated_flight(const SimulatedFlightSettings& settings = SimulatedFlightSettings());
+
+    /**
+     * Reads a CSV of time_s,altitude,accel_x,accel_y,accel_z,gyro_x,gyro_y,gyro_z with one header line, sorted by time.
+     *
+     * Returns false (leaving profile untouched) if the file can't be read or a line can't be parsed.
+     */
+    static bool load_csv(const std::string& path, TrajectoryProfile& profile, std::string& error);
+
+    [[nodiscard]] TrajectorySample sample(double time_s) const;
+
+    [[nodiscard]] double get_start_s() const;
+    [[nodiscard]] double get_end_s() const;
+
+    [[nodiscard]] double get_min_altitude() const;
+    [[nodiscard]] double get_max_altitude() const;
+
+  private:
+    std::vector<TrajectorySample> samples;
+
+    // Samples are usually taken in order, so the search starts where the last one ended
+    mutable size_t last_idx = 0;
+  };
+}
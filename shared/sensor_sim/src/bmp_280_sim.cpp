@@ -0,0 +1,265 @@
+#include "bmp_280_sim.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  // Standard atmosphere lapse rate, degC/m
+  constexpr double temperature_lapse_rate = 0.0065;
+
+  constexpr int32_t adc_max = 0xFFFFF;
+
+  constexpr uint64_t standby_times_us[8] = {500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000};
+  constexpr uint8_t filter_coefficients[8] = {1, 2, 4, 8, 16, 16, 16, 16};
+}
+
+sensor_sim::BMP280Sim::BMP280Sim(const TrajectoryProfile* profile, const uint32_t seed,
+                                 const BMP280SimSettings& settings) : SimulatedI2CDevice(profile, seed),
+                                                                      settings(settings)
+{
+  // Trimming values are stored little endian, in the same order as the struct
+  const BMP280::CalibrationData& calibration = settings.calibration;
+  const uint16_t trimming[CALIBRATION_SIZE / 2] = {
+    calibration.dig_T1, static_cast<uint16_t>(calibration.dig_T2), static_cast<uint16_t>(calibration.dig_T3),
+    calibration.dig_P1, static_cast<uint16_t>(calibration.dig_P2), static_cast<uint16_t>(calibration.dig_P3),
+    static_cast<uint16_t>(calibration.dig_P4), static_cast<uint16_t>(calibration.dig_P5),
+    static_cast<uint16_t>(calibration.dig_P6), static_cast<uint16_t>(calibration.dig_P7),
+    static_cast<uint16_t>(calibration.dig_P8), static_cast<uint16_t>(calibration.dig_P9)
+  };
+
+  for (size_t i = 0; i < CALIBRATION_SIZE / 2; i++)
+  {
+    calibration_regs[i * 2] = trimming[i] & 0xFF;
+    calibration_regs[i * 2 + 1] = trimming[i] >> 8;
+  }
+
+  reset_registers();
+}
+
+// Both of these are the double precision compensation from the datasheet (and the driver)
+double sensor_sim::BMP280Sim::compensate_temperature(const int32_t adc_temperature,
+                                                     const BMP280::CalibrationData& calibration, int32_t& t_fine)
+{
+  const double var1 = (adc_temperature / 16384.0 - calibration.dig_T1 / 1024.0) * calibration.dig_T2;
+  const double var2 = (adc_temperature / 131072.0 - calibration.dig_T1 / 8192.0) * (adc_temperature / 131072.0 -
+    calibration.dig_T1 / 8192.0) * calibration.dig_T3;
+  t_fine = static_cast<int32_t>(var1 + var2);
+  return (var1 + var2) / 5120.0;
+}
+
+double sensor_sim::BMP280Sim::compensate_pressure(const int32_t adc_pressure, const int32_t t_fine,
+                                                  const BMP280::CalibrationData& calibration)
+{
+  double var1 = t_fine / 2.0 - 64000.0;
+  double var2 = var1 * var1 * calibration.dig_P6 / 32768.0;
+  var2 = var2 + var1 * calibration.dig_P5 * 2.0;
+  var2 = var2 / 4.0 + calibration.dig_P4 * 65536.0;
+  var1 = (calibration.dig_P3 * var1 * var1 / 524288.0 + calibration.dig_P2 * var1) / 524288.0;
+  var1 = (1.0 + var1 / 32768.0) * calibration.dig_P1;
+  if (var1 == 0)
+  {
+    return 0;
+  }
+
+  double p = 1048576.0 - adc_pressure;
+  p = (p - var2 / 4096.0) * 6250.0 / var1;
+  var1 = calibration.dig_P9 * p * p / 2147483648.0;
+  var2 = p * calibration.dig_P8 / 32768.0;
+  return p + (var1 + var2 + calibration.dig_P7) / 16.0;
+}
+
+void sensor_sim::BMP280Sim::reset_registers()
+{
+  ctrl_meas = 0;
+  config = 0;
+  has_filtered_value = false;
+
+  for (size_t i = 0; i < DATA_SIZE; i += 3)
+  {
+    data_regs[i] = BMP_280_ADC_RESET_VALUE >> 12;
+    data_regs[i + 1] = 0;
+    data_regs[i + 2] = 0;
+  }
+}
+
+void sensor_sim::BMP280Sim::write_transfer(const uint8_t* src, const size_t len)
+{
+  reg_ptr = src[0];
+
+  // Writes are register/data pairs, there's no auto-increment
+  for (size_t i = 0; i + 1 < len; i += 2)
+  {
+    const uint8_t reg = src[i], value = src[i + 1];
+    switch (reg)
+    {
+    case REG_SOFT_RESET:
+      if (value == BMP_280_RESET_VALUE)
+      {
+        reset_registers();
+      }
+      break;
+    case REG_CTRL_MEAS:
+      ctrl_meas = value;
+      break;
+    case REG_CONFIG:
+      config = value;
+      break;
+    default:
+      // Read only
+      break;
+    }
+  }
+}
+
+uint8_t sensor_sim::BMP280Sim::read_register(const uint8_t reg) const
+{
+  if (reg >= REG_CALIBRATION && reg < REG_CALIBRATION + CALIBRATION_SIZE)
+  {
+    return calibration_regs[reg - REG_CALIBRATION];
+  }
+
+  if (reg >= REG_PRESS_MSB && reg < REG_PRESS_MSB + DATA_SIZE)
+  {
+    return data_regs[reg - REG_PRESS_MSB];
+  }
+
+  switch (reg)
+  {
+  case REG_CHIP_ID:
+    return BMP_280_CHIP_ID;
+  case REG_CTRL_MEAS:
+    return ctrl_meas;
+  case REG_CONFIG:
+    return config;
+  case REG_STATUS:
+    // Conversions finish instantly as far as the bus can tell
+  default:
+    return 0;
+  }
+}
+
+uint64_t sensor_sim::BMP280Sim::get_sample_period_us() const
+{
+  const uint8_t mode = ctrl_meas & 0b11;
+  if (mode == static_cast<uint8_t>(BMP280::DeviceMode::SleepMode))
+  {
+    return 0;
+  }
+
+  // Typical measurement time from the datasheet
+  const uint8_t temperature_os = get_oversampling(ctrl_meas >> 5);
+  const uint8_t pressure_os = get_oversampling(ctrl_meas >> 2 & 0b111);
+  uint64_t period_us = 1000 + 2000 * temperature_os + (pressure_os > 0 ? 2000 * pressure_os + 500 : 0);
+
+  if (mode == static_cast<uint8_t>(BMP280::DeviceMode::NormalMode))
+  {
+    period_us += standby_times_us[config >> 5];
+  }
+  return period_us;
+}
+
+void sensor_sim::BMP280Sim::update_data_registers(const TrajectorySample& sample)
+{
+  const uint8_t temperature_osrs = ctrl_meas >> 5;
+  const uint8_t pressure_osrs = ctrl_meas >> 2 & 0b111;
+  const uint8_t temperature_os = get_oversampling(temperature_osrs);
+  const uint8_t pressure_os = get_oversampling(pressure_osrs);
+
+  const uint8_t filter_coefficient = filter_coefficients[config >> 2 & 0b111];
+  const bool is_filtered = filter_coefficient > 1;
+
+  const auto filter = [this, filter_coefficient](double& filtered, const int32_t adc)
+  {
+    filtered = has_filtered_value ? (filtered * (filter_coefficient - 1) + adc) / filter_coefficient : adc;
+  };
+
+  double temperature = settings.sea_level_temperature - temperature_lapse_rate * sample.altitude;
+  double pressure = settings.sea_level_pressure * std::pow(1 - sample.altitude / 44330.0, 5.255);
+
+  int32_t adc_temperature = BMP_280_ADC_RESET_VALUE;
+  if (temperature_os > 0)
+  {
+    temperature += noise(settings.temperature_noise / std::sqrt(temperature_os));
+    filter(filtered_adc_temperature, find_adc_temperature(temperature));
+    adc_temperature = apply_resolution(filtered_adc_temperature, temperature_osrs, is_filtered);
+  }
+
+  int32_t adc_pressure = BMP_280_ADC_RESET_VALUE;
+  if (pressure_os > 0)
+  {
+    // The driver gets t_fine from the temperature registers, so the pressure has to be found with the same one
+    int32_t t_fine;
+    compensate_temperature(adc_temperature, settings.calibration, t_fine);
+
+    pressure += noise(settings.pressure_noise_pa / std::sqrt(pressure_os));
+    filter(filtered_adc_pressure, find_adc_pressure(pressure, t_fine));
+    adc_pressure = apply_resolution(filtered_adc_pressure, pressure_osrs, is_filtered);
+  }
+  has_filtered_value = true;
+
+  data_regs[0] = adc_pressure >> 12;
+  data_regs[1] = adc_pressure >> 4 & 0xFF;
+  data_regs[2] = (adc_pressure & 0x0F) << 4;
+  data_regs[3] = adc_temperature >> 12;
+  data_regs[4] = adc_temperature >> 4 & 0xFF;
+  data_regs[5] = (adc_temperature & 0x0F) << 4;
+
+  // Forced mode goes back to sleep after a single conversion
+  if ((ctrl_meas & 0b11) != static_cast<uint8_t>(BMP280::DeviceMode::NormalMode))
+  {
+    ctrl_meas &= ~0b11;
+  }
+}
+
+int32_t sensor_sim::BMP280Sim::find_adc_temperature(const double temperature) const
+{
+  // Compensated temperature only increases with the raw value, so a binary search finds the closest count
+  int32_t low = 0, high = adc_max;
+  while (low < high)
+  {
+    const int32_t mid = low + (high - low) / 2;
+    int32_t t_fine;
+    if (compensate_temperature(mid, settings.calibration, t_fine) < temperature)
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+int32_t sensor_sim::BMP280Sim::find_adc_pressure(const double pressure, const int32_t t_fine) const
+{
+  // Compensated pressure only decreases as the raw value increases
+  int32_t low = 0, high = adc_max;
+  while (low < high)
+  {
+    const int32_t mid = low + (high - low) / 2;
+    if (compensate_pressure(mid, t_fine, settings.calibration) > pressure)
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+uint8_t sensor_sim::BMP280Sim::get_oversampling(const uint8_t osrs)
+{
+  return osrs == 0 ? 0 : 1 << (std::min<uint8_t>(osrs, 5) - 1);
+}
+
+int32_t sensor_sim::BMP280Sim::apply_resolution(const double adc, const uint8_t osrs, const bool is_filtered)
+{
+  // 16 bits at 1x oversampling, and one more for each step up to 20, the filter always gives all 20
+  const uint8_t dropped_bits = is_filtered ? 0 : 5 - std::min<uint8_t>(osrs, 5);
+  const auto value = std::clamp(static_cast<int32_t>(std::lround(adc)), 0, adc_max);
+  return value & ~((1 << dropped_bits) - 1);
+}
@@ -0,0 +1,97 @@
+#include "mpu_6050_sim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+  // Factory self-test trim, only here so the registers aren't blank
+  constexpr uint8_t self_test_values[4] = {0x6A, 0x69, 0x6C, 0x56};
+}
+
+sensor_sim::MPU6050Sim::MPU6050Sim(const TrajectoryProfile* profile, const uint32_t seed,
+                                   const MPU6050SimSettings& settings) : SimulatedI2CDevice(profile, seed),
+                                                                         settings(settings)
+{
+  reset_registers();
+}
+
+void sensor_sim::MPU6050Sim::reset_registers()
+{
+  std::ranges::fill(regs, 0);
+  std::ranges::copy(self_test_values, regs + REG_SELF_TEST_X);
+  regs[REG_PWR_MGMT_1] = PWR_MGMT_1_RESET;
+  regs[REG_WHO_AM_I] = MPU_6050_DEVICE_ID;
+}
+
+void sensor_sim::MPU6050Sim::write_transfer(const uint8_t* src, const size_t len)
+{
+  reg_ptr = src[0];
+
+  // Writes auto-increment from the first register
+  for (size_t i = 1; i < len; i++)
+  {
+    const uint8_t reg = reg_ptr++;
+    if (reg >= REG_COUNT || reg == REG_WHO_AM_I || (reg >= REG_ACCEL_XOUT && reg <= REG_GYRO_ZOUT + 1))
+    {
+      continue;
+    }
+
+    if (reg == REG_PWR_MGMT_1 && src[i] & PWR_MGMT_1_DEVICE_RESET)
+    {
+      reset_registers();
+      continue;
+    }
+
+    regs[reg] = src[i];
+  }
+}
+
+uint8_t sensor_sim::MPU6050Sim::read_register(const uint8_t reg) const
+{
+  return reg < REG_COUNT ? regs[reg] : 0;
+}
+
+uint64_t sensor_sim::MPU6050Sim::get_sample_period_us() const
+{
+  if (regs[REG_PWR_MGMT_1] & PWR_MGMT_1_SLEEP)
+  {
+    return 0;
+  }
+
+  // The gyro outputs at 8 kHz with the low pass filter off, otherwise 1 kHz, then it's divided down
+  const uint8_t dlpf_cfg = regs[REG_CONFIG] & 0x07;
+  const uint64_t gyro_period_us = dlpf_cfg == 0 || dlpf_cfg == 7 ? 125 : 1000;
+  return gyro_period_us * (1 + regs[REG_SMPLRT_DIV]);
+}
+
+void sensor_sim::MPU6050Sim::update_data_registers(const TrajectorySample& sample)
+{
+  const double accel_scale = MPU6050::get_accel_scale(
+    static_cast<MPU6050::AccelFullScaleRange>(regs[REG_ACCEL_CONFIG] >> 3 & 0b11));
+  const double gyro_scale = MPU6050::get_gyro_scale(
+    static_cast<MPU6050::GyroFullScaleRange>(regs[REG_GYRO_CONFIG] >> 3 & 0b11));
+
+  put_data(REG_ACCEL_XOUT, sample.accel_x + settings.accel_bias_x + noise(settings.accel_noise), accel_scale);
+  put_data(REG_ACCEL_YOUT, sample.accel_y + settings.accel_bias_y + noise(settings.accel_noise), accel_scale);
+  put_data(REG_ACCEL_ZOUT, sample.accel_z + settings.accel_bias_z + noise(settings.accel_noise), accel_scale);
+
+  // Temperature in degC is TEMP_OUT / 340 + 36.53
+  put_data(REG_TEMP_OUT, settings.temperature - 36.53, 1 / 340.0);
+
+  put_data(REG_GYRO_XOUT, sample.gyro_x + settings.gyro_bias_x + noise(settings.gyro_noise), gyro_scale);
+  put_data(REG_GYRO_YOUT, sample.gyro_y + settings.gyro_bias_y + noise(settings.gyro_noise), gyro_scale);
+  put_data(REG_GYRO_ZOUT, sample.gyro_z + settings.gyro_bias_z + noise(settings.gyro_noise), gyro_scale);
+}
+
+void sensor_sim::MPU6050Sim::put_data(const uint8_t reg, const double value, const double scale)
+{
+  // Anything outside of the full scale range saturates
+  const double counts = std::clamp(std::round(value / scale),
+                                   static_cast<double>(std::numeric_limits<int16_t>::min()),
+                                   static_cast<double>(std::numeric_limits<int16_t>::max()));
+  const auto raw = static_cast<uint16_t>(static_cast<int16_t>(counts));
+  regs[reg] = raw >> 8;
+  regs[reg + 1] = raw & 0xFF;
+}
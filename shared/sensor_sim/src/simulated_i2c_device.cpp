@@ -0,0 +1,142 @@
+#include "simulated_i2c_device.h"
+
+#include <pico/error.h>
+#include <pico/time.h>
+
+sensor_sim::SimulatedI2CDevice::SimulatedI2CDevice(const TrajectoryProfile* profile, const uint32_t seed) :
+  profile(profile), rng(seed)
+{
+}
+
+int sensor_sim::SimulatedI2CDevice::write(const uint8_t* src, const size_t len, bool)
+{
+  if (!begin_transfer())
+  {
+    return PICO_ERROR_GENERIC;
+  }
+
+  if (len > 0)
+  {
+    write_transfer(src, len);
+  }
+  return static_cast<int>(len);
+}
+
+int sensor_sim::SimulatedI2CDevice::read(uint8_t* dst, const size_t len, bool)
+{
+  if (!begin_transfer())
+  {
+    return PICO_ERROR_GENERIC;
+  }
+
+  update_samples();
+
+  for (size_t i = 0; i < len; i++)
+  {
+    dst[i] = read_register(reg_ptr++);
+  }
+  return static_cast<int>(len);
+}
+
+void sensor_sim::SimulatedI2CDevice::set_faults(const SimulatedBusFaults& faults)
+{
+  this->faults = faults;
+}
+
+void sensor_sim::SimulatedI2CDevice::disconnect_between(const uint64_t from_us, const uint64_t to_us)
+{
+  disconnect_windows.push_back({from_us, to_us});
+}
+
+void sensor_sim::SimulatedI2CDevice::power_cycle()
+{
+  reg_ptr = 0;
+  next_sample_us = 0;
+  remaining_stuck_samples = 0;
+  reset_registers();
+  stats.resets++;
+}
+
+const sensor_sim::SimulatedDeviceStats& sensor_sim::SimulatedI2CDevice::get_stats() const
+{
+  return stats;
+}
+
+double sensor_sim::SimulatedI2CDevice::noise(const double std_dev)
+{
+  return normal(rng) * std_dev;
+}
+
+bool sensor_sim::SimulatedI2CDevice::begin_transfer()
+{
+  stats.transfers++;
+
+  const uint64_t now_us = time_us_64();
+  bool in_window = false;
+  for (const DisconnectWindow& window : disconnect_windows)
+  {
+    in_window |= now_us >= window.from_us && now_us < window.to_us;
+  }
+
+  if (in_window)
+  {
+    is_disconnected = true;
+    stats.naks++;
+    return false;
+  }
+
+  if (is_disconnected)
+  {
+    is_disconnected = false;
+    power_cycle();
+  }
+
+  if (faults.nak_probability > 0 && chance(rng) < faults.nak_probability)
+  {
+    stats.naks++;
+    return false;
+  }
+
+  return true;
+}
+
+void sensor_sim::SimulatedI2CDevice::update_samples()
+{
+  const uint64_t sample_period_us = get_sample_period_us();
+  if (sample_period_us == 0)
+  {
+    next_sample_us = 0;
+    return;
+  }
+
+  // Nothing is converted until a full period after the chip starts, until then the registers keep their reset values
+  const uint64_t now_us = time_us_64();
+  if (next_sample_us == 0)
+  {
+    next_sample_us = now_us + sample_period_us;
+  }
+
+  if (now_us < next_sample_us)
+  {
+    return;
+  }
+
+  // Conversions keep a steady cadence, but only the latest is visible however many were missed since the last read
+  const uint64_t converted_at_us = now_us - (now_us - next_sample_us) % sample_period_us;
+  next_sample_us = converted_at_us + sample_period_us;
+  stats.samples++;
+
+  if (remaining_stuck_samples == 0 && faults.stuck_probability > 0 && chance(rng) < faults.stuck_probability)
+  {
+    remaining_stuck_samples = faults.stuck_samples;
+  }
+
+  if (remaining_stuck_samples > 0)
+  {
+    remaining_stuck_samples--;
+    stats.stuck_samples++;
+    return;
+  }
+
+  update_data_registers(profile->sample(static_cast<double>(converted_at_us) / 1e6));
+}
@@ -0,0 +1,197 @@
+#include "trajectory_profile.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+  constexpr double gravity = 9.80665;
+  constexpr double flight_step_s = 0.001;
+
+  double lerp(const double a, const double b, const double t)
+  {
+    return a + (b - a) * t;
+  }
+}
+
+sensor_sim::TrajectoryProfile::TrajectoryProfile(std::vector<TrajectorySample> samples) : samples(std::move(samples))
+{
+  assert(!this->samples.empty());
+  assert(std::ranges::is_sorted(this->samples, {}, &TrajectorySample::time_s));
+}
+
+sensor_sim::TrajectoryProfile sensor_sim::TrajectoryProfile::simulated_flight(const SimulatedFlightSettings& settings)
+{
+  const double chute_drag_coefficient = gravity / (settings.descent_rate * settings.descent_rate);
+  const double burnout_s = settings.pad_time_s + settings.burn_time_s;
+
+  std::vector<TrajectorySample> samples;
+  double height = 0, velocity = 0;
+  bool passed_apogee = false, has_landed = false;
+  double landed_at_s = 0;
+
+  for (size_t step = 0; !has_landed || step * flight_step_s < landed_at_s + settings.landed_time_s; step++)
+  {
+    const double time_s = static_cast<double>(step) * flight_step_s;
+
+    double accel = 0, roll_rate = 0;
+    if (time_s >= settings.pad_time_s && !has_landed)
+    {
+      // Drag always opposes the direction of travel
+      const double drag = (passed_apogee ? chute_drag_coefficient : settings.drag_coefficient) * velocity * std::abs(
+        velocity);
+      accel = -gravity - drag;
+
+      if (time_s < burnout_s)
+      {
+        accel += settings.thrust_accel;
+        roll_rate = settings.boost_roll_rate;
+      }
+    }
+
+    // What an accelerometer reads is everything except gravity, and the sensor's y axis points down
+    samples.push_back({
+      time_s, settings.ground_altitude + height, 0, -(accel + gravity), 0, 0, roll_rate, 0
+    });
+
+    if (time_s < settings.pad_time_s || has_landed)
+    {
+      continue;
+    }
+
+    velocity += accel * flight_step_s;
+    height += velocity * flight_step_s;
+
+    if (time_s >= burnout_s && velocity <= 0)
+    {
+      passed_apogee = true;
+    }
+
+    if (height <= 0 && passed_apogee)
+    {
+      height = 0;
+      velocity = 0;
+      has_landed = true;
+      landed_at_s = time_s;
+    }
+  }
+
+  return TrajectoryProfile(std::move(samples));
+}
+
+bool sensor_sim::TrajectoryProfile::load_csv(const std::string& path, TrajectoryProfile& profile, std::string& error)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    error = "Could not open " + path;
+    return false;
+  }
+
+  std::vector<TrajectorySample> samples;
+  std::string line;
+  size_t line_num = 1;
+
+  // Header
+  std::getline(file, line);
+
+  while (std::getline(file, line))
+  {
+    line_num++;
+    if (line.empty() || line == "\r")
+    {
+      continue;
+    }
+
+    TrajectorySample sample{};
+    const int parsed = sscanf(line.c_str(), "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", &sample.time_s, &sample.altitude,
+                              &sample.accel_x, &sample.accel_y, &sample.accel_z, &sample.gyro_x, &sample.gyro_y,
+                              &sample.gyro_z);
+    if (parsed != 8)
+    {
+      error = path + ":" + std::to_string(line_num) + ": expected 8 values";
+      return false;
+    }
+
+    if (!samples.empty() && sample.time_s < samples.back().time_s)
+    {
+      error = path + ":" + std::to_string(line_num) + ": time went backwards";
+      return false;
+    }
+
+    samples.push_back(sample);
+  }
+
+  if (samples.empty())
+  {
+    error = path + " has no samples";
+    return false;
+  }
+
+  profile = TrajectoryProfile(std::move(samples));
+  return true;
+}
+
+sensor_sim::TrajectorySample sensor_sim::TrajectoryProfile::sample(const double time_s) const
+{
+  if (time_s <= samples.front().time_s)
+  {
+    return samples.front();
+  }
+
+  if (time_s >= samples.back().time_s)
+  {
+    return samples.back();
+  }
+
+  if (last_idx >= samples.size() - 1 || samples[last_idx].time_s > time_s)
+  {
+    last_idx = 0;
+  }
+
+  // Only search what's after the last sample, which is usually where the next one is
+  if (samples[last_idx + 1].time_s <= time_s)
+  {
+    const auto next = std::ranges::upper_bound(samples.begin() + static_cast<std::ptrdiff_t>(last_idx), samples.end(),
+                                               time_s, {}, &TrajectorySample::time_s);
+    last_idx = next - samples.begin() - 1;
+  }
+
+  const TrajectorySample& before = samples[last_idx];
+  const TrajectorySample& after = samples[last_idx + 1];
+  const double t = (time_s - before.time_s) / (after.time_s - before.time_s);
+
+  return {
+    time_s,
+    lerp(before.altitude, after.altitude, t),
+    lerp(before.accel_x, after.accel_x, t),
+    lerp(before.accel_y, after.accel_y, t),
+    lerp(before.accel_z, after.accel_z, t),
+    lerp(before.gyro_x, after.gyro_x, t),
+    lerp(before.gyro_y, after.gyro_y, t),
+    lerp(before.gyro_z, after.gyro_z, t)
+  };
+}
+
+double sensor_sim::TrajectoryProfile::get_start_s() const
+{
+  return samples.front().time_s;
+}
+
+double sensor_sim::TrajectoryProfile::get_end_s() const
+{
+  return samples.back().time_s;
+}
+
+double sensor_sim::TrajectoryProfile::get_min_altitude() const
+{
+  return std::ranges::min(samples, {}, &TrajectorySample::altitude).altitude;
+}
+
+double sensor_sim::TrajectoryProfile::get_max_altitude() const
+{
+  return std::ranges::max(samples, {}, &TrajectorySample::altitude).altitude;
+}
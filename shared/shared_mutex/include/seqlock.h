@@ -0,0 +1,32 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <hardware/sync.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+// Sequence lock for small, frequently read data. Readers never block the writer, they just retry if a write
+// happened while they were copying. Writers are serialized with a hardware spin lock.
+typedef struct
+{
+  volatile uint32_t sequence;
+  spin_lock_t* writer_lock;
+} seqlock_t;
+
+void seqlock_init(seqlock_t* seq_lck);
+
+// Interrupts are disabled between begin and end, keep the write short
+uint32_t seqlock_write_begin(seqlock_t* seq_lck);
+void seqlock_write_end(seqlock_t* seq_lck, uint32_t saved_irq);
+
+uint32_t seqlock_read_begin(const seqlock_t* seq_lck);
+bool seqlock_read_retry(const seqlock_t* seq_lck, uint32_t start_sequence);
+
+// Copy len bytes from src to dest as a single write/consistent read
+void seqlock_write(seqlock_t* seq_lck, void* dest, const void* src, size_t len);
+void seqlock_read(const seqlock_t* seq_lck, void* dest, const void* src, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,14 +1,36 @@
 #pragma once
-#include <pico/mutex.h>
+#include <pico/lock_core.h>
+#include <hardware/sync.h>
+
+// How many times a blocked acquire re-polls the lock before it waits for an event
+#define SHARED_MUTEX_SPIN_COUNT 64
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 typedef struct
 {
+  uint32_t shared_acquires;
+  uint32_t exclusive_acquires;
+
+  // Acquires that found the lock unavailable at least once
+  uint32_t shared_contended;
+  uint32_t exclusive_contended;
+
+  // Acquires that used up their spins and had to wait for an event
+  uint32_t shared_blocked;
+  uint32_t exclusive_blocked;
+} shared_mutex_stats_t;
+
+// Writer-preferring reader/writer lock, once a writer is waiting no new readers are let in
+typedef struct
+{
+  lock_core_t core;
   unsigned int reader_count;
-  mutex_t reader_mutex;
-  mutex_t writer_mutex;
+  unsigned int writers_waiting;
+  bool writer_active;
+
+  shared_mutex_stats_t stats;
 } shared_mutex_t;
 
 void shared_mutex_init(shared_mutex_t* s_mtx);
@@ -19,6 +41,9 @@ void shared_mutex_exit_shared(shared_mutex_t* s_mtx);
 void shared_mutex_enter_blocking_exclusive(shared_mutex_t* s_mtx);
 void shared_mutex_exit_exclusive(shared_mutex_t* s_mtx);
 
+void shared_mutex_get_stats(shared_mutex_t* s_mtx, shared_mutex_stats_t* stats);
+void shared_mutex_reset_stats(shared_mutex_t* s_mtx);
+
 #ifdef __cplusplus
 }
 #endif
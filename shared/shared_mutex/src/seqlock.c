@@ -0,0 +1,63 @@
+#include "seqlock.h"
+
+#include <string.h>
+
+void seqlock_init(seqlock_t* seq_lck)
+{
+  seq_lck->sequence = 0;
+  seq_lck->writer_lock = spin_lock_instance(next_striped_spin_lock_num());
+  __mem_fence_release();
+}
+
+uint32_t seqlock_write_begin(seqlock_t* seq_lck)
+{
+  const uint32_t saved_irq = spin_lock_blocking(seq_lck->writer_lock);
+
+  // An odd sequence tells readers a write is in progress
+  seq_lck->sequence++;
+  __dmb();
+  return saved_irq;
+}
+
+void seqlock_write_end(seqlock_t* seq_lck, const uint32_t saved_irq)
+{
+  __dmb();
+  seq_lck->sequence++;
+  spin_unlock(seq_lck->writer_lock, saved_irq);
+}
+
+uint32_t seqlock_read_begin(const seqlock_t* seq_lck)
+{
+  uint32_t sequence;
+  while ((sequence = seq_lck->sequence) & 0x01)
+  {
+    tight_loop_contents();
+  }
+
+  __dmb();
+  return sequence;
+}
+
+bool seqlock_read_retry(const seqlock_t* seq_lck, const uint32_t start_sequence)
+{
+  __dmb();
+  return seq_lck->sequence != start_sequence;
+}
+
+void seqlock_write(seqlock_t* seq_lck, void* dest, const void* src, const size_t len)
+{
+  const uint32_t saved_irq = seqlock_write_begin(seq_lck);
+  memcpy(dest, src, len);
+  seqlock_write_end(seq_lck, saved_irq);
+}
+
+void seqlock_read(const seqlock_t* seq_lck, void* dest, const void* src, const size_t len)
+{
+  uint32_t sequence;
+  do
+  {
+    sequence = seqlock_read_begin(seq_lck);
+    memcpy(dest, src, len);
+  }
+  while (seqlock_read_retry(seq_lck, sequence));
+}
@@ -1,42 +1,135 @@
 #include "shared_mutex.h"
 
-#include <pico/mutex.h>
+#include <assert.h>
+#include <string.h>
+#include <pico/lock_core.h>
 
 void shared_mutex_init(shared_mutex_t* s_mtx)
 {
+  lock_init(&s_mtx->core, next_striped_spin_lock_num());
   s_mtx->reader_count = 0;
-  mutex_init(&s_mtx->reader_mutex);
-  mutex_init(&s_mtx->writer_mutex);
+  s_mtx->writers_waiting = 0;
+  s_mtx->writer_active = false;
+  memset(&s_mtx->stats, 0, sizeof(shared_mutex_stats_t));
+  __mem_fence_release();
 }
 
 void shared_mutex_enter_blocking_shared(shared_mutex_t* s_mtx)
 {
-  mutex_enter_blocking(&s_mtx->reader_mutex);
-  s_mtx->reader_count++;
-  if (s_mtx->reader_count == 1)
+  unsigned int spins = 0;
+  while (true)
   {
-    mutex_enter_blocking(&s_mtx->writer_mutex);
+    const uint32_t saved_irq = spin_lock_blocking(s_mtx->core.spin_lock);
+    if (!s_mtx->writer_active && s_mtx->writers_waiting == 0)
+    {
+      s_mtx->reader_count++;
+
+      s_mtx->stats.shared_acquires++;
+      if (spins > 0)
+      {
+        s_mtx->stats.shared_contended++;
+      }
+      if (spins > SHARED_MUTEX_SPIN_COUNT)
+      {
+        s_mtx->stats.shared_blocked++;
+      }
+
+      spin_unlock(s_mtx->core.spin_lock, saved_irq);
+      return;
+    }
+
+    // Holds are short, so spinning is cheaper than a wait/notify round trip until it clearly isn't
+    spins++;
+    if (spins <= SHARED_MUTEX_SPIN_COUNT)
+    {
+      spin_unlock(s_mtx->core.spin_lock, saved_irq);
+      tight_loop_contents();
+    }
+    else
+    {
+      lock_internal_spin_unlock_with_wait(&s_mtx->core, saved_irq);
+    }
   }
-  mutex_exit(&s_mtx->reader_mutex);
 }
 
 void shared_mutex_exit_shared(shared_mutex_t* s_mtx)
 {
-  mutex_enter_blocking(&s_mtx->reader_mutex);
+  const uint32_t saved_irq = spin_lock_blocking(s_mtx->core.spin_lock);
+  assert(s_mtx->reader_count > 0);
   s_mtx->reader_count--;
+
   if (s_mtx->reader_count == 0)
   {
-    mutex_exit(&s_mtx->writer_mutex);
+    lock_internal_spin_unlock_with_notify(&s_mtx->core, saved_irq);
+  }
+  else
+  {
+    spin_unlock(s_mtx->core.spin_lock, saved_irq);
   }
-  mutex_exit(&s_mtx->reader_mutex);
 }
 
 void shared_mutex_enter_blocking_exclusive(shared_mutex_t* s_mtx)
 {
-  mutex_enter_blocking(&s_mtx->writer_mutex);
+  unsigned int spins = 0;
+  while (true)
+  {
+    const uint32_t saved_irq = spin_lock_blocking(s_mtx->core.spin_lock);
+    if (!s_mtx->writer_active && s_mtx->reader_count == 0)
+    {
+      s_mtx->writer_active = true;
+
+      s_mtx->stats.exclusive_acquires++;
+      if (spins > 0)
+      {
+        s_mtx->writers_waiting--;
+        s_mtx->stats.exclusive_contended++;
+      }
+      if (spins > SHARED_MUTEX_SPIN_COUNT)
+      {
+        s_mtx->stats.exclusive_blocked++;
+      }
+
+      spin_unlock(s_mtx->core.spin_lock, saved_irq);
+      return;
+    }
+
+    // Announce ourselves the first time around so new readers hold off
+    if (spins == 0)
+    {
+      s_mtx->writers_waiting++;
+    }
+
+    spins++;
+    if (spins <= SHARED_MUTEX_SPIN_COUNT)
+    {
+      spin_unlock(s_mtx->core.spin_lock, saved_irq);
+      tight_loop_contents();
+    }
+    else
+    {
+      lock_internal_spin_unlock_with_wait(&s_mtx->core, saved_irq);
+    }
+  }
 }
 
 void shared_mutex_exit_exclusive(shared_mutex_t* s_mtx)
 {
-  mutex_exit(&s_mtx->writer_mutex);
+  const uint32_t saved_irq = spin_lock_blocking(s_mtx->core.spin_lock);
+  assert(s_mtx->writer_active);
+  s_mtx->writer_active = false;
+  lock_internal_spin_unlock_with_notify(&s_mtx->core, saved_irq);
+}
+
+void shared_mutex_get_stats(shared_mutex_t* s_mtx, shared_mutex_stats_t* stats)
+{
+  const uint32_t saved_irq = spin_lock_blocking(s_mtx->core.spin_lock);
+  memcpy(stats, &s_mtx->stats, sizeof(shared_mutex_stats_t));
+  spin_unlock(s_mtx->core.spin_lock, saved_irq);
+}
+
+void shared_mutex_reset_stats(shared_mutex_t* s_mtx)
+{
+  const uint32_t saved_irq = spin_lock_blocking(s_mtx->core.spin_lock);
+  memset(&s_mtx->stats, 0, sizeof(shared_mutex_stats_t));
+  spin_unlock(s_mtx->core.spin_lock, saved_irq);
 }
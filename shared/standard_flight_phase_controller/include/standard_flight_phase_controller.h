@@ -1,11 +1,48 @@
 #pragma once
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <deque>
 #include <limits>
 #include <string>
+#include <pico/time.h>
 
 #include "flight_phase_controller.h"
+#include "vertical_kalman_filter.h"
+#include "windowed_stats.h"
+
+#ifndef GRAVITY_CONSTANT
+#define GRAVITY_CONSTANT 9.80665
+#endif
+
+// Kalman filter noise, see VerticalKalmanFilter. Jerk is high so burnout shows up in a sample or two.
+#define STANDARD_FPC_JERK_NOISE 50.f
+#define STANDARD_FPC_ALTITUDE_NOISE 1.f
+#define STANDARD_FPC_ACCEL_NOISE 0.5f
+
+// Samples in a row the fused velocity (for burnout) or altitude (for apogee) has to fall for before the phase changes
+#define STANDARD_FPC_CONFIRM_SAMPLES 3
+// Window the fused velocity and altitude trends are counted over
+#define STANDARD_FPC_TREND_WINDOW_US 1000000
+// Upward velocity that counts as having launched, m/s
+#define STANDARD_FPC_LAUNCH_VELOCITY 10
+// Landed once, over the last STANDARD_FPC_LANDED_HOLD_US, the altitude has stayed within STANDARD_FPC_LANDED_SPREAD (m)
+// and the vertical velocity has averaged under STANDARD_FPC_LANDED_VELOCITY (m/s)
+#define STANDARD_FPC_LANDED_HOLD_US 3000000
+#define STANDARD_FPC_LANDED_SPREAD 3
+#define STANDARD_FPC_LANDED_VELOCITY 1
+// How much of each preflight sample goes into the average direction of gravity
+#define STANDARD_FPC_UP_AVERAGE_WEIGHT 0.05
+
+// The ground is the average altitude over this much of the pad, right before launch
+#define STANDARD_FPC_PAD_WINDOW_US 1000000
+// Drag is fitted over this much of the coast, from samples going at least STANDARD_FPC_DRAG_FIT_MIN_VELOCITY (m/s)
+#define STANDARD_FPC_DRAG_FIT_WINDOW_US 1000000
+#define STANDARD_FPC_DRAG_FIT_MIN_VELOCITY 20
+// Descent rate (m/s) landing is predicted with until the rocket is actually coming down under its chute
+#define STANDARD_FPC_EXPECTED_DESCENT_RATE 6
+// predict_phase() gives the next phase once it's predicted to be this close
+#define STANDARD_FPC_PREDICTION_LEAD_US 500000
 
 enum class StandardFlightPhase : uint8_t
 {
@@ -33,7 +70,7 @@ public:
   StandardFlightPhaseController();
 
   [[nodiscard]] StandardFlightPhase initial_flight_phase() const override;
-  [[nodiscard]] bool should_log(StandardFlightPhase current_phase) const override;
+  [[nodiscard]] uint64_t get_log_interval_us(StandardFlightPhase current_phase) const override;
 
   [[nodiscard]] StandardFlightPhase update_phase(StandardFlightPhase current_phase,
                                                  const std::deque<TStateData>& state_history) override;
@@ -42,14 +79,46 @@ public:
 
   [[nodiscard]] std::string get_phase_name(StandardFlightPhase phase) const override;
 
+  [[nodiscard]] elijah_state_framework::VerticalEstimate get_vertical_estimate() const override;
+  [[nodiscard]] elijah_state_framework::FlightPrediction get_flight_prediction() const override;
+
 protected:
   virtual void extract_state_data(TStateData state, double& accel_x, double& accel_y, double& accel_z,
                                   double& altitude) const = 0;
 
 private:
+  // Runs the filter up to now with the newest sample
+  void update_vertical_estimate(StandardFlightPhase current_phase, double accel_x, double accel_y, double accel_z,
+                                double altitude);
+  // Fits drag to the coast so far and flies the estimate ballistically from there to apogee, then down at the
+  // descent rate
+  void update_prediction(StandardFlightPhase current_phase, double altitude);
+
   double min_preflight_alt, max_preflight_accel;
 
   double max_coast_alt;
+
+  elijah_state_framework::VerticalKalmanFilter vertical_filter{
+    STANDARD_FPC_JERK_NOISE, STANDARD_FPC_ALTITUDE_NOISE, STANDARD_FPC_ACCEL_NOISE
+  };
+  uint64_t last_update_us = 0;
+
+  // Unit vector the accelerometer reads gravity along on the pad (pointing up, it's what holds the rocket up), the
+  // rocket is assumed to keep pointing the same way through the boost and coast
+  double up_x = 0, up_y = 0, up_z = 0;
+  bool has_up = false;
+
+  // Every phase check reads these instead of going through the state history
+  elijah_state_framework::TrendCounter velocity_trend{STANDARD_FPC_TREND_WINDOW_US};
+  elijah_state_framework::TrendCounter altitude_trend{STANDARD_FPC_TREND_WINDOW_US};
+  elijah_state_framework::SlidingMinMax recent_altitude{STANDARD_FPC_LANDED_HOLD_US};
+  elijah_state_framework::RunningStats recent_velocity{STANDARD_FPC_LANDED_HOLD_US};
+
+  elijah_state_framework::RunningStats pad_altitude{STANDARD_FPC_PAD_WINDOW_US};
+  // Deceleration from drag over velocity squared
+  elijah_state_framework::RunningStats drag_fit{STANDARD_FPC_DRAG_FIT_WINDOW_US};
+  elijah_state_framework::FlightPrediction prediction{-1, -1, -1};
+  uint64_t descent_start_us = 0;
 };
 
 template <typename TStateData>
@@ -68,9 +137,24 @@ StandardFlightPhase StandardFlightPhaseController<TStateData>::initial_flight_ph
 }
 
 template <typename TStateData>
-bool StandardFlightPhaseController<TStateData>::should_log(const StandardFlightPhase current_phase) const
+uint64_t StandardFlightPhaseController<TStateData>::get_log_interval_us(const StandardFlightPhase current_phase) const
 {
-  return current_phase != StandardFlightPhase::PREFLIGHT;
+  switch (current_phase)
+  {
+  case StandardFlightPhase::PREFLIGHT:
+    // 1 Hz, the rocket can sit on the pad for hours
+    return 1000000;
+  case StandardFlightPhase::LAUNCH:
+  case StandardFlightPhase::COAST:
+    return 0;
+  case StandardFlightPhase::DESCENT:
+    // 10 Hz
+    return 100000;
+  case StandardFlightPhase::LANDED:
+    // 0.1 Hz
+    return 10000000;
+  }
+  return 0;
 }
 
 template <typename TStateData>
@@ -81,6 +165,15 @@ StandardFlightPhase StandardFlightPhaseController<TStateData>::update_phase(
   extract_state_data(state_history.front(), accel_x, accel_y, accel_z, altitude);
   const double accel = sqrt(accel_x * accel_x + accel_y * accel_y + accel_z * accel_z);
 
+  update_vertical_estimate(current_phase, accel_x, accel_y, accel_z, altitude);
+  const elijah_state_framework::VerticalEstimate estimate = vertical_filter.get_estimate();
+
+  velocity_trend.push(last_update_us, estimate.velocity);
+  altitude_trend.push(last_update_us, estimate.altitude);
+  recent_altitude.push(last_update_us, altitude);
+  recent_velocity.push(last_update_us, estimate.velocity);
+  update_prediction(current_phase, altitude);
+
   if (current_phase == StandardFlightPhase::PREFLIGHT)
   {
     if (altitude < min_preflight_alt)
@@ -93,8 +186,10 @@ StandardFlightPhase StandardFlightPhaseController<TStateData>::update_phase(
       max_preflight_accel = accel;
     }
 
-    // Once altitude increases by 30m overall, and an acceleration at some point of greater than 50m/s^2 was reached
-    if (altitude - min_preflight_alt > 30 && max_preflight_accel > 50)
+    // Once the rocket is going up fast (or has gone up 30m overall), and an acceleration at some point of greater than
+    // 50m/s^2 was reached
+    if ((estimate.velocity > STANDARD_FPC_LAUNCH_VELOCITY || altitude - min_preflight_alt > 30) &&
+      max_preflight_accel > 50)
     {
       return StandardFlightPhase::LAUNCH;
     }
@@ -102,36 +197,12 @@ StandardFlightPhase StandardFlightPhaseController<TStateData>::update_phase(
   }
   else if (current_phase == StandardFlightPhase::LAUNCH)
   {
-    if (state_history.size() < 3)
-    {
-      return StandardFlightPhase::LAUNCH;
-    }
-
-    uint8_t missCount = 0;
-    double last_accel = std::numeric_limits<double>::max();
-    for (TStateData state : state_history)
+    // Once the motor stops pushing, the rocket slows down
+    if (velocity_trend.get_consecutive_falls() >= STANDARD_FPC_CONFIRM_SAMPLES)
     {
-      double curr_accel_x, curr_accel_y, curr_accel_z, curr_altitude;
-      extract_state_data(state, curr_accel_x, curr_accel_y, curr_accel_z, curr_altitude);
-      const double curr_accel = sqrt(
-        curr_accel_x * curr_accel_x + curr_accel_y * curr_accel_y + curr_accel_z * curr_accel_z);
-      if (curr_accel < last_accel)
-      {
-        last_accel = curr_accel;
-      }
-      else
-      {
-        missCount++;
-      }
-
-      // Once rocket has had consistently decreasing acceleration (no more than 2 non-decreasing)
-      if (missCount > 2)
-      {
-        return StandardFlightPhase::LAUNCH;
-      }
+      return StandardFlightPhase::COAST;
     }
-
-    return StandardFlightPhase::COAST;
+    return StandardFlightPhase::LAUNCH;
   }
   else if (current_phase == StandardFlightPhase::COAST)
   {
@@ -140,8 +211,8 @@ StandardFlightPhase StandardFlightPhaseController<TStateData>::update_phase(
       max_coast_alt = altitude;
     }
 
-    // Once rocket dropped 50m
-    if (max_coast_alt - altitude > 50)
+    // Once the rocket starts coming down, or dropped 50m if the fused altitude somehow missed that
+    if (altitude_trend.get_consecutive_falls() >= STANDARD_FPC_CONFIRM_SAMPLES || max_coast_alt - altitude > 50)
     {
       return StandardFlightPhase::DESCENT;
     }
@@ -149,27 +220,9 @@ StandardFlightPhase StandardFlightPhaseController<TStateData>::update_phase(
   }
   else if (current_phase == StandardFlightPhase::DESCENT)
   {
-    double minRecentAlt = std::numeric_limits<double>::max();
-    double maxRecentAlt = std::numeric_limits<double>::min();;
-
-    for (TStateData state : state_history)
-    {
-      double curr_accel_x, curr_accel_y, curr_accel_z, curr_altitude;
-      extract_state_data(state, curr_accel_x, curr_accel_y, curr_accel_z, curr_altitude);
-
-      if (curr_altitude < minRecentAlt)
-      {
-        minRecentAlt = curr_altitude;
-      }
-
-      if (curr_altitude > maxRecentAlt)
-      {
-        maxRecentAlt = curr_altitude;
-      }
-    }
-
-    // If recently there is a total deviation of less than 3m
-    if (std::abs(maxRecentAlt - minRecentAlt) <= 3)
+    // Once the rocket has stayed (almost) still for a while
+    if (recent_altitude.is_full() && recent_altitude.get_max() - recent_altitude.get_min() <= STANDARD_FPC_LANDED_SPREAD
+      && std::abs(recent_velocity.get_mean()) < STANDARD_FPC_LANDED_VELOCITY)
     {
       return StandardFlightPhase::LANDED;
     }
@@ -184,9 +237,22 @@ StandardFlightPhase StandardFlightPhaseController<TStateData>::update_phase(
 }
 
 template <typename TStateData>
-StandardFlightPhase StandardFlightPhaseController<TStateData>::predict_phase(StandardFlightPhase last_known_phase,
-                                                                             const std::deque<TStateData>& states) const
+StandardFlightPhase StandardFlightPhaseController<TStateData>::predict_phase(const StandardFlightPhase last_known_phase,
+                                                                             const std::deque<TStateData>&) const
 {
+  // Goes on the prediction update_phase() already made, not the history. Burnout isn't predicted, nothing says how long
+  // the motor burns.
+  constexpr float lead_s = static_cast<float>(STANDARD_FPC_PREDICTION_LEAD_US) / 1e6f;
+  if (last_known_phase == StandardFlightPhase::COAST && prediction.time_to_apogee >= 0 &&
+    prediction.time_to_apogee <= lead_s)
+  {
+    return StandardFlightPhase::DESCENT;
+  }
+  if (last_known_phase == StandardFlightPhase::DESCENT && prediction.time_to_landing >= 0 &&
+    prediction.time_to_landing <= lead_s)
+  {
+    return StandardFlightPhase::LANDED;
+  }
   return last_known_phase;
 }
 
@@ -208,3 +274,135 @@ std::string StandardFlightPhaseController<TStateData>::get_phase_name(StandardFl
   }
   return "Unknown";
 }
+
+template <typename TStateData>
+elijah_state_framework::VerticalEstimate StandardFlightPhaseController<TStateData>::get_vertical_estimate() const
+{
+  return vertical_filter.get_estimate();
+}
+
+template <typename TStateData>
+void StandardFlightPhaseController<TStateData>::update_vertical_estimate(const StandardFlightPhase current_phase,
+                                                                         const double accel_x, const double accel_y,
+                                                                         const double accel_z, const double altitude)
+{
+  const uint64_t now_us = time_us_64();
+  if (last_update_us != 0 && now_us > last_update_us)
+  {
+    vertical_filter.predict(static_cast<float>(now_us - last_update_us) / 1e6f);
+  }
+  last_update_us = now_us;
+
+  vertical_filter.update_altitude(static_cast<float>(altitude));
+
+  const double accel = sqrt(accel_x * accel_x + accel_y * accel_y + accel_z * accel_z);
+  if (current_phase == StandardFlightPhase::PREFLIGHT && accel > 0)
+  {
+    // Only the direction is averaged, so the start of the boost (which is along the same axis) doesn't throw it off
+    const double weight = has_up ? STANDARD_FPC_UP_AVERAGE_WEIGHT : 1;
+    up_x += (accel_x / accel - up_x) * weight;
+    up_y += (accel_y / accel - up_y) * weight;
+    up_z += (accel_z / accel - up_z) * weight;
+
+    const double up_len = sqrt(up_x * up_x + up_y * up_y + up_z * up_z);
+    if (up_len > 0)
+    {
+      up_x /= up_len;
+      up_y /= up_len;
+      up_z /= up_len;
+      has_up = true;
+    }
+  }
+
+  if (current_phase == StandardFlightPhase::DESCENT || current_phase == StandardFlightPhase::LANDED)
+  {
+    // Under the chute, or lying on the ground, the rocket points any which way so the accelerometer can't say which
+    // way is up. Either way it isn't speeding up or slowing down, which keeps the barometer's noise out of the velocity.
+    vertical_filter.update_acceleration(0);
+  }
+  else if (has_up)
+  {
+    const double vertical_accel = accel_x * up_x + accel_y * up_y + accel_z * up_z - GRAVITY_CONSTANT;
+    vertical_filter.update_acceleration(static_cast<float>(vertical_accel));
+  }
+}
+
+template <typename TStateData>
+elijah_state_framework::FlightPrediction StandardFlightPhaseController<TStateData>::get_flight_prediction() const
+{
+  return prediction;
+}
+
+template <typename TStateData>
+void StandardFlightPhaseController<TStateData>::update_prediction(const StandardFlightPhase current_phase,
+                                                                  const double altitude)
+{
+  const elijah_state_framework::VerticalEstimate estimate = vertical_filter.get_estimate();
+  const double velocity = estimate.velocity;
+
+  switch (current_phase)
+  {
+  case StandardFlightPhase::PREFLIGHT:
+    pad_altitude.push(last_update_us, altitude);
+    prediction = {-1, -1, -1};
+    return;
+  case StandardFlightPhase::LANDED:
+    prediction = {0, prediction.apogee_altitude, 0};
+    return;
+  case StandardFlightPhase::COAST:
+    // a = -g - k v^2 on the way up
+    if (velocity > STANDARD_FPC_DRAG_FIT_MIN_VELOCITY)
+    {
+      drag_fit.push(last_update_us, (-estimate.acceleration - GRAVITY_CONSTANT) / (velocity * velocity));
+    }
+    break;
+  default:
+    break;
+  }
+
+  const double ground = pad_altitude.size() > 0 ? pad_altitude.get_mean() : estimate.altitude;
+
+  if (current_phase == StandardFlightPhase::DESCENT)
+  {
+    if (descent_start_us == 0)
+    {
+      descent_start_us = last_update_us;
+    }
+
+    // How far the barometer dropped over the window, once the whole window is from the descent. The fused velocity lags
+    // here, the accelerometer is only saying the rocket isn't speeding up.
+    constexpr double window_s = static_cast<double>(STANDARD_FPC_LANDED_HOLD_US) / 1e6;
+    const double measured_rate = (recent_altitude.get_max() - recent_altitude.get_min()) / window_s;
+    const double descent_rate = last_update_us - descent_start_us >= STANDARD_FPC_LANDED_HOLD_US &&
+                                measured_rate > STANDARD_FPC_LANDED_VELOCITY
+                                  ? measured_rate
+                                  : STANDARD_FPC_EXPECTED_DESCENT_RATE;
+    prediction.time_to_apogee = 0;
+    prediction.time_to_landing = static_cast<float>(std::max(estimate.altitude - ground, 0.0) / descent_rate);
+    return;
+  }
+
+  // During the boost this is as if the motor stopped right now, so it's the soonest apogee could be
+  double time_to_apogee = 0, apogee_gain = 0;
+  if (velocity > 0)
+  {
+    const double drag = drag_fit.size() > 0 ? std::max(drag_fit.get_mean(), 0.0) : 0;
+    if (drag * velocity * velocity > 1e-6 * GRAVITY_CONSTANT)
+    {
+      // Closed form for rising against gravity and quadratic drag
+      time_to_apogee = atan(velocity * sqrt(drag / GRAVITY_CONSTANT)) / sqrt(GRAVITY_CONSTANT * drag);
+      apogee_gain = log1p(drag * velocity * velocity / GRAVITY_CONSTANT) / (2 * drag);
+    }
+    else
+    {
+      time_to_apogee = velocity / GRAVITY_CONSTANT;
+      apogee_gain = velocity * velocity / (2 * GRAVITY_CONSTANT);
+    }
+  }
+
+  const double apogee_altitude = estimate.altitude + apogee_gain;
+  prediction = {
+    static_cast<float>(time_to_apogee), static_cast<float>(apogee_altitude),
+    static_cast<float>(time_to_apogee + std::max(apogee_altitude - ground, 0.0) / STANDARD_FPC_EXPECTED_DESCENT_RATE)
+  };
+}
@@ -14,6 +14,12 @@ from framework.registered_command import RegisteredCommand, CommandInputType
 from framework.variable_definition import VariableDefinition
 
 
+# Every state starts with _sequence and _us_since_boot, a batch only sends them once (see state_batcher.h)
+STATE_HEADER_SIZE = 16
+STATE_BATCH_HEADER_SIZE = 1 + 2 * 8
+STATE_BATCH_DELTA_SIZE = 2 + 4
+
+
 class OutputPacket(Enum):
     LOG_MESSAGE = 1
     STATE_UPDATE = 2
@@ -22,6 +28,7 @@ class OutputPacket(Enum):
     DEVICE_RESTART_MARKER = 5,
     FAULTS_CHANGED = 6
     PHASE_CHANGED = 7
+    STATE_BATCH = 10
 
 
 class MetadataSegment(Enum):
@@ -142,6 +149,8 @@ class StateFramework:
                         self.log(log_level, log_message)
                     case OutputPacket.STATE_UPDATE:
                         self.state_updated(readable)
+                    case OutputPacket.STATE_BATCH:
+                        self.state_batch_received(readable)
                     case OutputPacket.PERSISTENT_STATE_UPDATE:
                         self._update_persistent_data(readable)
                     case OutputPacket.DEVICE_RESTART_MARKER:
@@ -160,7 +169,20 @@ class StateFramework:
         return packets_read
 
     def state_updated(self, readable: Readable):
-        data = readable.read(self.total_data_len)
+        self._decode_state(readable.read(self.total_data_len))
+
+    # Several states in one packet, see state_batcher.h. _sequence and _us_since_boot are only sent in full for the
+    # first state, the rest carry how far they are from the state before.
+    def state_batch_received(self, readable: Readable):
+        state_count, seq, us_since_boot = struct.unpack('<BQQ', readable.read(STATE_BATCH_HEADER_SIZE))
+        for _ in range(state_count):
+            seq_delta, us_delta = struct.unpack('<HI', readable.read(STATE_BATCH_DELTA_SIZE))
+            seq += seq_delta
+            us_since_boot += us_delta
+            rest = readable.read(self.total_data_len - STATE_HEADER_SIZE)
+            self._decode_state(struct.pack('<QQ', seq, us_since_boot) + rest)
+
+    def _decode_state(self, data: bytes):
         for var_def in self.variable_definitions:
             if var_def.data_type != DataType.TIME:
                 var_size = get_data_type_size(var_def.data_type)
@@ -0,0 +1,133 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "afsk_modulator.h"
+#include "afsk_transmitter.h"
+#include "host_test.h"
+
+namespace
+{
+  constexpr size_t symbol_count = 4000;
+  // Odd, so symbols and tone cycles both get split across fill() calls
+  constexpr size_t chunk_samples = 37;
+
+  std::vector<uint8_t> make_symbols()
+  {
+    // Random, apart from a long run of each tone in the middle
+    std::vector<uint8_t> symbols((symbol_count + 7) / 8);
+    uint32_t state = 0x12345678;
+    for (uint8_t& byte : symbols)
+    {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      byte = static_cast<uint8_t>(state);
+    }
+    for (size_t i = 1000; i < 1032; i++)
+    {
+      symbols[i / 8] = 0xFF;
+      symbols[i / 8 + 4] = 0x00;
+    }
+    return symbols;
+  }
+
+  bool get_symbol(const std::vector<uint8_t>& symbols, const size_t idx)
+  {
+    return symbols[idx >> 3] >> (idx & 7) & 1;
+  }
+
+  // How much of freq_hz there is in samples [start, end), what a receiver's mark and space filters measure
+  double get_tone_energy(const std::vector<double>& samples, const size_t start, const size_t end,
+                         const uint32_t freq_hz, const uint32_t sample_rate_hz)
+  {
+    double i_sum = 0, q_sum = 0;
+    for (size_t n = start; n < end; n++)
+    {
+      const double angle = 2 * M_PI * freq_hz * static_cast<double>(n) / sample_rate_hz;
+      i_sum += samples[n] * cos(angle);
+      q_sum += samples[n] * sin(angle);
+    }
+    return i_sum * i_sum + q_sum * q_sum;
+  }
+
+  void test_demodulates(const uint32_t sample_rate_hz)
+  {
+    const std::vector<uint8_t> symbols = make_symbols();
+    AfskModulator modulator(sample_rate_hz, AFSK_PWM_TOP);
+    modulator.start(symbols.data(), symbol_count);
+
+    std::vector<uint16_t> raw;
+    size_t symbol_samples = 0;
+    uint16_t chunk[chunk_samples];
+    while (!modulator.is_done())
+    {
+      symbol_samples += modulator.fill(chunk, chunk_samples);
+      raw.insert(raw.end(), chunk, chunk + chunk_samples);
+    }
+
+    // The symbol clock has to average out to exactly AFSK_BAUD, whatever the rate
+    const double expected_samples = static_cast<double>(symbol_count) * sample_rate_hz / AFSK_BAUD;
+    CHECK(fabs(static_cast<double>(symbol_samples) - expected_samples) <= 1);
+
+    // The tone never resets, so no two samples are further apart than the space tone can move in one, give or take a
+    // sine table step either side
+    const double amplitude = static_cast<double>(AFSK_PWM_TOP) / 2;
+    const double table_step = amplitude * 2 * M_PI / (1 << AFSK_SINE_TABLE_BITS);
+    const double max_change = amplitude * 2 * M_PI * AFSK_SPACE_HZ / sample_rate_hz + 2 * table_step + 1;
+    size_t jumps = 0;
+    for (size_t n = 1; n < symbol_samples; n++)
+    {
+      if (abs(raw[n] - raw[n - 1]) > max_change)
+      {
+        jumps++;
+      }
+    }
+    CHECK(jumps == 0);
+
+    // Silence after the last symbol
+    for (size_t n = symbol_samples; n < raw.size(); n++)
+    {
+      CHECK(raw[n] == modulator.get_centre_level());
+    }
+
+    std::vector<double> samples(raw.size());
+    for (size_t n = 0; n < raw.size(); n++)
+    {
+      samples[n] = raw[n] - amplitude;
+    }
+
+    // Each symbol where an ideal 1200 baud clock puts it, leaving out a sample at each end for the modulator's clock
+    // being up to one sample off
+    size_t symbol_errors = 0;
+    for (size_t i = 0; i < symbol_count; i++)
+    {
+      const auto start = static_cast<size_t>(static_cast<double>(i) * sample_rate_hz / AFSK_BAUD) + 1;
+      const auto end = static_cast<size_t>(static_cast<double>(i + 1) * sample_rate_hz / AFSK_BAUD) - 1;
+      const bool is_mark = get_tone_energy(samples, start, end, AFSK_MARK_HZ, sample_rate_hz) >
+        get_tone_energy(samples, start, end, AFSK_SPACE_HZ, sample_rate_hz);
+      if (is_mark != get_symbol(symbols, i))
+      {
+        symbol_errors++;
+      }
+    }
+    if (symbol_errors > 0)
+    {
+      fprintf(stderr, "%u Hz: %zu of %zu symbols wrong\n", sample_rate_hz, symbol_errors, symbol_count);
+    }
+    CHECK(symbol_errors == 0);
+  }
+}
+
+int main()
+{
+  test_demodulates(AFSK_SAMPLE_RATE_HZ);
+  // What the transmitter's DMA timer actually gets at 200MHz, not a whole number of samples a symbol
+  constexpr uint32_t clk_sys_hz = 200000000;
+  test_demodulates(clk_sys_hz / ((clk_sys_hz + AFSK_SAMPLE_RATE_HZ / 2) / AFSK_SAMPLE_RATE_HZ));
+  test_demodulates(44100);
+  test_demodulates(48000);
+  return finish_host_test("afsk_modulator");
+}
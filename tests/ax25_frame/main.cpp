@@ -0,0 +1,269 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "ax25_frame.h"
+#include "host_test.h"
+
+namespace
+{
+  constexpr size_t preamble_flags = 4;
+  constexpr size_t tail_flags = 2;
+
+  // Bit at a time, nothing shared with the table in ax25_frame.cpp
+  uint16_t update_reference_crc(uint16_t crc, const uint8_t byte)
+  {
+    for (int i = 0; i < 8; i++)
+    {
+      const bool is_set = (crc ^ byte >> i) & 1;
+      crc >>= 1;
+      if (is_set)
+      {
+        crc ^= 0x8408;
+      }
+    }
+    return crc;
+  }
+
+  uint16_t get_reference_crc(const std::vector<uint8_t>& data)
+  {
+    uint16_t crc = 0xFFFF;
+    for (const uint8_t byte : data)
+    {
+      crc = update_reference_crc(crc, byte);
+    }
+    return crc;
+  }
+
+  // What a TNC does with the symbols: undo the NRZI (same tone is a 1), find the flags, drop the stuffed 0 after five 1s
+  // and put the bytes back together lowest bit first. Every frame between two flags, FCS included.
+  struct DecodedSymbols
+  {
+    std::vector<std::vector<uint8_t>> frames;
+    size_t flag_count = 0;
+  };
+
+  DecodedSymbols decode_symbols(const uint8_t* symbols, const size_t symbol_count)
+  {
+    DecodedSymbols decoded;
+    std::vector<uint8_t> frame;
+    bool last_tone = true, is_in_frame = false;
+    uint8_t window = 0, byte = 0;
+    int ones_count = 0, bit_count = 0;
+
+    for (size_t i = 0; i < symbol_count; i++)
+    {
+      const bool tone = symbols[i >> 3] >> (i & 7) & 1;
+      const bool bit = tone == last_tone;
+      last_tone = tone;
+
+      window = static_cast<uint8_t>(window >> 1 | bit << 7);
+      if (window == AX25_FLAG)
+      {
+        decoded.flag_count++;
+        // The flag's first seven bits went into the frame before it was recognised
+        if (is_in_frame && bit_count == 7 && !frame.empty())
+        {
+          decoded.frames.push_back(frame);
+        }
+        frame.clear();
+        is_in_frame = true;
+        ones_count = 0;
+        bit_count = 0;
+        continue;
+      }
+      if (!is_in_frame)
+      {
+        continue;
+      }
+
+      if (!bit && ones_count == 5)
+      {
+        ones_count = 0;
+        continue;
+      }
+      ones_count = bit ? ones_count + 1 : 0;
+
+      byte = static_cast<uint8_t>(byte >> 1 | bit << 7);
+      if (++bit_count == 8)
+      {
+        frame.push_back(byte);
+        bit_count = 0;
+      }
+    }
+    return decoded;
+  }
+
+  // The frame as it should go out, built straight from the AX.25 spec. Addresses are given already shifted, with their
+  // SSID byte.
+  std::vector<uint8_t> make_expected_frame(const std::vector<uint8_t>& addresses, const uint8_t* info,
+                                           const size_t info_len)
+  {
+    std::vector<uint8_t> frame = addresses;
+    frame.push_back(AX25_CONTROL_UI);
+    frame.push_back(AX25_PID_NO_LAYER_3);
+    frame.insert(frame.end(), info, info + info_len);
+
+    const uint16_t fcs = ~get_reference_crc(frame);
+    frame.push_back(fcs & 0xFF);
+    frame.push_back(fcs >> 8);
+    return frame;
+  }
+
+  void check_encodes(const ax25::UiFrame& frame, const std::vector<uint8_t>& expected)
+  {
+    uint8_t symbols[AX25_MAX_FRAME_SYMBOLS(AX25_MAX_DIGIPEATERS, AX25_MAX_INFO_LEN, preamble_flags, tail_flags) / 8 + 1];
+    const size_t symbol_count = ax25::encode_ui_frame(frame, symbols, sizeof(symbols) * 8, preamble_flags,
+                                                      tail_flags);
+    CHECK(symbol_count > 0);
+    CHECK(symbol_count <= AX25_MAX_FRAME_SYMBOLS(frame.digipeater_count, frame.info_len, preamble_flags, tail_flags));
+
+    const DecodedSymbols decoded = decode_symbols(symbols, symbol_count);
+    CHECK(decoded.flag_count == preamble_flags + tail_flags);
+    CHECK(decoded.frames.size() == 1);
+    if (decoded.frames.size() != 1)
+    {
+      return;
+    }
+
+    CHECK(decoded.frames[0] == expected);
+    // Running the CRC over the frame and its FCS always leaves the same residue
+    CHECK(get_reference_crc(decoded.frames[0]) == 0xF0B8);
+  }
+
+  void test_fcs()
+  {
+    constexpr uint8_t check_input[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    CHECK(ax25::fcs(check_input, sizeof(check_input)) == 0x906E);
+    CHECK(ax25::fcs(nullptr, 0) == 0x0000);
+  }
+
+  void test_frame_via_digipeater()
+  {
+    // KJ7ABC-9>APZELJ,WIDE2-1, with runs of 1s (0x7E and 0xFF) in the info so it has to be stuffed
+    constexpr uint8_t info[] = {'>', 'H', 'i', ' ', 0x7E, 0x7E, ' ', 0xFF, 0xFF, ' ', 'o', 'k'};
+    const std::vector<uint8_t> addresses = {
+      0x82, 0xA0, 0xB4, 0x8A, 0x98, 0x94, 0xE0, // APZELJ-0, command bit set
+      0x96, 0x94, 0x6E, 0x82, 0x84, 0x86, 0x72, // KJ7ABC-9
+      0xAE, 0x92, 0x88, 0x8A, 0x64, 0x40, 0x63, // WIDE2-1, last address
+    };
+
+    constexpr ax25::Address digipeater = {"WIDE2", 1};
+    check_encodes({
+                    .destination = {"APZELJ", 0}, .source = {"KJ7ABC", 9}, .digipeaters = &digipeater,
+                    .digipeater_count = 1, .info = info, .info_len = sizeof(info)
+                  }, make_expected_frame(addresses, info, sizeof(info)));
+  }
+
+  void test_frame_without_digipeaters()
+  {
+    // N0CALL-15>APRS, a position report
+    constexpr char info[] = "!4903.50N/07201.75W-";
+    const std::vector<uint8_t> addresses = {
+      0x82, 0xA0, 0xA4, 0xA6, 0x40, 0x40, 0xE0, // APRS-0, padded
+      0x9C, 0x60, 0x86, 0x82, 0x98, 0x98, 0x7F, // N0CALL-15, last address
+    };
+
+    const auto* info_bytes = reinterpret_cast<const uint8_t*>(info);
+    check_encodes({
+                    .destination = {"APRS", 0}, .source = {"N0CALL", 15}, .digipeaters = nullptr,
+                    .digipeater_count = 0, .info = info_bytes, .info_len = sizeof(info) - 1
+                  }, make_expected_frame(addresses, info_bytes, sizeof(info) - 1));
+  }
+
+  void test_longest_frame()
+  {
+    uint8_t info[AX25_MAX_INFO_LEN];
+    memset(info, 0xFF, sizeof(info));
+    const std::vector<uint8_t> addresses = {
+      0x82, 0xA0, 0xA4, 0xA6, 0x40, 0x40, 0xE0,
+      0x9C, 0x60, 0x86, 0x82, 0x98, 0x98, 0x61,
+    };
+
+    check_encodes({
+                    .destination = {"APRS", 0}, .source = {"N0CALL", 0}, .digipeaters = nullptr,
+                    .digipeater_count = 0, .info = info, .info_len = sizeof(info)
+                  }, make_expected_frame(addresses, info, sizeof(info)));
+  }
+
+  void test_rejects_invalid()
+  {
+    uint8_t symbols[AX25_MAX_FRAME_SYMBOLS(AX25_MAX_DIGIPEATERS + 1, AX25_MAX_INFO_LEN + 1, AX25_PREAMBLE_FLAGS,
+                                           AX25_TAIL_FLAGS) / 8 + 1];
+    constexpr size_t capacity = sizeof(symbols) * 8;
+    uint8_t info[AX25_MAX_INFO_LEN + 1] = {};
+    const ax25::UiFrame valid = {
+      .destination = {"APRS", 0}, .source = {"N0CALL", 0}, .digipeaters = nullptr, .digipeater_count = 0,
+      .info = info, .info_len = 10
+    };
+    CHECK(ax25::encode_ui_frame(valid, symbols, capacity) > 0);
+
+    for (const char* callsign : {"n0call", "N0-CAL", "", "N0CALLS", static_cast<const char*>(nullptr)})
+    {
+      ax25::UiFrame frame = valid;
+      frame.source.callsign = callsign;
+      CHECK(ax25::encode_ui_frame(frame, symbols, capacity) == 0);
+    }
+
+    ax25::UiFrame frame = valid;
+    frame.destination.ssid = 16;
+    CHECK(ax25::encode_ui_frame(frame, symbols, capacity) == 0);
+
+    frame = valid;
+    frame.info_len = AX25_MAX_INFO_LEN + 1;
+    CHECK(ax25::encode_ui_frame(frame, symbols, capacity) == 0);
+
+    frame = valid;
+    frame.info = nullptr;
+    CHECK(ax25::encode_ui_frame(frame, symbols, capacity) == 0);
+
+    ax25::Address digipeaters[AX25_MAX_DIGIPEATERS + 1];
+    for (ax25::Address& digipeater : digipeaters)
+    {
+      digipeater = {"WIDE1", 1};
+    }
+    frame = valid;
+    frame.digipeaters = digipeaters;
+    frame.digipeater_count = AX25_MAX_DIGIPEATERS + 1;
+    CHECK(ax25::encode_ui_frame(frame, symbols, capacity) == 0);
+
+    frame.digipeater_count = 2;
+    digipeaters[1].ssid = 16;
+    CHECK(ax25::encode_ui_frame(frame, symbols, capacity) == 0);
+  }
+
+  void test_capacity()
+  {
+    constexpr char info[] = ">capacity";
+    const ax25::UiFrame frame = {
+      .destination = {"APRS", 0}, .source = {"N0CALL", 0}, .digipeaters = nullptr, .digipeater_count = 0,
+      .info = reinterpret_cast<const uint8_t*>(info), .info_len = sizeof(info) - 1
+    };
+
+    uint8_t symbols[128];
+    const size_t symbol_count = ax25::encode_ui_frame(frame, symbols, sizeof(symbols) * 8, preamble_flags, tail_flags);
+    CHECK(symbol_count > 0);
+
+    // Exactly enough room is fine, one symbol less isn't, and nothing past the capacity is touched
+    CHECK(ax25::encode_ui_frame(frame, symbols, symbol_count, preamble_flags, tail_flags) == symbol_count);
+
+    memset(symbols, 0xA5, sizeof(symbols));
+    CHECK(ax25::encode_ui_frame(frame, symbols, symbol_count - 1, preamble_flags, tail_flags) == 0);
+    CHECK(ax25::encode_ui_frame(frame, symbols, 0, preamble_flags, tail_flags) == 0);
+    for (size_t i = (symbol_count + 7) / 8; i < sizeof(symbols); i++)
+    {
+      CHECK(symbols[i] == 0xA5);
+    }
+  }
+}
+
+int main()
+{
+  test_fcs();
+  test_frame_via_digipeater();
+  test_frame_without_digipeaters();
+  test_longest_frame();
+  test_rejects_invalid();
+  test_capacity();
+  return finish_host_test("ax25_frame");
+}
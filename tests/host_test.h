@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdio>
+
+// Host tests are plain executables run by ctest. A failed CHECK prints where it was and carries on, so one run shows
+// everything that's wrong, and the test exits non-zero at the end.
+inline int host_test_failures = 0;
+
+#define CHECK(COND)                                                                   \
+  do                                                                                  \
+  {                                                                                   \
+    if (!(COND))                                                                      \
+    {                                                                                 \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #COND);       \
+      host_test_failures++;                                                           \
+    }                                                                                 \
+  }                                                                                   \
+  while (0)
+
+inline int finish_host_test(const char* name)
+{
+  if (host_test_failures > 0)
+  {
+    fprintf(stderr, "%s: %d check(s) failed\n", name, host_test_failures);
+    return 1;
+  }
+
+  printf("%s: passed\n", name);
+  return 0;
+}
@@ -0,0 +1,210 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "seqlock.h"
+#include "shared_mutex.h"
+
+namespace
+{
+  constexpr int reader_threads = 4;
+  constexpr int writer_threads = 2;
+  constexpr uint32_t writes_per_writer = 50000;
+
+  // Two copies of the same count, a reader that ever sees them differ got in while a writer was half way through
+  struct Counter
+  {
+    uint64_t a = 0;
+    uint64_t b = 0;
+  };
+
+  void test_no_lost_updates()
+  {
+    shared_mutex_t s_mtx;
+    shared_mutex_init(&s_mtx);
+    Counter counter;
+    std::atomic<bool> is_done = false;
+    std::atomic<uint64_t> torn_reads = 0, reads = 0;
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < reader_threads; i++)
+    {
+      readers.emplace_back([&]
+      {
+        while (!is_done.load())
+        {
+          shared_mutex_enter_blocking_shared(&s_mtx);
+          if (counter.a != counter.b)
+          {
+            ++torn_reads;
+          }
+          shared_mutex_exit_shared(&s_mtx);
+          ++reads;
+        }
+      });
+    }
+
+    std::vector<std::thread> writers;
+    for (int i = 0; i < writer_threads; i++)
+    {
+      writers.emplace_back([&]
+      {
+        for (uint32_t j = 0; j < writes_per_writer; j++)
+        {
+          shared_mutex_enter_blocking_exclusive(&s_mtx);
+          counter.a++;
+          counter.b++;
+          shared_mutex_exit_exclusive(&s_mtx);
+        }
+      });
+    }
+
+    for (auto& writer : writers)
+    {
+      writer.join();
+    }
+    is_done = true;
+    for (auto& reader : readers)
+    {
+      reader.join();
+    }
+
+    CHECK(counter.a == writer_threads * writes_per_writer);
+    CHECK(counter.b == writer_threads * writes_per_writer);
+    CHECK(torn_reads == 0);
+    CHECK(reads > 0);
+
+    shared_mutex_stats_t stats;
+    shared_mutex_get_stats(&s_mtx, &stats);
+    CHECK(stats.exclusive_acquires == writer_threads * writes_per_writer);
+    CHECK(stats.shared_acquires == reads);
+    CHECK(s_mtx.reader_count == 0);
+    CHECK(s_mtx.writers_waiting == 0);
+    CHECK(!s_mtx.writer_active);
+  }
+
+  // A reader holds the lock, a writer queues behind it, then a second reader arrives. The second reader has to wait
+  // for the writer even though the lock is only held shared.
+  void test_writer_preference()
+  {
+    shared_mutex_t s_mtx;
+    shared_mutex_init(&s_mtx);
+    std::atomic<int> order = 0;
+    std::atomic<int> writer_order = -1, late_reader_order = -1;
+
+    shared_mutex_enter_blocking_shared(&s_mtx);
+
+    std::thread writer([&]
+    {
+      shared_mutex_enter_blocking_exclusive(&s_mtx);
+      writer_order = order++;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      shared_mutex_exit_exclusive(&s_mtx);
+    });
+
+    while (__atomic_load_n(&s_mtx.writers_waiting, __ATOMIC_ACQUIRE) == 0)
+    {
+      std::this_thread::yield();
+    }
+
+    std::thread late_reader([&]
+    {
+      shared_mutex_enter_blocking_shared(&s_mtx);
+      late_reader_order = order++;
+      shared_mutex_exit_shared(&s_mtx);
+    });
+
+    // Long enough for the late reader to have got in if it was going to
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(late_reader_order == -1);
+    CHECK(writer_order == -1);
+
+    shared_mutex_exit_shared(&s_mtx);
+    writer.join();
+    late_reader.join();
+
+    CHECK(writer_order == 0);
+    CHECK(late_reader_order == 1);
+  }
+
+  // Every word is the same number, so a copy taken while a write was part way through shows up as a mix
+  struct Payload
+  {
+    uint64_t words[32];
+  };
+
+  void test_seqlock_no_torn_reads()
+  {
+    seqlock_t seq_lck;
+    seqlock_init(&seq_lck);
+    Payload shared_payload{};
+    std::atomic<bool> is_done = false;
+    std::atomic<uint64_t> torn_reads = 0, backwards_reads = 0, reads = 0;
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < reader_threads; i++)
+    {
+      readers.emplace_back([&]
+      {
+        uint64_t last_value = 0;
+        while (!is_done.load())
+        {
+          Payload copy;
+          seqlock_read(&seq_lck, &copy, &shared_payload, sizeof(Payload));
+          for (const uint64_t word : copy.words)
+          {
+            if (word != copy.words[0])
+            {
+              ++torn_reads;
+              break;
+            }
+          }
+          // Only one writer here, so what a reader sees never goes back
+          if (copy.words[0] < last_value)
+          {
+            ++backwards_reads;
+          }
+          last_value = copy.words[0];
+          ++reads;
+        }
+      });
+    }
+
+    std::thread writer([&]
+    {
+      for (uint64_t value = 1; value <= writes_per_writer; value++)
+      {
+        Payload payload;
+        for (uint64_t& word : payload.words)
+        {
+          word = value;
+        }
+        seqlock_write(&seq_lck, &shared_payload, &payload, sizeof(Payload));
+      }
+    });
+
+    writer.join();
+    is_done = true;
+    for (auto& reader : readers)
+    {
+      reader.join();
+    }
+
+    CHECK(torn_reads == 0);
+    CHECK(backwards_reads == 0);
+    CHECK(reads > 0);
+    CHECK(shared_payload.words[0] == writes_per_writer);
+    CHECK(seq_lck.sequence == 2 * writes_per_writer);
+  }
+}
+
+int main()
+{
+  test_no_lost_updates();
+  test_writer_preference();
+  test_seqlock_no_torn_reads();
+  return finish_host_test("shared_mutex");
+}
@@ -0,0 +1,123 @@
+#include "column_exporter.h"
+
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+using namespace elijah_state_framework::log_reader;
+
+ColumnExporter::ColumnExporter(FILE* file) : file(file)
+{
+}
+
+bool ColumnExporter::begin(const LogMetadata& metadata, std::string&)
+{
+  // Nothing is written until finish(), so there's nothing here or in add_row() that can fail
+  constexpr size_t no_offset = std::numeric_limits<size_t>::max();
+  columns = {
+    {"boot", "", DataType::UInt32, sizeof(uint32_t), no_offset, false, {}},
+    {"phase", "", DataType::Uint8, sizeof(uint8_t), no_offset, false, {}},
+    {"faults", "", DataType::UInt32, sizeof(uint32_t), no_offset, false, {}}
+  };
+
+  for (const LoggedVariable& variable : metadata.variables)
+  {
+    const bool is_time = variable.data_type == DataType::Time;
+    columns.push_back({
+      variable.display_name, is_time ? "" : variable.display_unit, is_time ? DataType::Int64 : variable.data_type,
+      is_time ? sizeof(int64_t) : data_type_helpers::get_size_for_data_type(variable.data_type), variable.data_offset,
+      is_time, {}
+    });
+  }
+
+  return true;
+}
+
+bool ColumnExporter::add_row(const ExportRow& row, const std::span<const uint8_t> state, std::string&)
+{
+  append(columns[0], row.boot);
+  append(columns[1], row.phase);
+  append(columns[2], row.faults);
+
+  for (size_t i = 3; i < columns.size(); i++)
+  {
+    Column& column = columns[i];
+    if (column.is_time)
+    {
+      const LoggedVariable variable{0, column.name, "", column.data_offset, DataType::Time};
+      tm time_inst = get_time_value(variable, state.data());
+      append(column, static_cast<int64_t>(timegm(&time_inst)));
+      continue;
+    }
+
+    const uint8_t* value_ptr = state.data() + column.data_offset;
+    column.values.insert(column.values.end(), value_ptr, value_ptr + column.value_size);
+  }
+
+  row_count++;
+  return true;
+}
+
+bool ColumnExporter::finish(std::string& error)
+{
+  std::vector<uint8_t> header(COLUMN_EXPORTER_MAGIC, COLUMN_EXPORTER_MAGIC + 8);
+  const auto append_header = [&header](const void* value, const size_t len)
+  {
+    header.insert(header.end(), static_cast<const uint8_t*>(value), static_cast<const uint8_t*>(value) + len);
+  };
+
+  const auto column_count = static_cast<uint32_t>(columns.size());
+  append_header(&column_count, sizeof(column_count));
+  append_header(&row_count, sizeof(row_count));
+
+  // Offsets depend on the header's size, so leave room for them and fill them in after
+  std::vector<size_t> offset_positions;
+  for (const Column& column : columns)
+  {
+    const auto data_type = static_cast<uint8_t>(column.data_type);
+    append_header(&data_type, sizeof(data_type));
+    append_header(column.name.c_str(), column.name.size() + 1);
+    append_header(column.unit.c_str(), column.unit.size() + 1);
+
+    offset_positions.push_back(header.size());
+    header.resize(header.size() + sizeof(uint64_t));
+  }
+
+  const auto align = [](const uint64_t offset)
+  {
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+  };
+
+  uint64_t offset = align(header.size());
+  for (size_t i = 0; i < columns.size(); i++)
+  {
+    memcpy(header.data() + offset_positions[i], &offset, sizeof(offset));
+    offset = align(offset + columns[i].values.size());
+  }
+
+  constexpr uint8_t padding[8] = {};
+  bool success = fwrite(header.data(), 1, header.size(), file) == header.size();
+  uint64_t written = header.size();
+  for (const Column& column : columns)
+  {
+    success = success && fwrite(padding, 1, align(written) - written, file) == align(written) - written;
+    written = align(written);
+
+    success = success && fwrite(column.values.data(), 1, column.values.size(), file) == column.values.size();
+    written += column.values.size();
+  }
+
+  if (!success || fflush(file) != 0)
+  {
+    error = "Failed to write columns";
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+void ColumnExporter::append(Column& column, const T value)
+{
+  const auto value_ptr = reinterpret_cast<const uint8_t*>(&value);
+  column.values.insert(column.values.end(), value_ptr, value_ptr + sizeof(T));
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "log_exporter.h"
+
+#define COLUMN_EXPORTER_MAGIC "ELJCOL01"
+
+/**
+ * Writes each column contiguously, so a column can be loaded straight into an array (numpy.frombuffer, etc.) without
+ * reading the rest of the file. Everything is little endian:
+ *
+ *   char[8]   "ELJCOL01"
+ *   uint32    column count
+ *   uint64    row count
+ *   for each column:
+ *     uint8   DataType, Time columns are stored as Int64 seconds since the epoch (UTC)
+ *     char[]  name, null terminated
+ *     char[]  unit, null terminated
+ *     uint64  offset of the column's values from the start of the file, always a multiple of 8
+ *   column values, row count of each column's type
+ *
+ * The first three columns are always boot (UInt32), phase (Uint8) and faults (UInt32), then every logged variable.
+ */
+class ColumnExporter final : public LogExporter
+{
+public:
+  explicit ColumnExporter(FILE* file);
+
+  bool begin(const elijah_state_framework::log_reader::LogMetadata& metadata, std::string& error) override;
+  bool add_row(const ExportRow& row, std::span<const uint8_t> state, std::string& error) override;
+  bool finish(std::string& error) override;
+
+private:
+  struct Column
+  {
+    std::string name;
+    std::string unit;
+    DataType data_type;
+    size_t value_size;
+
+    // Offset in the state, or SIZE_MAX for the columns that aren't logged variables
+    size_t data_offset;
+    bool is_time;
+
+    std::vector<uint8_t> values;
+  };
+
+  FILE* file;
+  std::vector<Column> columns;
+  uint64_t row_count = 0;
+
+  template <typename T>
+  static void append(Column& column, T value);
+};
@@ -0,0 +1,136 @@
+#include "csv_exporter.h"
+
+#include <charconv>
+#include <cstring>
+
+using namespace elijah_state_framework::log_reader;
+
+CsvExporter::CsvExporter(FILE* file) : file(file)
+{
+  buffer.reserve(CSV_EXPORTER_FLUSH_SIZE + 4096);
+}
+
+bool CsvExporter::begin(const LogMetadata& metadata, std::string& error)
+{
+  variables = metadata.variables;
+
+  buffer += "boot,phase,faults";
+  for (const LoggedVariable& variable : variables)
+  {
+    buffer += ',';
+    append_quoted(variable.display_unit.empty() || variable.data_type == DataType::Time
+                    ? variable.display_name
+                    : variable.display_name + " (" + variable.display_unit + ")");
+  }
+  buffer += '\n';
+
+  return write_buffer(error);
+}
+
+bool CsvExporter::add_row(const ExportRow& row, const std::span<const uint8_t> state, std::string& error)
+{
+  append_number(row.boot);
+  buffer += ',';
+  append_number(row.phase);
+  buffer += ',';
+  append_number(row.faults);
+
+  for (const LoggedVariable& variable : variables)
+  {
+    buffer += ',';
+    append_value(variable, state.data());
+  }
+  buffer += '\n';
+
+  return buffer.size() < CSV_EXPORTER_FLUSH_SIZE || write_buffer(error);
+}
+
+bool CsvExporter::finish(std::string& error)
+{
+  if (!write_buffer(error))
+  {
+    return false;
+  }
+
+  if (fflush(file) != 0)
+  {
+    error = "Failed to write CSV";
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+void CsvExporter::append_number(const T value)
+{
+  // Shortest representation that reads back as the same value, much faster than printf's %.17g
+  char formatted[32];
+  const std::to_chars_result result = std::to_chars(formatted, formatted + sizeof(formatted), value);
+  buffer.append(formatted, result.ptr);
+}
+
+void CsvExporter::append_value(const LoggedVariable& variable, const uint8_t* state_data)
+{
+  const uint8_t* value_ptr = state_data + variable.data_offset;
+
+#define CSV_EXPORTER_APPEND_AS(TYPE_NAME) \
+  { \
+    TYPE_NAME value; \
+    memcpy(&value, value_ptr, sizeof(TYPE_NAME)); \
+    append_number(value); \
+    return; \
+  }
+
+  switch (variable.data_type)
+  {
+  case DataType::Int8: CSV_EXPORTER_APPEND_AS(int8_t)
+  case DataType::Uint8: CSV_EXPORTER_APPEND_AS(uint8_t)
+  case DataType::Int16: CSV_EXPORTER_APPEND_AS(int16_t)
+  case DataType::UInt16: CSV_EXPORTER_APPEND_AS(uint16_t)
+  case DataType::Int32: CSV_EXPORTER_APPEND_AS(int32_t)
+  case DataType::UInt32: CSV_EXPORTER_APPEND_AS(uint32_t)
+  case DataType::Int64: CSV_EXPORTER_APPEND_AS(int64_t)
+  case DataType::UInt64: CSV_EXPORTER_APPEND_AS(uint64_t)
+  case DataType::Float: CSV_EXPORTER_APPEND_AS(float)
+  case DataType::Double: CSV_EXPORTER_APPEND_AS(double)
+  case DataType::Time:
+    buffer += format_value(variable, state_data);
+    return;
+  case DataType::String:
+    break;
+  }
+
+#undef CSV_EXPORTER_APPEND_AS
+}
+
+void CsvExporter::append_quoted(const std::string& value)
+{
+  if (value.find_first_of(",\"\n") == std::string::npos)
+  {
+    buffer += value;
+    return;
+  }
+
+  buffer += '"';
+  for (const char c : value)
+  {
+    if (c == '"')
+    {
+      buffer += '"';
+    }
+    buffer += c;
+  }
+  buffer += '"';
+}
+
+bool CsvExporter::write_buffer(std::string& error)
+{
+  if (!buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+  {
+    error = "Failed to write CSV";
+    return false;
+  }
+
+  buffer.clear();
+  return true;
+}
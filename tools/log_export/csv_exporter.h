@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "log_exporter.h"
+
+// Rows are built in memory and written out in large blocks, formatting is what limits the speed, not the file
+#define CSV_EXPORTER_FLUSH_SIZE (1 << 20)
+
+class CsvExporter final : public LogExporter
+{
+public:
+  explicit CsvExporter(FILE* file);
+
+  bool begin(const elijah_state_framework::log_reader::LogMetadata& metadata, std::string& error) override;
+  bool add_row(const ExportRow& row, std::span<const uint8_t> state, std::string& error) override;
+  bool finish(std::string& error) override;
+
+private:
+  FILE* file;
+  std::vector<elijah_state_framework::log_reader::LoggedVariable> variables;
+  std::string buffer;
+
+  template <typename T>
+  void append_number(T value);
+  void append_value(const elijah_state_framework::log_reader::LoggedVariable& variable, const uint8_t* state_data);
+  void append_quoted(const std::string& value);
+  bool write_buffer(std::string& error);
+};
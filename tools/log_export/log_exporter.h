@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "log_reader.h"
+
+// Everything a row has besides the logged state, tracked from the packets around it
+struct ExportRow
+{
+  // Restart markers seen so far, _sequence and _us_since_boot both start over after every restart
+  uint32_t boot;
+  uint8_t phase;
+  uint32_t faults;
+};
+
+// Gets the metadata once, then every state in the log in order
+class LogExporter
+{
+public:
+  virtual ~LogExporter() = default;
+
+  virtual bool begin(const elijah_state_framework::log_reader::LogMetadata& metadata, std::string& error) = 0;
+  virtual bool add_row(const ExportRow& row, std::span<const uint8_t> state, std::string& error) = 0;
+  virtual bool finish(std::string& error) = 0;
+};
@@ -0,0 +1,552 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "column_exporter.h"
+#include "csv_exporter.h"
+#include "log_reader.h"
+
+using namespace elijah_state_framework::log_reader;
+
+namespace
+{
+  struct ExportSummary
+  {
+    uint64_t packets = 0;
+    uint64_t states = 0;
+    uint64_t restarts = 0;
+    uint64_t messages = 0;
+    uint64_t phase_changes = 0;
+    uint64_t fault_changes = 0;
+  };
+
+  // Only export part of the log, found through its index
+  struct ExportWindow
+  {
+    bool has_boot = false;
+    uint32_t boot = 0;
+    bool has_phase = false;
+    uint8_t phase = 0;
+    bool has_time = false;
+    uint64_t from_us = 0;
+    uint64_t to_us = UINT64_MAX;
+
+    [[nodiscard]] bool is_set() const
+    {
+      return has_boot || has_phase || has_time;
+    }
+
+    [[nodiscard]] bool contains(const ExportRow& row, const uint64_t us_since_boot) const
+    {
+      return (!has_phase || row.phase == phase) && (!has_time || (us_since_boot >= from_us && us_since_boot <= to_us));
+    }
+  };
+
+  void print_usage(const char* program_name)
+  {
+    fprintf(stderr, "Usage: %s <log file>... [--csv <file>] [--columns <file>] [--messages] [--boot <n>]\n"
+            "         [--phase <id>] [--from <s>] [--to <s>] [--vars <name,...>]\n"
+            "  Pass every segment of a launch (launch-xxxx.000, .001, ...) in order to export all of them as one, or\n"
+            "  just one to export it on its own\n"
+            "  --csv       File every state is written to as CSV\n"
+            "  --columns   File every state is written to as columnar binary (layout in column_exporter.h)\n"
+            "  --messages  Print the log messages as they're decoded\n"
+            "  --boot      Only export this boot (counted from 0), the first one by default with --from/--to\n"
+            "  --phase     Only export states in this flight phase, from the first boot it shows up in\n"
+            "  --from/--to Only export states between these many seconds since boot\n"
+            "  --vars      Only export these variables, by display name\n"
+            "Without --csv or --columns the log is only decoded and summarized. --boot, --phase, --from and --to use\n"
+            "the log's index to skip straight to the states that are wanted. Logs written in column blocks also skip\n"
+            "the blocks outside of --from/--to and the columns not in --vars.\n", program_name);
+  }
+
+  bool is_same_layout(const LogMetadata& a, const LogMetadata& b)
+  {
+    if (a.variables.size() != b.variables.size())
+    {
+      return false;
+    }
+
+    for (size_t i = 0; i < a.variables.size(); i++)
+    {
+      if (a.variables[i].display_name != b.variables[i].display_name ||
+        a.variables[i].data_offset != b.variables[i].data_offset ||
+        a.variables[i].data_type != b.variables[i].data_type)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Splits a comma separated list
+  std::vector<std::string> split_names(const char* names)
+  {
+    std::vector<std::string> split;
+    for (const char* start = names;;)
+    {
+      const char* comma = strchr(start, ',');
+      split.emplace_back(start, comma ? comma : start + strlen(start));
+      if (!comma)
+      {
+        return split;
+      }
+      start = comma + 1;
+    }
+  }
+
+  // Finds the range of the file the window's states are in, entries are in file order
+  bool find_window(const std::vector<LogIndexEntry>& entries, const ExportWindow& window, size_t& start_entry,
+                   size_t& end_entry)
+  {
+    const auto in_boot = [](const uint32_t boot)
+    {
+      return [boot](const LogIndexEntry& entry) { return entry.boot == boot; };
+    };
+
+    // Without a boot, a phase is looked for in every boot, and a time is in the first one
+    auto start = window.has_boot || !window.has_phase
+                   ? std::ranges::find_if(entries, in_boot(window.boot))
+                   : entries.begin();
+    auto search_end = window.has_boot ? std::find_if_not(start, entries.end(), in_boot(window.boot)) : entries.end();
+
+    if (window.has_phase)
+    {
+      start = std::find_if(start, search_end, [&](const LogIndexEntry& entry)
+      {
+        return entry.phase == window.phase;
+      });
+    }
+
+    if (start == search_end)
+    {
+      return false;
+    }
+    const auto boot_end = std::find_if_not(start, entries.end(), in_boot(start->boot));
+
+    if (window.has_time)
+    {
+      // Time only goes forward within a boot, so the last entry at or before --from is where to start
+      const auto after_from = std::upper_bound(start, boot_end, window.from_us,
+                                               [](const uint64_t us, const LogIndexEntry& entry)
+                                               {
+                                                 return us < entry.us_since_boot;
+                                               });
+      if (after_from != start)
+      {
+        start = after_from - 1;
+      }
+    }
+
+    auto end = start + 1;
+    while (end != boot_end && (!window.has_phase || end->phase == window.phase) &&
+      (!window.has_time || end->us_since_boot <= window.to_us))
+    {
+      ++end;
+    }
+
+    start_entry = start - entries.begin();
+    end_entry = end - entries.begin();
+    return true;
+  }
+}
+
+int main(const int argc, char** argv)
+{
+  std::vector<const char*> log_paths;
+  const char* csv_path = nullptr;
+  const char* columns_path = nullptr;
+  bool should_print_messages = false;
+  ExportWindow window;
+  std::vector<std::string> selected_variables;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--messages") == 0)
+    {
+      should_print_messages = true;
+    }
+    else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+    {
+      csv_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc)
+    {
+      columns_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--boot") == 0 && i + 1 < argc)
+    {
+      window.has_boot = true;
+      window.boot = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    }
+    else if (strcmp(argv[i], "--phase") == 0 && i + 1 < argc)
+    {
+      window.has_phase = true;
+      window.phase = static_cast<uint8_t>(strtoul(argv[++i], nullptr, 10));
+    }
+    else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc)
+    {
+      window.has_time = true;
+      window.from_us = static_cast<uint64_t>(strtod(argv[++i], nullptr) * 1e6);
+    }
+    else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc)
+    {
+      window.has_time = true;
+      window.to_us = static_cast<uint64_t>(strtod(argv[++i], nullptr) * 1e6);
+    }
+    else if (strcmp(argv[i], "--vars") == 0 && i + 1 < argc)
+    {
+      selected_variables = split_names(argv[++i]);
+    }
+    else if (strncmp(argv[i], "--", 2) != 0)
+    {
+      log_paths.push_back(argv[i]);
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (log_paths.empty())
+  {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // The index of every segment as one, boots carry over from one segment into the next
+  std::vector<LogIndexEntry> index_entries;
+  std::vector<size_t> index_entry_files;
+  bool has_index = true;
+  for (size_t file_idx = 0; file_idx < log_paths.size(); file_idx++)
+  {
+    LogReader reader;
+    if (!reader.open(log_paths[file_idx]))
+    {
+      fprintf(stderr, "%s\n", reader.get_error().c_str());
+      return EXIT_FAILURE;
+    }
+
+    // The segment after the last one written to is often already preallocated, there's nothing in it to index
+    std::vector<LogIndexEntry> file_entries;
+    const bool is_empty = reader.get_size() <= sizeof(uint64_t);
+    has_index = (is_empty || reader.read_index(file_entries)) && has_index;
+    for (LogIndexEntry& entry : file_entries)
+    {
+      entry.boot = index_entries.empty() ? 0 : index_entries.back().boot + (entry.seq < index_entries.back().seq);
+      index_entries.push_back(entry);
+      index_entry_files.push_back(file_idx);
+    }
+  }
+
+  size_t start_entry = 0, end_entry = 0;
+  if (window.is_set())
+  {
+    if (!has_index)
+    {
+      fprintf(stderr, "Not every log has an index, export all of them instead\n");
+      return EXIT_FAILURE;
+    }
+
+    if (!find_window(index_entries, window, start_entry, end_entry))
+    {
+      fprintf(stderr, "Nothing in the log matches\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<std::unique_ptr<LogExporter>> exporters;
+  std::vector<FILE*> files;
+  for (const auto& [path, is_csv] : {std::pair{csv_path, true}, std::pair{columns_path, false}})
+  {
+    if (!path)
+    {
+      continue;
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+      fprintf(stderr, "Could not open %s\n", path);
+      return EXIT_FAILURE;
+    }
+
+    files.push_back(file);
+    exporters.push_back(is_csv
+                          ? std::unique_ptr<LogExporter>(new CsvExporter(file))
+                          : std::unique_ptr<LogExporter>(new ColumnExporter(file)));
+  }
+
+  ExportSummary summary;
+  std::string error;
+  LogMetadata first_metadata;
+  bool did_begin = false;
+
+  // A phase change is logged right after the state that caused it, so each row is held until the next packet in case
+  // it needs the new phase
+  ExportRow row{};
+  ExportRow pending_row{};
+  std::span<const uint8_t> pending_state;
+  uint64_t pending_us_since_boot = 0;
+  bool has_pending_row = false;
+
+  // The phase change can be in the next segment, which means the state has to outlive its segment being unmapped
+  std::vector<uint8_t> carried_state;
+
+  const auto flush_pending_row = [&]
+  {
+    if (!has_pending_row)
+    {
+      return true;
+    }
+
+    has_pending_row = false;
+    if (window.is_set() && !window.contains(pending_row, pending_us_since_boot))
+    {
+      return true;
+    }
+
+    for (const std::unique_ptr<LogExporter>& exporter : exporters)
+    {
+      if (!exporter->add_row(pending_row, pending_state, error))
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  const auto begin_exporters = [&](const LogMetadata& metadata)
+  {
+    first_metadata = metadata;
+    did_begin = true;
+
+    // Exporters only see the variables that were asked for
+    LogMetadata exported_metadata = first_metadata;
+    if (!selected_variables.empty())
+    {
+      exported_metadata.variables.clear();
+      for (const std::string& name : selected_variables)
+      {
+        const LoggedVariable* variable = first_metadata.find_variable(name);
+        if (!variable)
+        {
+          error = "No variable named " + name;
+          return;
+        }
+        exported_metadata.variables.push_back(*variable);
+      }
+    }
+
+    for (const std::unique_ptr<LogExporter>& exporter : exporters)
+    {
+      if (!exporter->begin(exported_metadata, error))
+      {
+        return;
+      }
+    }
+  };
+
+  const auto start_time = std::chrono::steady_clock::now();
+
+  const size_t first_file = window.is_set() ? index_entry_files[start_entry] : 0;
+  const size_t last_file = window.is_set() && end_entry < index_entries.size()
+                             ? index_entry_files[end_entry]
+                             : log_paths.size() - 1;
+  size_t decoded_bytes = 0;
+  bool is_window_done = false;
+
+  for (size_t file_idx = first_file; file_idx <= last_file && error.empty() && !is_window_done; file_idx++)
+  {
+    LogReader reader;
+    if (!reader.open(log_paths[file_idx]))
+    {
+      error = reader.get_error();
+      break;
+    }
+
+    reader.select_variables(selected_variables);
+    if (window.has_time)
+    {
+      reader.set_time_range(window.from_us, window.to_us);
+    }
+
+    size_t start_offset = 0;
+    if (window.is_set() && file_idx == first_file)
+    {
+      const LogIndexEntry& start = index_entries[start_entry];
+      start_offset = start.offset;
+      if (!reader.seek(start_offset))
+      {
+        error = reader.get_error();
+        break;
+      }
+
+      begin_exporters(reader.get_metadata());
+      row = {start.boot, start.phase, start.faults};
+    }
+
+    std::vector<LogIndexEntry> file_entries;
+    const bool has_file_index = reader.read_index(file_entries);
+    const size_t end_offset = window.is_set() && file_idx == last_file && end_entry < index_entries.size()
+                                ? index_entries[end_entry].offset
+                                : SIZE_MAX;
+
+    LogPacket packet;
+    size_t packet_offset = reader.get_position();
+    while (error.empty() && reader.read_packet(packet))
+    {
+      summary.packets++;
+
+      if (const auto* state_update = std::get_if<StateUpdatePacket>(&packet))
+      {
+        if (!flush_pending_row())
+        {
+          break;
+        }
+
+        // Past the window, anything between the last state and here (like the phase change it caused) was still needed
+        if (packet_offset >= end_offset)
+        {
+          is_window_done = true;
+          break;
+        }
+        packet_offset = reader.get_position();
+
+        summary.states++;
+        pending_row = row;
+        pending_state = state_update->data;
+        pending_us_since_boot = state_update->us_since_boot;
+        has_pending_row = true;
+        continue;
+      }
+      packet_offset = reader.get_position();
+
+      if (const auto* phase_changed = std::get_if<PhaseChangedPacket>(&packet))
+      {
+        summary.phase_changes++;
+        row.phase = phase_changed->phase;
+        pending_row.phase = phase_changed->phase;
+      }
+      else if (const auto* faults_changed = std::get_if<FaultsChangedPacket>(&packet))
+      {
+        summary.fault_changes++;
+        row.faults = faults_changed->faults;
+      }
+      else if (std::holds_alternative<DeviceRestartPacket>(packet))
+      {
+        summary.restarts++;
+        row.boot++;
+
+        // Nothing about the flight carries over a restart, the phase and faults start where they did at boot
+        row.phase = first_metadata.initial_phase;
+        row.faults = first_metadata.initial_faults;
+      }
+      else if (const auto* log_message = std::get_if<LogMessagePacket>(&packet))
+      {
+        summary.messages++;
+        if (should_print_messages)
+        {
+          printf("[boot %u] %s\n", row.boot, log_message->message.c_str());
+        }
+      }
+      else if (const auto* metadata_packet = std::get_if<MetadataPacket>(&packet))
+      {
+        if (did_begin)
+        {
+          // Every segment starts with the metadata, and the same launch name can be used again, both are fine as long
+          // as the states didn't change
+          if (!is_same_layout(first_metadata, metadata_packet->metadata))
+          {
+            error = "State layout changes at " + std::to_string(reader.get_position()) + " in " +
+              log_paths[file_idx] + ", only what's before it was exported";
+          }
+          continue;
+        }
+
+        begin_exporters(metadata_packet->metadata);
+        row.phase = first_metadata.initial_phase;
+        row.faults = first_metadata.initial_faults;
+
+        // The metadata is from when the device booted, a later segment's own index knows the phase it started in
+        if (has_file_index && !file_entries.empty())
+        {
+          row.phase = file_entries.front().phase;
+          row.faults = file_entries.front().faults;
+        }
+      }
+
+      if (!flush_pending_row())
+      {
+        break;
+      }
+    }
+
+    if (has_pending_row)
+    {
+      carried_state.assign(pending_state.begin(), pending_state.end());
+      pending_state = carried_state;
+    }
+
+    const size_t decoded_end = reader.is_truncated() ? reader.get_truncated_position() : reader.get_position();
+    decoded_bytes += decoded_end - start_offset;
+
+    if (reader.is_truncated())
+    {
+      printf("%s ends part way through a packet, the last %zu bytes were skipped\n", log_paths[file_idx],
+             reader.get_size() - reader.get_truncated_position());
+    }
+    else if (!reader.get_error().empty() && error.empty())
+    {
+      error = reader.get_error() + " in " + log_paths[file_idx];
+    }
+  }
+
+  if (error.empty())
+  {
+    flush_pending_row();
+  }
+
+  for (const std::unique_ptr<LogExporter>& exporter : exporters)
+  {
+    if (did_begin && error.empty())
+    {
+      exporter->finish(error);
+    }
+  }
+  for (FILE* file : files)
+  {
+    fclose(file);
+  }
+
+  const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  const double decoded_mb = static_cast<double>(decoded_bytes) / 1e6;
+
+  printf("%s%s: %s\n", log_paths.front(), log_paths.size() > 1 ? " (and later segments)" : "",
+         first_metadata.application_name.empty() ? "(no metadata)" : first_metadata.application_name.c_str());
+  printf("  %llu packets, %llu states, %llu restarts, %llu messages, %llu phase changes, %llu fault changes\n",
+         static_cast<unsigned long long>(summary.packets), static_cast<unsigned long long>(summary.states),
+         static_cast<unsigned long long>(summary.restarts), static_cast<unsigned long long>(summary.messages),
+         static_cast<unsigned long long>(summary.phase_changes),
+         static_cast<unsigned long long>(summary.fault_changes));
+  printf("  %.2f MB in %.3f s (%.0f MB/s)\n", decoded_mb, elapsed_s, elapsed_s > 0 ? decoded_mb / elapsed_s : 0.0);
+  if (has_index)
+  {
+    printf("  Indexed, %zu entries over %u boots\n", index_entries.size(),
+           index_entries.empty() ? 0 : index_entries.back().boot + 1);
+  }
+
+  if (!error.empty())
+  {
+    fprintf(stderr, "%s\n", error.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,198 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "log_commit.h"
+#include "log_index.h"
+#include "output_packet.h"
+#include "segment_block_writer.h"
+
+using namespace elijah_state_framework;
+
+namespace
+{
+  void print_usage(const char* program_name)
+  {
+    fprintf(stderr, "Usage: %s <card image or device> [--out <dir>] [--list]\n"
+            "  Finds every log segment on the card by its blocks, without going through the file system, and writes\n"
+            "  each one out as <out>/<key>.NNN. Segments from the same boot share a key and are numbered in the\n"
+            "  order they're on the card, pass them to elijah-log_export in that order.\n"
+            "  --out   Directory segments are written to (default: current directory)\n"
+            "  --list  Only list the segments that were found\n", program_name);
+  }
+
+  // Just past the last complete record of the segment starting at segment_start, 0 if it doesn't start like one
+  uint64_t find_segment_end(const uint8_t* image, const uint64_t image_size, const uint64_t segment_start,
+                            const uint32_t key, uint64_t& record_count)
+  {
+    uint64_t pos = sizeof(uint64_t);
+    record_count = 0;
+    while (image_size - segment_start - pos >= internal::LOG_COMMIT_HEADER_SIZE)
+    {
+      const uint8_t* record = image + segment_start + pos;
+      if (record[0] != static_cast<uint8_t>(internal::OutputPacket::CommitRecord))
+      {
+        break;
+      }
+
+      uint32_t record_len, record_crc;
+      memcpy(&record_len, record + 1, sizeof(record_len));
+      memcpy(&record_crc, record + 1 + sizeof(record_len), sizeof(record_crc));
+      if (record_len > image_size - segment_start - pos - internal::LOG_COMMIT_HEADER_SIZE ||
+        internal::crc32(key, record + internal::LOG_COMMIT_HEADER_SIZE, record_len) != record_crc)
+      {
+        break;
+      }
+
+      // Every segment starts with the metadata
+      if (record_count == 0 && (record_len == 0 || record[internal::LOG_COMMIT_HEADER_SIZE] !=
+        static_cast<uint8_t>(internal::OutputPacket::Metadata)))
+      {
+        break;
+      }
+
+      pos += internal::LOG_COMMIT_HEADER_SIZE + record_len;
+      record_count++;
+    }
+
+    return record_count > 0 ? pos : 0;
+  }
+
+  bool write_segment(const std::string& path, const uint8_t* segment, const uint64_t end, const uint32_t key,
+                     const uint64_t available)
+  {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+      return false;
+    }
+
+    // The header on the card can be behind the records, point it at the end that was found
+    const uint64_t header = internal::make_segment_header(end, key);
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+      fwrite(segment + sizeof(header), 1, end - sizeof(header), file) == end - sizeof(header);
+
+    // Keep the index trailer if the last flush got it out
+    uint64_t trailer[2];
+    if (available - end >= sizeof(trailer))
+    {
+      memcpy(trailer, segment + end, sizeof(trailer));
+      if (trailer[1] == internal::LOG_INDEX_TRAILER_TAG)
+      {
+        success = success && fwrite(trailer, sizeof(trailer), 1, file) == 1;
+      }
+    }
+
+    return fclose(file) == 0 && success;
+  }
+}
+
+int main(const int argc, char** argv)
+{
+  const char* image_path = nullptr;
+  std::string out_dir = ".";
+  bool should_only_list = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+    {
+      out_dir = argv[++i];
+    }
+    else if (strcmp(argv[i], "--list") == 0)
+    {
+      should_only_list = true;
+    }
+    else if (strncmp(argv[i], "--", 2) != 0 && !image_path)
+    {
+      image_path = argv[i];
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!image_path)
+  {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int fd = open(image_path, O_RDONLY);
+  if (fd < 0)
+  {
+    fprintf(stderr, "Could not open %s\n", image_path);
+    return EXIT_FAILURE;
+  }
+
+  // A block device's size only comes from seeking to its end
+  const off_t image_end = lseek(fd, 0, SEEK_END);
+  if (image_end <= 0)
+  {
+    close(fd);
+    fprintf(stderr, "%s is empty\n", image_path);
+    return EXIT_FAILURE;
+  }
+
+  const auto image_size = static_cast<uint64_t>(image_end);
+  void* mapping = mmap(nullptr, image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    fprintf(stderr, "Could not map %s\n", image_path);
+    return EXIT_FAILURE;
+  }
+  madvise(mapping, image_size, MADV_SEQUENTIAL);
+  const auto image = static_cast<const uint8_t*>(mapping);
+
+  // Segments always start on a block, since FatFS gives them whole clusters
+  std::map<uint32_t, uint32_t> segment_counts;
+  uint64_t found_count = 0;
+  bool success = true;
+  for (uint64_t block_pos = 0; block_pos + SD_BLOCK_SIZE <= image_size;)
+  {
+    uint64_t header;
+    memcpy(&header, image + block_pos, sizeof(header));
+    const uint32_t key = internal::get_segment_header_key(header);
+
+    uint64_t record_count = 0;
+    const uint64_t end = key != 0 && image[block_pos + sizeof(header)] ==
+                         static_cast<uint8_t>(internal::OutputPacket::CommitRecord)
+                           ? find_segment_end(image, image_size, block_pos, key, record_count)
+                           : 0;
+    if (end == 0)
+    {
+      block_pos += SD_BLOCK_SIZE;
+      continue;
+    }
+
+    const uint32_t segment = segment_counts[key]++;
+    char file_name[32];
+    snprintf(file_name, sizeof(file_name), "%08x.%03u", static_cast<unsigned>(key), static_cast<unsigned>(segment));
+    printf("%s at block %llu, %llu bytes in %llu records\n", file_name,
+           static_cast<unsigned long long>(block_pos / SD_BLOCK_SIZE), static_cast<unsigned long long>(end),
+           static_cast<unsigned long long>(record_count));
+
+    if (!should_only_list && !write_segment(out_dir + "/" + file_name, image + block_pos, end, key,
+                                            image_size - block_pos))
+    {
+      fprintf(stderr, "Failed to write %s\n", file_name);
+      success = false;
+    }
+
+    found_count++;
+    block_pos += (end + SD_BLOCK_SIZE - 1) / SD_BLOCK_SIZE * SD_BLOCK_SIZE;
+  }
+
+  munmap(mapping, image_size);
+  printf("Found %llu segments\n", static_cast<unsigned long long>(found_count));
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
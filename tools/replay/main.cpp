@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <ff.h>
+#include <pico/stdio.h>
+
+#include "log_reader.h"
+#include "replay_engine.h"
+#include "replay_state_manager.h"
+
+using namespace elijah_state_framework::log_reader;
+
+namespace
+{
+  void print_usage(const char* program_name)
+  {
+    fprintf(stderr, "Usage: %s <log file> [--out <dir>] [--usb <file>] [--pre-trigger <samples>]\n"
+            "  --out          Directory the replayed log is written to (default: current directory)\n"
+            "  --usb          File the replayed USB output is written to (default: none)\n"
+            "  --pre-trigger  Pre-trigger buffer size in samples (default: 0)\n", program_name);
+  }
+
+  void print_phase_changes(const ReplayResult& result)
+  {
+    const ReplayFlightPhaseController phase_controller;
+
+    printf("\nPhase changes (replayed vs. logged):\n");
+    for (const ReplayPhaseChange& replayed : result.replayed_phase_changes)
+    {
+      const std::string phase_name = phase_controller.get_phase_name(static_cast<StandardFlightPhase>(replayed.phase));
+      printf("  %-10s seq %8llu  t %10.3f s", phase_name.c_str(), static_cast<unsigned long long>(replayed.seq),
+             static_cast<double>(replayed.us_since_boot) / 1e6);
+
+      const ReplayPhaseChange* logged = nullptr;
+      for (const ReplayPhaseChange& logged_change : result.logged_phase_changes)
+      {
+        if (logged_change.phase == replayed.phase)
+        {
+          logged = &logged_change;
+          break;
+        }
+      }
+
+      if (logged && !(replayed.is_full_rate && logged->is_full_rate))
+      {
+        // One of them ran on decimated states, the difference wouldn't mean anything
+        printf("  logged at seq %8llu  (not at full rate, not compared)\n",
+               static_cast<unsigned long long>(logged->seq));
+      }
+      else if (logged)
+      {
+        const double latency_ms = (static_cast<double>(replayed.us_since_boot) - static_cast<double>(logged->
+          us_since_boot)) / 1e3;
+        printf("  logged at seq %8llu  (%+.1f ms)\n", static_cast<unsigned long long>(logged->seq), latency_ms);
+      }
+      else
+      {
+        printf("  not in log\n");
+      }
+    }
+
+    for (const ReplayPhaseChange& logged : result.logged_phase_changes)
+    {
+      bool was_replayed = false;
+      for (const ReplayPhaseChange& replayed : result.replayed_phase_changes)
+      {
+        was_replayed |= replayed.phase == logged.phase;
+      }
+
+      if (!was_replayed)
+      {
+        const std::string phase_name = phase_controller.get_phase_name(static_cast<StandardFlightPhase>(logged.phase));
+        printf("  %-10s only in log, seq %llu\n", phase_name.c_str(), static_cast<unsigned long long>(logged.seq));
+      }
+    }
+  }
+}
+
+int main(const int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const char* log_path = argv[1];
+  const char* out_dir = ".";
+  const char* usb_path = nullptr;
+  size_t pre_trigger_size = 0;
+  for (int i = 2; i < argc; i++)
+  {
+    if (i + 1 >= argc)
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    if (strcmp(argv[i], "--out") == 0)
+    {
+      out_dir = argv[++i];
+    }
+    else if (strcmp(argv[i], "--usb") == 0)
+    {
+      usb_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--pre-trigger") == 0)
+    {
+      pre_trigger_size = strtoul(argv[++i], nullptr, 10);
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  LogReader reader;
+  if (!reader.open(log_path))
+  {
+    fprintf(stderr, "%s\n", reader.get_error().c_str());
+    return EXIT_FAILURE;
+  }
+
+  host_fatfs_set_root(out_dir);
+  int usb_fd = -1;
+  if (usb_path)
+  {
+    usb_fd = open(usb_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (usb_fd < 0)
+    {
+      fprintf(stderr, "Could not open %s\n", usb_path);
+      return EXIT_FAILURE;
+    }
+    host_stdio_set_fds(-1, usb_fd);
+  }
+
+  auto* state_manager = new ReplayStateManager(pre_trigger_size);
+  ReplayStateDecoder decoder;
+  ReplayEngine<ReplayStateManager, ReplayState, ReplayStateDecoder> replay_engine(state_manager, &decoder);
+
+  const ReplayResult result = replay_engine.replay(reader);
+  state_manager->check_for_log_write();
+  delete state_manager;
+
+  if (usb_fd >= 0)
+  {
+    host_stdio_set_fds(-1, -1);
+    close(usb_fd);
+  }
+
+  printf("Replayed %zu states in %.3f s (%.0f states/s)\n", result.state_count, result.elapsed_s,
+         result.states_per_second);
+  if (result.gap_count > 0)
+  {
+    printf("%zu gaps in the log (decimated or lost), %llu states missing, longest %.3f s\n", result.gap_count,
+           static_cast<unsigned long long>(result.missing_state_count),
+           static_cast<double>(result.longest_gap_us) / 1e6);
+  }
+  if (result.out_of_order_count > 0)
+  {
+    fprintf(stderr, "%zu states went back in sequence or time and weren't replayed, the first was seq %llu after %llu\n",
+            result.out_of_order_count, static_cast<unsigned long long>(result.first_out_of_order_seq),
+            static_cast<unsigned long long>(result.first_out_of_order_after_seq));
+  }
+  print_phase_changes(result);
+
+  if (!result.replayed_fault_changes.empty())
+  {
+    printf("\nFault changes:\n");
+    for (const ReplayFaultChange& fault_change : result.replayed_fault_changes)
+    {
+      printf("  seq %8llu  faults 0x%08x\n", static_cast<unsigned long long>(fault_change.seq), fault_change.faults);
+    }
+  }
+
+  if (!result.error.empty())
+  {
+    fprintf(stderr, "\nStopped early: %s\n", result.error.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
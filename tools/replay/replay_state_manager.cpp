@@ -0,0 +1,61 @@
+#include "replay_state_manager.h"
+
+void ReplayFlightPhaseController::extract_state_data(const ReplayState state, double& accel_x, double& accel_y,
+                                                     double& accel_z, double& altitude) const
+{
+  accel_x = state.accel_x;
+  accel_y = state.accel_y;
+  accel_z = state.accel_z;
+  altitude = state.altitude;
+}
+
+ReplayStateManager::ReplayStateManager(const size_t pre_trigger_buffer_size) : ElijahStateFramework(
+  "Replay", ReplayPersistentDataKey::LaunchKey, ReplayFaultKey::MicroSD, 10, pre_trigger_buffer_size)
+{
+  get_persistent_data_storage()->finish_registration();
+
+  register_fault(ReplayFaultKey::MicroSD, "MicroSD", CommunicationChannel::SPI_0);
+
+  finish_construction();
+}
+
+bool ReplayStateDecoder::load_metadata(const elijah_state_framework::log_reader::LogMetadata& metadata)
+{
+  this->metadata = metadata;
+
+  pressure = this->metadata.find_variable("Pressure");
+  temperature = this->metadata.find_variable("Temperature");
+  altitude = this->metadata.find_variable("Altitude");
+  accel_x = this->metadata.find_variable("Acceleration X");
+  accel_y = this->metadata.find_variable("Acceleration Y");
+  accel_z = this->metadata.find_variable("Acceleration Z");
+  gyro_x = this->metadata.find_variable("Gyro X");
+  gyro_y = this->metadata.find_variable("Gyro Y");
+  gyro_z = this->metadata.find_variable("Gyro Z");
+  bat_voltage = this->metadata.find_variable("Voltage");
+  bat_percent = this->metadata.find_variable("Battery percentage");
+
+  // Phase detection can't work without these
+  return altitude && accel_x && accel_y && accel_z;
+}
+
+void ReplayStateDecoder::decode(const elijah_state_framework::log_reader::StateUpdatePacket& packet,
+                                ReplayState& state) const
+{
+  const auto read_var = [&packet](const elijah_state_framework::log_reader::LoggedVariable* variable)
+  {
+    return variable ? elijah_state_framework::log_reader::get_numeric_value(*variable, packet.data.data()) : 0.0;
+  };
+
+  state.pressure = static_cast<int32_t>(read_var(pressure));
+  state.temperature = read_var(temperature);
+  state.altitude = read_var(altitude);
+  state.accel_x = read_var(accel_x);
+  state.accel_y = read_var(accel_y);
+  state.accel_z = read_var(accel_z);
+  state.gyro_x = read_var(gyro_x);
+  state.gyro_y = read_var(gyro_y);
+  state.gyro_z = read_var(gyro_z);
+  state.bat_voltage = read_var(bat_voltage);
+  state.bat_percent = read_var(bat_percent);
+}
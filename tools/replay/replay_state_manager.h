@@ -0,0 +1,78 @@
+#pragma once
+
+#include "elijah_state_framework.h"
+#include "log_reader.h"
+#include "standard_flight_phase_controller.h"
+
+// The sensor data both the payload and the override log, which is everything the flight phase controller needs
+struct ReplayState
+{
+  int32_t pressure;
+  double temperature;
+  double altitude;
+  double accel_x, accel_y, accel_z;
+  double gyro_x, gyro_y, gyro_z;
+  double bat_voltage, bat_percent;
+};
+
+enum class ReplayPersistentDataKey : uint8_t
+{
+  LaunchKey = 1
+};
+
+enum class ReplayFaultKey : uint8_t
+{
+  MicroSD = 1
+};
+
+class ReplayFlightPhaseController final : public StandardFlightPhaseController<ReplayState>
+{
+  void extract_state_data(ReplayState state, double& accel_x, double& accel_y, double& accel_z,
+                          double& altitude) const override;
+};
+
+class ReplayStateManager final : public elijah_state_framework::ElijahStateFramework<
+    ReplayState, ReplayPersistentDataKey, ReplayFaultKey, StandardFlightPhase, ReplayFlightPhaseController>
+{
+public:
+  explicit ReplayStateManager(size_t pre_trigger_buffer_size = 0);
+
+protected:
+  START_STATE_ENCODER(ReplayState)
+    ENCODE_STATE(pressure, DataType::Int32, "Pressure", "Pa")
+    ENCODE_STATE(temperature, DataType::Double, "Temperature", "degC")
+    ENCODE_STATE(altitude, DataType::Double, "Altitude", "m")
+    ENCODE_STATE(accel_x, DataType::Double, "Acceleration X", "m/s^2")
+    ENCODE_STATE(accel_y, DataType::Double, "Acceleration Y", "m/s^2")
+    ENCODE_STATE(accel_z, DataType::Double, "Acceleration Z", "m/s^2")
+    ENCODE_STATE(gyro_x, DataType::Double, "Gyro X", "deg/s")
+    ENCODE_STATE(gyro_y, DataType::Double, "Gyro Y", "deg/s")
+    ENCODE_STATE(gyro_z, DataType::Double, "Gyro Z", "deg/s")
+    ENCODE_STATE(bat_voltage, DataType::Double, "Voltage", "V")
+    ENCODE_STATE(bat_percent, DataType::Double, "Battery percentage", "%")
+  END_STATE_ENCODER()
+};
+
+// Pulls a ReplayState out of a payload or override log by display name, anything the log doesn't have is left as 0
+class ReplayStateDecoder
+{
+public:
+  bool load_metadata(const elijah_state_framework::log_reader::LogMetadata& metadata);
+  void decode(const elijah_state_framework::log_reader::StateUpdatePacket& packet, ReplayState& state) const;
+
+private:
+  const elijah_state_framework::log_reader::LoggedVariable* pressure = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* temperature = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* altitude = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* accel_x = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* accel_y = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* accel_z = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* gyro_x = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* gyro_y = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* gyro_z = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* bat_voltage = nullptr;
+  const elijah_state_framework::log_reader::LoggedVariable* bat_percent = nullptr;
+
+  // The pointers above point into this
+  elijah_state_framework::log_reader::LogMetadata metadata;
+};
@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <ff.h>
+#include <pico/time.h>
+
+#include "bmp_280_sim.h"
+#include "host_i2c_device.h"
+#include "mpu_6050_sim.h"
+#include "sim_state_manager.h"
+#include "trajectory_profile.h"
+
+#define SIM_STARTUP_MAX_MS 100
+
+namespace
+{
+  struct SensorRun
+  {
+    const char* name;
+    SimFaultKey fault_key;
+    const sensor_sim::SimulatedI2CDevice* device;
+
+    bool was_faulted = false;
+    uint64_t fault_count = 0, recover_count = 0;
+  };
+
+  void print_usage(const char* program_name)
+  {
+    fprintf(stderr, "Usage: %s [--profile <csv>] [--rate <hz>] [--nak <p>] [--stuck <p>] [--disconnect-bmp <from>:<to>]\n"
+            "       [--disconnect-mpu <from>:<to>] [--seed <n>] [--out <dir>] [--no-calibrate]\n"
+            "       [--segment-size <bytes>] [--batch <n>] [--column-log]\n"
+            "  --profile         Trajectory CSV (time_s,altitude,accel_x..z,gyro_x..z), default is a simulated flight\n"
+            "  --rate            Main loop rate in Hz (default: 20)\n"
+            "  --nak             Chance of any I2C transfer being NAKed (default: 0)\n"
+            "  --stuck           Chance of a conversion getting stuck for 10 samples (default: 0)\n"
+            "  --disconnect-bmp  Seconds into the profile the BMP 280 is unplugged between\n"
+            "  --disconnect-mpu  Seconds into the profile the MPU 6050 is unplugged between\n"
+            "  --seed            Noise and fault seed (default: 1)\n"
+            "  --out             Directory the log is written to (default: current directory)\n"
+            "  --no-calibrate    Skip calibrating the MPU 6050 at the start of the profile\n"
+            "  --column-log      Log states in column blocks instead of a state at a time\n"
+            "  --segment-size    Size the log is split into segments at (default: %llu)\n"
+            "  --batch           States sent per StateBatch packet (default: 1, every state on its own)\n", program_name,
+            static_cast<unsigned long long>(LOG_SEGMENT_SIZE));
+  }
+
+  bool parse_window(const char* arg, double& from_s, double& to_s)
+  {
+    return sscanf(arg, "%lf:%lf", &from_s, &to_s) == 2 && to_s > from_s;
+  }
+
+  uint64_t to_us(const double s)
+  {
+    return static_cast<uint64_t>(std::llround(s * 1e6));
+  }
+}
+
+int main(const int argc, char** argv)
+{
+  const char* profile_path = nullptr;
+  const char* out_dir = ".";
+  double rate_hz = 20;
+  uint64_t log_segment_size = LOG_SEGMENT_SIZE;
+  size_t state_batch_size = 1;
+  sensor_sim::SimulatedBusFaults bus_faults;
+  double bmp_disconnect_from_s = 0, bmp_disconnect_to_s = 0;
+  double mpu_disconnect_from_s = 0, mpu_disconnect_to_s = 0;
+  uint32_t seed = 1;
+  bool should_calibrate = true;
+  auto log_layout = elijah_state_framework::LogLayout::Rows;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--no-calibrate") == 0)
+    {
+      should_calibrate = false;
+      continue;
+    }
+
+    if (strcmp(argv[i], "--column-log") == 0)
+    {
+      log_layout = elijah_state_framework::LogLayout::Columns;
+      continue;
+    }
+
+    if (i + 1 >= argc)
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    bool is_valid = true;
+    if (strcmp(argv[i], "--profile") == 0)
+    {
+      profile_path = argv[++i];
+    }
+    else if (strcmp(argv[i], "--rate") == 0)
+    {
+      rate_hz = strtod(argv[++i], nullptr);
+      is_valid = rate_hz > 0;
+    }
+    else if (strcmp(argv[i], "--nak") == 0)
+    {
+      bus_faults.nak_probability = strtod(argv[++i], nullptr);
+    }
+    else if (strcmp(argv[i], "--stuck") == 0)
+    {
+      bus_faults.stuck_probability = strtod(argv[++i], nullptr);
+    }
+    else if (strcmp(argv[i], "--disconnect-bmp") == 0)
+    {
+      is_valid = parse_window(argv[++i], bmp_disconnect_from_s, bmp_disconnect_to_s);
+    }
+    else if (strcmp(argv[i], "--disconnect-mpu") == 0)
+    {
+      is_valid = parse_window(argv[++i], mpu_disconnect_from_s, mpu_disconnect_to_s);
+    }
+    else if (strcmp(argv[i], "--seed") == 0)
+    {
+      seed = strtoul(argv[++i], nullptr, 10);
+    }
+    else if (strcmp(argv[i], "--segment-size") == 0)
+    {
+      log_segment_size = strtoull(argv[++i], nullptr, 10);
+      is_valid = log_segment_size > 0;
+    }
+    else if (strcmp(argv[i], "--out") == 0)
+    {
+      out_dir = argv[++i];
+    }
+    else if (strcmp(argv[i], "--batch") == 0)
+    {
+      state_batch_size = strtoul(argv[++i], nullptr, 10);
+      is_valid = state_batch_size > 0 && state_batch_size <= UINT8_MAX;
+    }
+    else
+    {
+      is_valid = false;
+    }
+
+    if (!is_valid)
+    {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  sensor_sim::TrajectoryProfile profile = sensor_sim::TrajectoryProfile::simulated_flight();
+  if (profile_path)
+  {
+    std::string error;
+    if (!sensor_sim::TrajectoryProfile::load_csv(profile_path, profile, error))
+    {
+      fprintf(stderr, "%s\n", error.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Profile time and the shim clock are the same, so the sensors see the profile at whatever time the drivers read
+  const uint64_t start_us = to_us(profile.get_start_s());
+  const uint64_t end_us = to_us(profile.get_end_s());
+  host_time_set_manual(true);
+  host_time_set_us(start_us);
+  host_fatfs_set_root(out_dir);
+
+  sensor_sim::BMP280Sim bmp_sim(&profile, seed);
+  sensor_sim::MPU6050Sim mpu_sim(&profile, seed + 1);
+  bmp_sim.set_faults(bus_faults);
+  mpu_sim.set_faults(bus_faults);
+
+  if (bmp_disconnect_to_s > bmp_disconnect_from_s)
+  {
+    bmp_sim.disconnect_between(to_us(bmp_disconnect_from_s), to_us(bmp_disconnect_to_s));
+  }
+  if (mpu_disconnect_to_s > mpu_disconnect_from_s)
+  {
+    mpu_sim.disconnect_between(to_us(mpu_disconnect_from_s), to_us(mpu_disconnect_to_s));
+  }
+
+  host_i2c_attach(i2c0, SIM_BMP_280_ADDR, &bmp_sim);
+  host_i2c_attach(i2c1, MPU_6050_ADDR, &mpu_sim);
+
+  auto* state_manager = new SimStateManager(log_segment_size);
+  state_manager->set_state_batch_size(state_batch_size);
+  state_manager->set_log_layout(log_layout);
+  auto* bmp280 = new SimReliableBMP280(state_manager);
+  auto* mpu6050 = new SimReliableMPU6050(state_manager);
+
+  // Nothing has been converted when the chips first start, wait for them to come up before the first state goes out
+  SimState state{};
+  for (int i = 0; i < SIM_STARTUP_MAX_MS; i++)
+  {
+    bmp280->update(state);
+    mpu6050->update(state);
+    if (!state_manager->is_faulted(SimFaultKey::BMP280) && !state_manager->is_faulted(SimFaultKey::MPU6050))
+    {
+      break;
+    }
+    host_time_advance_us(1000);
+  }
+
+  if (should_calibrate)
+  {
+    // The same calibration the payload and override do on the pad
+    mpu6050->calibrate(MPU_6050_CALIBRATION_CYCLES, 0, -GRAVITY_CONSTANT, 0, 0, 0, 0);
+  }
+
+  SensorRun sensor_runs[] = {
+    {"BMP 280", SimFaultKey::BMP280, &bmp_sim},
+    {"MPU 6050", SimFaultKey::MPU6050, &mpu_sim}
+  };
+
+  const auto loop_period_us = static_cast<uint64_t>(1e6 / rate_hz);
+  StandardFlightPhase last_phase = state_manager->get_current_flight_phase();
+  double max_altitude = -INFINITY, altitude_error_sq = 0;
+  size_t sample_count = 0, altitude_sample_count = 0;
+
+  const auto wall_start = std::chrono::steady_clock::now();
+  for (uint64_t loop_us = time_us_64(); loop_us <= end_us; loop_us += loop_period_us)
+  {
+    host_time_set_us(loop_us);
+
+    bmp280->update(state);
+    mpu6050->update(state);
+    state_manager->state_changed(state);
+    state_manager->check_for_log_write();
+    sample_count++;
+
+    for (SensorRun& run : sensor_runs)
+    {
+      const bool is_faulted = state_manager->is_faulted(run.fault_key);
+      if (is_faulted != run.was_faulted)
+      {
+        (is_faulted ? run.fault_count : run.recover_count)++;
+        run.was_faulted = is_faulted;
+      }
+    }
+
+    if (!sensor_runs[0].was_faulted)
+    {
+      const double altitude_error = state.altitude - profile.sample(static_cast<double>(loop_us) / 1e6).altitude;
+      altitude_error_sq += altitude_error * altitude_error;
+      altitude_sample_count++;
+      max_altitude = std::max(max_altitude, state.altitude);
+    }
+
+    const auto snapshot = state_manager->get_latest_snapshot();
+    if (snapshot.phase != last_phase)
+    {
+      printf("%-10s at %9.3f s, altitude %8.1f m, fused %8.1f m at %7.1f m/s, predicted apogee %7.1f m in %6.2f s, "
+             "landing in %6.1f s\n",
+             SimFlightPhaseController().get_phase_name(snapshot.phase).c_str(), static_cast<double>(loop_us) / 1e6,
+             state.altitude, snapshot.vertical.altitude, snapshot.vertical.velocity,
+             snapshot.prediction.apogee_altitude, snapshot.prediction.time_to_apogee,
+             snapshot.prediction.time_to_landing);
+      last_phase = snapshot.phase;
+    }
+  }
+  const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+  delete mpu6050;
+  delete bmp280;
+  delete state_manager;
+  host_i2c_detach(i2c0, SIM_BMP_280_ADDR);
+  host_i2c_detach(i2c1, MPU_6050_ADDR);
+
+  printf("\nSimulated %zu samples (%.1f s of profile) in %.3f s (%.0f samples/s)\n", sample_count,
+         static_cast<double>(end_us - start_us) / 1e6, elapsed_s, static_cast<double>(sample_count) / elapsed_s);
+  printf("Apogee %.1f m measured, %.1f m simulated, altitude RMS error %.2f m\n", max_altitude,
+         profile.get_max_altitude(), altitude_sample_count > 0
+                                       ? std::sqrt(altitude_error_sq / static_cast<double>(altitude_sample_count))
+                                       : 0.0);
+
+  printf("\n%-10s %10s %8s %12s %8s %8s %8s %11s\n", "Sensor", "Transfers", "NAKs", "Conversions", "Stuck", "Resets",
+         "Faults", "Recoveries");
+  for (const SensorRun& run : sensor_runs)
+  {
+    const sensor_sim::SimulatedDeviceStats& stats = run.device->get_stats();
+    printf("%-10s %10llu %8llu %12llu %8llu %8llu %8llu %11llu\n", run.name,
+           static_cast<unsigned long long>(stats.transfers), static_cast<unsigned long long>(stats.naks),
+           static_cast<unsigned long long>(stats.samples), static_cast<unsigned long long>(stats.stuck_samples),
+           static_cast<unsigned long long>(stats.resets), static_cast<unsigned long long>(run.fault_count),
+           static_cast<unsigned long long>(run.recover_count));
+  }
+
+  return EXIT_SUCCESS;
+}
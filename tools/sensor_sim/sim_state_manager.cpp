@@ -0,0 +1,62 @@
+#include "sim_state_manager.h"
+
+void SimFlightPhaseController::extract_state_data(const SimState state, double& accel_x, double& accel_y,
+                                                  double& accel_z, double& altitude) const
+{
+  accel_x = state.accel_x;
+  accel_y = state.accel_y;
+  accel_z = state.accel_z;
+  altitude = state.altitude;
+}
+
+SimStateManager::SimStateManager(const uint64_t log_segment_size) : ElijahStateFramework(
+  "Sensor Sim", SimPersistentDataKey::LaunchKey, SimFaultKey::MicroSD, 10, PRE_TRIGGER_SAMPLES, log_segment_size)
+{
+  get_persistent_data_storage()->register_key(SimPersistentDataKey::SeaLevelPressure, "Barometric pressure",
+                                              101325.0);
+  get_persistent_data_storage()->register_key(SimPersistentDataKey::AccelCalibX, "Accelerometer calibration X", 0.0);
+  get_persistent_data_storage()->register_key(SimPersistentDataKey::AccelCalibY, "Accelerometer calibration Y", 0.0);
+  get_persistent_data_storage()->register_key(SimPersistentDataKey::AccelCalibZ, "Accelerometer calibration Z", 0.0);
+  get_persistent_data_storage()->register_key(SimPersistentDataKey::GyroCalibX, "Gyroscope calibration X", 0.0);
+  get_persistent_data_storage()->register_key(SimPersistentDataKey::GyroCalibY, "Gyroscope calibration Y", 0.0);
+  get_persistent_data_storage()->register_key(SimPersistentDataKey::GyroCalibZ, "Gyroscope calibration Z", 0.0);
+  get_persistent_data_storage()->finish_registration();
+
+  register_fault(SimFaultKey::BMP280, "BMP 280", CommunicationChannel::I2C_0);
+  register_fault(SimFaultKey::MPU6050, "MPU 6050", CommunicationChannel::I2C_1);
+  register_fault(SimFaultKey::MicroSD, "MicroSD", CommunicationChannel::SPI_0);
+
+  finish_construction();
+}
+
+SimReliableBMP280::SimReliableBMP280(SimStateManager* state_manager) : ReliableBMP280(
+  state_manager, SimFaultKey::BMP280, i2c0, SIM_BMP_280_ADDR, SimPersistentDataKey::SeaLevelPressure)
+{
+}
+
+void SimReliableBMP280::update_state(SimState& state, const int32_t pressure, const double temperature,
+                                     const double altitude) const
+{
+  state.pressure = pressure;
+  state.temperature = temperature;
+  state.altitude = altitude;
+}
+
+SimReliableMPU6050::SimReliableMPU6050(SimStateManager* state_manager) : ReliableMPU6050(
+  state_manager, SimFaultKey::MPU6050, i2c1, MPU_6050_ADDR, MPU6050::GyroFullScaleRange::Range500,
+  MPU6050::AccelFullScaleRange::Range8g, SimPersistentDataKey::AccelCalibX, SimPersistentDataKey::AccelCalibY,
+  SimPersistentDataKey::AccelCalibZ, SimPersistentDataKey::GyroCalibX, SimPersistentDataKey::GyroCalibY,
+  SimPersistentDataKey::GyroCalibZ)
+{
+}
+
+void SimReliableMPU6050::update_state(SimState& state, const double xa, const double ya, const double za,
+                                      const double xg, const double yg, const double zg) const
+{
+  state.accel_x = xa;
+  state.accel_y = ya;
+  state.accel_z = za;
+  state.gyro_x = xg;
+  state.gyro_y = yg;
+  state.gyro_z = zg;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "elijah_state_framework.h"
+#include "reliable_bmp_280.h"
+#include "reliable_mpu_6050.h"
+#include "standard_flight_phase_controller.h"
+
+#define SIM_BMP_280_ADDR 0x76
+// Same as the payload and override, so the sim logs what they would
+#define PRE_TRIGGER_SAMPLES 100
+
+struct SimState
+{
+  int32_t pressure;
+  double temperature;
+  double altitude;
+  double accel_x, accel_y, accel_z;
+  double gyro_x, gyro_y, gyro_z;
+};
+
+enum class SimPersistentDataKey : uint8_t
+{
+  LaunchKey = 1,
+  SeaLevelPressure = 2,
+  AccelCalibX = 3,
+  AccelCalibY = 4,
+  AccelCalibZ = 5,
+  GyroCalibX = 6,
+  GyroCalibY = 7,
+  GyroCalibZ = 8
+};
+
+enum class SimFaultKey : uint8_t
+{
+  BMP280 = 1,
+  MPU6050 = 2,
+  MicroSD = 3
+};
+
+class SimFlightPhaseController final : public StandardFlightPhaseController<SimState>
+{
+  void extract_state_data(SimState state, double& accel_x, double& accel_y, double& accel_z,
+                          double& altitude) const override;
+};
+
+class SimStateManager final : public elijah_state_framework::ElijahStateFramework<
+    SimState, SimPersistentDataKey, SimFaultKey, StandardFlightPhase, SimFlightPhaseController>
+{
+public:
+  explicit SimStateManager(uint64_t log_segment_size = LOG_SEGMENT_SIZE);
+
+protected:
+  START_STATE_ENCODER(SimState)
+    ENCODE_STATE(pressure, DataType::Int32, "Pressure", "Pa")
+    ENCODE_STATE(temperature, DataType::Double, "Temperature", "degC")
+    ENCODE_STATE(altitude, DataType::Double, "Altitude", "m")
+    ENCODE_STATE(accel_x, DataType::Double, "Acceleration X", "m/s^2")
+    ENCODE_STATE(accel_y, DataType::Double, "Acceleration Y", "m/s^2")
+    ENCODE_STATE(accel_z, DataType::Double, "Acceleration Z", "m/s^2")
+    ENCODE_STATE(gyro_x, DataType::Double, "Gyro X", "deg/s")
+    ENCODE_STATE(gyro_y, DataType::Double, "Gyro Y", "deg/s")
+    ENCODE_STATE(gyro_z, DataType::Double, "Gyro Z", "deg/s")
+  END_STATE_ENCODER()
+};
+
+class SimReliableBMP280 final : public ReliableBMP280<
+    SimState, SimPersistentDataKey, SimFaultKey, StandardFlightPhase, SimFlightPhaseController>
+{
+public:
+  explicit SimReliableBMP280(SimStateManager* state_manager);
+
+protected:
+  void update_state(SimState& state, int32_t pressure, double temperature, double altitude) const override;
+};
+
+class SimReliableMPU6050 final : public ReliableMPU6050<
+    SimState, SimPersistentDataKey, SimFaultKey, StandardFlightPhase, SimFlightPhaseController>
+{
+public:
+  explicit SimReliableMPU6050(SimStateManager* state_manager);
+
+protected:
+  void update_state(SimState& state, double xa, double ya, double za, double xg, double yg,
+                    double zg) const override;
+};